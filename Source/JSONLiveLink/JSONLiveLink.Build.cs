@@ -29,5 +29,8 @@ public class JSONLiveLink : ModuleRules
 				"SlateCore",
 				"Sockets",
 			});
+
+		// Inflated directly rather than through FCompression, which has no way to pass a preset dictionary
+		AddEngineThirdPartyPrivateStaticDependencies(Target, "zlib");
 	}
 }
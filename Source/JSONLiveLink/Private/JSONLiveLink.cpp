@@ -1,18 +1,43 @@
 // Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
 
 #include "JSONLiveLink.h"
+#include "JSONLiveLinkDemultiplexer.h"
+#include "JSONLiveLinkReceiverService.h"
+#include "JSONLiveLinkSource.h"
 
 #define LOCTEXT_NAMESPACE "FJSONLiveLinkModule"
 
+DEFINE_LOG_CATEGORY(LogJSONLiveLink);
+
 void FJSONLiveLinkModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
+	ReceiverService = MakeUnique<FJSONLiveLinkReceiverService>();
 }
 
 void FJSONLiveLinkModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+	// Sources LiveLink still holds would keep receiving on threads running this module's code, they're shut down and their
+	// workers joined before the service goes
+	TArray<TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>> Demultiplexers;
+	ReceiverService->GetDemultiplexers(Demultiplexers);
+
+	TArray<FJSONLiveLinkSource*> Sources;
+	FJSONLiveLinkSource::GetLiveSources(Sources);
+	for (FJSONLiveLinkSource* Source : Sources)
+	{
+		Source->RequestSourceShutdown();
+	}
+
+	for (const TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>& Demultiplexer : Demultiplexers)
+	{
+		Demultiplexer->Join();
+	}
+	Demultiplexers.Reset();
+
+	ReceiverService.Reset();
 }
 
 #undef LOCTEXT_NAMESPACE
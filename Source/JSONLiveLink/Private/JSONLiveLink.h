@@ -5,6 +5,10 @@
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
 
+DECLARE_LOG_CATEGORY_EXTERN(LogJSONLiveLink, Log, All);
+
+class FJSONLiveLinkReceiverService;
+
 class FJSONLiveLinkModule : public IModuleInterface
 {
 public:
@@ -12,4 +16,13 @@ public:
 	/** IModuleInterface implementation */
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
+
+	static FJSONLiveLinkModule& Get() { return FModuleManager::GetModuleChecked<FJSONLiveLinkModule>("JSONLiveLink"); }
+
+	// Shares endpoints between the sources receiving on them
+	FJSONLiveLinkReceiverService& GetReceiverService() const { return *ReceiverService; }
+
+private:
+
+	TUniquePtr<FJSONLiveLinkReceiverService> ReceiverService;
 };
@@ -0,0 +1,101 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#include "JSONLiveLinkBackpressure.h"
+#include "JSONLiveLink.h"
+
+// Seconds the busy fraction is averaged over
+static const double BusyWindow = 0.1;
+
+// Seconds the load has to stay low before degrading stops
+static const double RecoveryTime = 1.0;
+
+FJSONLiveLinkBackpressure::FJSONLiveLinkBackpressure(const FJSONLiveLinkSourceSettings& Settings)
+: Policy(Settings.BackpressurePolicy)
+, QueueThreshold(FMath::Max(Settings.BackpressureQueueDepth, 1))
+, BusyThreshold(Settings.BackpressureBusyThreshold)
+, DecimateInterval(Settings.DecimateRate > 0.0f ? 1.0 / Settings.DecimateRate : 0.0)
+, BusyFraction(0.0f)
+, DecodeSeconds(0.0)
+, WindowStart(0.0)
+, LastOverloadTime(0.0)
+, bDegraded(false)
+{
+}
+
+void FJSONLiveLinkBackpressure::Update(double Now, int32 QueueDepth)
+{
+	if (Policy == EJSONLiveLinkBackpressurePolicy::None)
+	{
+		return;
+	}
+
+	if (Now - WindowStart >= BusyWindow)
+	{
+		// A thread that went idle for a while starts a fresh window instead of averaging the idle time in
+		BusyFraction = Now - WindowStart < 2.0 * BusyWindow ? (float)(DecodeSeconds / (Now - WindowStart)) : 0.0f;
+		DecodeSeconds = 0.0;
+		WindowStart = Now;
+	}
+
+	const bool bBusy = BusyThreshold > 0.0f && BusyFraction > BusyThreshold;
+	if (QueueDepth > QueueThreshold || bBusy)
+	{
+		LastOverloadTime.Store(Now, EMemoryOrder::Relaxed);
+		if (!bDegraded)
+		{
+			UE_LOG(LogJSONLiveLink, Verbose, TEXT("Falling behind with %d packets queued and %.0f%% busy decoding, degrading"), QueueDepth, BusyFraction * 100.0f);
+			bDegraded = true;
+		}
+		return;
+	}
+
+	// Hysteresis so degrading doesn't flicker on and off around the thresholds
+	const bool bRecovered = QueueDepth <= QueueThreshold / 2 && (BusyThreshold <= 0.0f || BusyFraction <= BusyThreshold * 0.5f);
+	if (!bRecovered)
+	{
+		LastOverloadTime.Store(Now, EMemoryOrder::Relaxed);
+	}
+	else if (bDegraded && Now - LastOverloadTime.Load(EMemoryOrder::Relaxed) >= RecoveryTime)
+	{
+		UE_LOG(LogJSONLiveLink, Verbose, TEXT("Caught up, no longer degrading"));
+		bDegraded = false;
+		LastDecodedTimes.Reset();
+	}
+}
+
+bool FJSONLiveLinkBackpressure::IsDegraded(double Now) const
+{
+	return bDegraded && Now - LastOverloadTime.Load(EMemoryOrder::Relaxed) < RecoveryTime;
+}
+
+bool FJSONLiveLinkBackpressure::ShouldShed(int32 QueueDepth, uint32 CoalesceKey, double ArrivalTime, bool bDependedOn)
+{
+	// Skipping a schema, keyframe or delta stalls its subject until the next one and makes it request a keyframe
+	if (!bDegraded || bDependedOn)
+	{
+		return false;
+	}
+
+	bool bShed = false;
+	if (Policy == EJSONLiveLinkBackpressurePolicy::DropOldest)
+	{
+		// Skip to where the backlog is back to half the threshold
+		bShed = QueueDepth > QueueThreshold / 2;
+	}
+	else if (Policy == EJSONLiveLinkBackpressurePolicy::Decimate && CoalesceKey != 0 && DecimateInterval > 0.0)
+	{
+		// Frames slightly early for the target rate are kept, so a sender at an exact multiple of it isn't decimated twice over
+		double* LastDecodedTime = LastDecodedTimes.Find(CoalesceKey);
+		bShed = LastDecodedTime != nullptr && ArrivalTime - *LastDecodedTime < DecimateInterval * 0.9;
+		if (!bShed)
+		{
+			LastDecodedTimes.Add(CoalesceKey, ArrivalTime);
+		}
+	}
+
+	if (bShed)
+	{
+		NumShed.Increment();
+	}
+	return bShed;
+}
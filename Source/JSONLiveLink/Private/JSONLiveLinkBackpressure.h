@@ -0,0 +1,71 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Templates/Atomic.h"
+#include "JSONLiveLinkSourceSettings.h"
+
+/**
+ * Decides when a worker degrades because it can't decode packets as fast as they arrive, and which packets it then skips.
+ * It degrades once more than BackpressureQueueDepth packets wait behind the one about to be decoded, or decoding takes
+ * more than BackpressureBusyThreshold of the decoding thread's time, and recovers once both have stayed at half of that
+ * for a second. Only the thread decoding the worker's packets updates it, the counters can be read from any thread.
+ */
+class FJSONLiveLinkBackpressure
+{
+public:
+
+	explicit FJSONLiveLinkBackpressure(const FJSONLiveLinkSourceSettings& Settings);
+
+	// Whether queued packets need their coalesce key for the policy
+	bool NeedsCoalesceKeys() const { return Policy == EJSONLiveLinkBackpressurePolicy::Coalesce || Policy == EJSONLiveLinkBackpressurePolicy::Decimate; }
+
+	// Called before each packet is decoded with how many are waiting behind it
+	void Update(double Now, int32 QueueDepth);
+
+	// Time spent decoding a packet
+	void AddDecodeTime(double Seconds) { DecodeSeconds += Seconds; }
+
+	bool IsDegraded() const { return bDegraded; }
+
+	// For readers on other threads: degrading only stops once a packet is decoded, a worker whose traffic stopped while
+	// degraded isn't falling behind anymore once it's been quiet for as long as recovering takes
+	bool IsDegraded(double Now) const;
+
+	// Whether superseded packets are skipped, see FJSONLiveLinkDecoder::GetCoalesceKey
+	bool IsCoalescing() const { return bDegraded && Policy == EJSONLiveLinkBackpressurePolicy::Coalesce; }
+
+	// While degraded, whether the drop oldest or decimate policy skips this packet. Counted as shed when it does. Packets
+	// others depend on are never skipped, see FJSONLiveLinkDecoder::IsDependedOnPacket.
+	bool ShouldShed(int32 QueueDepth, uint32 CoalesceKey, double ArrivalTime, bool bDependedOn);
+
+	EJSONLiveLinkBackpressurePolicy GetPolicy() const { return Policy; }
+
+	// Packets skipped by the drop oldest and decimate policies, the coalesce policy counts as coalesced frames
+	int32 GetNumShed() const { return NumShed.GetValue(); }
+
+private:
+
+	EJSONLiveLinkBackpressurePolicy Policy;
+	int32 QueueThreshold;
+	float BusyThreshold;
+	double DecimateInterval;
+
+	// Share of the last window spent decoding, and what's been decoded in the current one
+	float BusyFraction;
+	double DecodeSeconds;
+	double WindowStart;
+
+	// Last time the thresholds were exceeded
+	TAtomic<double> LastOverloadTime;
+
+	// Arrival time of the last packet decoded for each coalesce key, to decimate them
+	TMap<uint32, double> LastDecodedTimes;
+
+	FThreadSafeBool bDegraded;
+
+	FThreadSafeCounter NumShed;
+};
@@ -0,0 +1,264 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#include "JSONLiveLink.h"
+#include "JSONLiveLinkBinaryWriter.h"
+#include "JSONLiveLinkDecoder.h"
+#include "JSONLiveLinkJsonReader.h"
+#include "JSONLiveLinkProtocol.h"
+
+#include "LiveLinkTypes.h"
+#include "Roles/LiveLinkAnimationTypes.h"
+
+#include "HAL/IConsoleManager.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/AutomationTest.h"
+
+#if !UE_BUILD_SHIPPING
+
+namespace JSONLiveLinkBenchmark
+{
+	// Distinct frames per corpus, values change from frame to frame like a live stream
+	static const int32 NumFrames = 16;
+
+	struct FCorpus
+	{
+		FString Description;
+		int32 NumBones = 0;
+
+		// Binary corpora start with their schema packet, which is only decoded while warming up
+		TArray<TArray<uint8>> Packets;
+		bool bBinary = false;
+	};
+
+	static float FrameValue(int32 FrameIdx, int32 ValueIdx)
+	{
+		return FMath::Sin(FrameIdx * 0.1f + ValueIdx * 0.37f);
+	}
+
+	static TArray<uint8> MakeJsonPacket(int32 NumBones, int32 NumParameters, int32 FrameIdx)
+	{
+		FString Json = TEXT("{\"Subject\":{\"Bone\":[");
+		for (int32 BoneIdx = 0; BoneIdx < NumBones; ++BoneIdx)
+		{
+			const FQuat Rotation = FQuat(FRotator(FrameValue(FrameIdx, BoneIdx) * 90.0f, FrameValue(FrameIdx, BoneIdx + 1) * 90.0f, 0.0f));
+			Json += FString::Printf(TEXT("%s{\"Name\":\"bone_%d\",\"Parent\":%d,\"Location\":[%f,%f,%f],\"Rotation\":[%f,%f,%f,%f],\"Scale\":[1,1,1]}"),
+				BoneIdx > 0 ? TEXT(",") : TEXT(""), BoneIdx, BoneIdx - 1,
+				FrameValue(FrameIdx, 3 * BoneIdx), FrameValue(FrameIdx, 3 * BoneIdx + 1), FrameValue(FrameIdx, 3 * BoneIdx + 2),
+				Rotation.X, Rotation.Y, Rotation.Z, Rotation.W);
+		}
+		Json += TEXT("]");
+		if (NumParameters > 0)
+		{
+			Json += TEXT(",\"Parameter\":[");
+			for (int32 ParameterIdx = 0; ParameterIdx < NumParameters; ++ParameterIdx)
+			{
+				Json += FString::Printf(TEXT("%s{\"Name\":\"blendshape_%d\",\"Value\":%f}"), ParameterIdx > 0 ? TEXT(",") : TEXT(""), ParameterIdx, FMath::Abs(FrameValue(FrameIdx, ParameterIdx)));
+			}
+			Json += TEXT("]");
+		}
+		Json += TEXT("}}");
+
+		FTCHARToUTF8 Utf8(*Json);
+		return TArray<uint8>((const uint8*)Utf8.Get(), Utf8.Length());
+	}
+
+	static void WriteHeader(FJSONLiveLinkBinaryWriter& Writer, EJSONLiveLinkPacketType PacketType, EJSONLiveLinkPacketFlags Flags)
+	{
+		Writer.Write(JSONLiveLinkProtocol::BinaryMagic);
+		Writer.Write(JSONLiveLinkProtocol::BinaryVersion);
+		Writer.Write((uint8)PacketType);
+		Writer.Write((uint16)Flags);
+		Writer.Write((uint32)1); // SubjectId
+		Writer.Write((uint32)1); // SchemaId
+	}
+
+	static void MakeBinaryPackets(int32 NumBones, int32 NumParameters, TArray<TArray<uint8>>& OutPackets)
+	{
+		// Same static data as the JSON packets, head rotation included
+		TArray<uint8>& Schema = OutPackets.AddDefaulted_GetRef();
+		Schema.SetNumUninitialized(JSONLiveLinkProtocol::MaxDatagramSize);
+		FJSONLiveLinkBinaryWriter SchemaWriter(Schema.GetData(), Schema.Num());
+		WriteHeader(SchemaWriter, EJSONLiveLinkPacketType::Schema, NumParameters > 0 ? EJSONLiveLinkPacketFlags::HeadRotation : EJSONLiveLinkPacketFlags::None);
+		SchemaWriter.Write((uint16)NumBones);
+		SchemaWriter.Write((uint16)NumParameters);
+		SchemaWriter.WriteString(TEXT("Subject"));
+		for (int32 BoneIdx = 0; BoneIdx < NumBones; ++BoneIdx)
+		{
+			SchemaWriter.WriteString(FString::Printf(TEXT("bone_%d"), BoneIdx));
+			SchemaWriter.Write((int32)(BoneIdx - 1));
+		}
+		for (int32 ParameterIdx = 0; ParameterIdx < NumParameters; ++ParameterIdx)
+		{
+			SchemaWriter.WriteString(FString::Printf(TEXT("blendshape_%d"), ParameterIdx));
+		}
+		Schema.SetNum(SchemaWriter.GetPosition());
+
+		for (int32 FrameIdx = 0; FrameIdx < NumFrames; ++FrameIdx)
+		{
+			TArray<uint8>& Frame = OutPackets.AddDefaulted_GetRef();
+			Frame.SetNumUninitialized(JSONLiveLinkProtocol::MaxDatagramSize);
+			FJSONLiveLinkBinaryWriter Writer(Frame.GetData(), Frame.Num());
+			WriteHeader(Writer, EJSONLiveLinkPacketType::Frame, EJSONLiveLinkPacketFlags::None);
+			Writer.Write((uint16)NumBones);
+			Writer.Write((uint16)NumParameters);
+			for (int32 ValueIdx = 0; ValueIdx < 3 * NumBones; ++ValueIdx)
+			{
+				Writer.Write(FrameValue(FrameIdx, ValueIdx));
+			}
+			for (int32 BoneIdx = 0; BoneIdx < NumBones; ++BoneIdx)
+			{
+				const FQuat Rotation = FQuat(FRotator(FrameValue(FrameIdx, BoneIdx) * 90.0f, FrameValue(FrameIdx, BoneIdx + 1) * 90.0f, 0.0f));
+				Writer.Write(Rotation.X);
+				Writer.Write(Rotation.Y);
+				Writer.Write(Rotation.Z);
+				Writer.Write(Rotation.W);
+			}
+			for (int32 ValueIdx = 0; ValueIdx < 3 * NumBones; ++ValueIdx)
+			{
+				Writer.Write(1.0f);
+			}
+			for (int32 ParameterIdx = 0; ParameterIdx < NumParameters; ++ParameterIdx)
+			{
+				Writer.Write(FMath::Abs(FrameValue(FrameIdx, ParameterIdx)));
+			}
+			Frame.SetNum(Writer.GetPosition());
+		}
+	}
+
+	static void MakeCorpora(TArray<FCorpus>& OutCorpora)
+	{
+		const int32 Sizes[][2] = { { 5, 0 }, { 60, 0 }, { 200, 52 } };
+		for (const int32* Size : Sizes)
+		{
+			FCorpus& Json = OutCorpora.AddDefaulted_GetRef();
+			Json.Description = FString::Printf(TEXT("JSON %d bones + %d parameters"), Size[0], Size[1]);
+			Json.NumBones = Size[0];
+			for (int32 FrameIdx = 0; FrameIdx < NumFrames; ++FrameIdx)
+			{
+				Json.Packets.Add(MakeJsonPacket(Size[0], Size[1], FrameIdx));
+			}
+
+			FCorpus& Binary = OutCorpora.AddDefaulted_GetRef();
+			Binary.Description = FString::Printf(TEXT("Binary %d bones + %d parameters"), Size[0], Size[1]);
+			Binary.NumBones = Size[0];
+			Binary.bBinary = true;
+			MakeBinaryPackets(Size[0], Size[1], Binary.Packets);
+		}
+	}
+
+	// Same work as FJSONLiveLinkWorker::DecodeDatagram, minus pushing the frames
+	static int32 DecodePacket(FJSONLiveLinkDecoder& Decoder, const TArray<uint8>& Packet)
+	{
+		const uint8* Data = Packet.GetData();
+		const int32 Size = Packet.Num();
+		int32 NumDecoded = 0;
+
+		if (FJSONLiveLinkDecoder::IsBinaryPacket(Data, Size))
+		{
+			FName SubjectName;
+			uint32 SchemaHash;
+			FLiveLinkFrameDataStruct FrameDataStruct = FLiveLinkFrameDataStruct(FLiveLinkAnimationFrameData::StaticStruct());
+			NumDecoded += Decoder.DecodeBinary(Data, Size, FIPv4Endpoint::Any, SubjectName, *FrameDataStruct.Cast<FLiveLinkAnimationFrameData>(), SchemaHash) == EJSONLiveLinkBinaryResult::Frame;
+			return NumDecoded;
+		}
+
+		FJSONLiveLinkJsonReader Reader(Data, Size);
+		FJSONLiveLinkStringView SubjectKey;
+		if (Reader.ReadObjectStart())
+		{
+			while (Reader.NextMember(SubjectKey))
+			{
+				FLiveLinkFrameDataStruct FrameDataStruct = FLiveLinkFrameDataStruct(FLiveLinkAnimationFrameData::StaticStruct());
+				uint32 SchemaHash;
+				if (!Decoder.DecodeSubject(Reader, Decoder.FindSubjectName(SubjectKey), *FrameDataStruct.Cast<FLiveLinkAnimationFrameData>(), SchemaHash))
+				{
+					break;
+				}
+				++NumDecoded;
+			}
+		}
+		return NumDecoded;
+	}
+
+	/** Malloc and Realloc calls made so far by every thread, as counted by allocators that implement the counts */
+	struct FAllocationCounts : public FMalloc
+	{
+		static uint64 GetTotal() { return TotalMallocCalls + TotalReallocCalls; }
+	};
+
+	// Returns false when a corpus didn't decode completely
+	static bool RunCorpora(int32 Iterations)
+	{
+		bool bAllDecoded = true;
+
+		TArray<FCorpus> Corpora;
+		MakeCorpora(Corpora);
+
+		for (const FCorpus& Corpus : Corpora)
+		{
+			FJSONLiveLinkDecoder Decoder;
+
+			// Learn the schema and layout, the benchmark measures the steady state
+			for (const TArray<uint8>& Packet : Corpus.Packets)
+			{
+				DecodePacket(Decoder, Packet);
+			}
+			const int32 FirstFrame = Corpus.bBinary ? 1 : 0;
+			const int32 NumPackets = Iterations * (Corpus.Packets.Num() - FirstFrame);
+			const int32 PacketBytes = Corpus.Packets.Last().Num();
+
+			// GMalloc can't be safely swapped for a counting one while other threads allocate through it. The allocator's own
+			// counts include their allocations too, an upper bound of the decoder's.
+			const uint64 StartAllocations = FAllocationCounts::GetTotal();
+
+			int32 NumDecoded = 0;
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				for (int32 PacketIdx = FirstFrame; PacketIdx < Corpus.Packets.Num(); ++PacketIdx)
+				{
+					NumDecoded += DecodePacket(Decoder, Corpus.Packets[PacketIdx]);
+				}
+			}
+			const double Elapsed = FPlatformTime::Seconds() - StartTime;
+			const uint64 NumAllocations = FAllocationCounts::GetTotal() - StartAllocations;
+
+			if (NumDecoded != NumPackets)
+			{
+				UE_LOG(LogJSONLiveLink, Error, TEXT("%s: only %d of %d packets decoded"), *Corpus.Description, NumDecoded, NumPackets);
+				bAllDecoded = false;
+				continue;
+			}
+
+			UE_LOG(LogJSONLiveLink, Display, TEXT("%s (%d bytes): %.0f packets/s, %.1f ns/bone, at most %.2f allocations/packet"),
+				*Corpus.Description, PacketBytes, NumPackets / Elapsed, Elapsed * 1e9 / ((double)NumPackets * Corpus.NumBones),
+				(double)NumAllocations / NumPackets);
+		}
+		return bAllDecoded;
+	}
+
+	static void Run(const TArray<FString>& Args)
+	{
+		RunCorpora(Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 200);
+	}
+
+	static FAutoConsoleCommand BenchmarkCommand(
+		TEXT("JSONLiveLink.Benchmark"),
+		TEXT("Decodes generated JSON and binary packets of 5, 60 and 200 bones and logs packets/s, ns/bone and allocations/packet. Optional argument: iterations over each corpus."),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&Run));
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Fails when a parser change stops any corpus from decoding, the logged rates can be compared between builds
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJSONLiveLinkBenchmarkTest, "JSONLiveLink.Benchmark", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FJSONLiveLinkBenchmarkTest::RunTest(const FString& Parameters)
+{
+	return JSONLiveLinkBenchmark::RunCorpora(Parameters.IsEmpty() ? 200 : FMath::Max(FCString::Atoi(*Parameters), 1));
+}
+
+#endif
+
+#endif
@@ -0,0 +1,104 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "JSONLiveLinkJsonReader.h"
+
+/** Bounds checked little-endian reader over a binary packet, once a read fails every following read fails too */
+class FJSONLiveLinkBinaryReader
+{
+public:
+
+	FJSONLiveLinkBinaryReader(const uint8* InData, int32 InSize)
+	: Data(InData)
+	, Size(InSize)
+	, Pos(0)
+	, bError(false)
+	{
+	}
+
+	template<typename T>
+	bool Read(T& OutValue)
+	{
+		static_assert(PLATFORM_LITTLE_ENDIAN, "Binary packets are read in place as little-endian");
+		if (!CanRead(sizeof(T)))
+		{
+			return false;
+		}
+		FMemory::Memcpy(&OutValue, Data + Pos, sizeof(T));
+		Pos += sizeof(T);
+		return true;
+	}
+
+	bool ReadString(FJSONLiveLinkStringView& OutString)
+	{
+		uint16 Len;
+		if (!Read(Len) || !CanRead(Len))
+		{
+			return false;
+		}
+		OutString.Data = Data + Pos;
+		OutString.Len = Len;
+		OutString.bHasEscapes = false;
+		Pos += Len;
+		return true;
+	}
+
+	// Returns a pointer to NumBytes in the packet
+	const uint8* ReadBytes(int32 NumBytes)
+	{
+		if (NumBytes < 0)
+		{
+			bError = true;
+		}
+		if (!CanRead(NumBytes))
+		{
+			return nullptr;
+		}
+		const uint8* Bytes = Data + Pos;
+		Pos += NumBytes;
+		return Bytes;
+	}
+
+	// Returns a pointer to Count floats in the packet, which may not be aligned
+	const uint8* ReadFloats(int32 Count)
+	{
+		return ReadBytes(Count * (int32)sizeof(float));
+	}
+
+	static float GetFloat(const uint8* Floats, int32 Index)
+	{
+		float Value;
+		FMemory::Memcpy(&Value, Floats + Index * sizeof(float), sizeof(float));
+		return Value;
+	}
+
+	static uint16 GetUInt16(const uint8* Values, int32 Index)
+	{
+		uint16 Value;
+		FMemory::Memcpy(&Value, Values + Index * sizeof(uint16), sizeof(uint16));
+		return Value;
+	}
+
+	bool HasError() const { return bError; }
+
+	int32 GetPosition() const { return Pos; }
+
+private:
+
+	bool CanRead(int32 NumBytes)
+	{
+		if (bError || NumBytes > Size - Pos)
+		{
+			bError = true;
+			return false;
+		}
+		return true;
+	}
+
+	const uint8* Data;
+	int32 Size;
+	int32 Pos;
+	bool bError;
+};
@@ -0,0 +1,51 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Little-endian writer into a fixed size buffer, the counterpart of FJSONLiveLinkBinaryReader */
+class FJSONLiveLinkBinaryWriter
+{
+public:
+
+	FJSONLiveLinkBinaryWriter(uint8* InData, int32 InSize)
+	: Data(InData)
+	, Size(InSize)
+	, Pos(0)
+	{
+	}
+
+	template<typename T>
+	void Write(const T& Value)
+	{
+		static_assert(PLATFORM_LITTLE_ENDIAN, "Binary packets are written in place as little-endian");
+		check(Pos + (int32)sizeof(T) <= Size);
+		FMemory::Memcpy(Data + Pos, &Value, sizeof(T));
+		Pos += sizeof(T);
+	}
+
+	void WriteBytes(const void* Bytes, int32 NumBytes)
+	{
+		check(NumBytes >= 0 && Pos + NumBytes <= Size);
+		FMemory::Memcpy(Data + Pos, Bytes, NumBytes);
+		Pos += NumBytes;
+	}
+
+	// A uint16 byte count followed by the UTF-8 bytes
+	void WriteString(const FString& String)
+	{
+		FTCHARToUTF8 Utf8(*String);
+		check(Utf8.Length() <= MAX_uint16);
+		Write((uint16)Utf8.Length());
+		WriteBytes(Utf8.Get(), Utf8.Length());
+	}
+
+	int32 GetPosition() const { return Pos; }
+
+private:
+
+	uint8* Data;
+	int32 Size;
+	int32 Pos;
+};
@@ -0,0 +1,259 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#include "JSONLiveLinkCapture.h"
+#include "JSONLiveLink.h"
+#include "JSONLiveLinkBinaryReader.h"
+#include "JSONLiveLinkBinaryWriter.h"
+
+#include "Async/MappedFileHandle.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+// Buffered bytes past which datagrams are dropped rather than growing the buffer further
+#define CAPTURE_MAX_PENDING_SIZE 64 * 1024 * 1024
+
+// Longest a datagram waits in memory before being written out
+#define CAPTURE_FLUSH_INTERVAL_MS 50
+
+FJSONLiveLinkCaptureWriter::FJSONLiveLinkCaptureWriter(const FString& InFilename)
+: Filename(InFilename)
+, Stopping(false)
+, FlushEvent(FPlatformProcess::GetSynchEventFromPool())
+, Thread(nullptr)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Filename));
+	FileHandle.Reset(PlatformFile.OpenWrite(*Filename));
+	if (!FileHandle.IsValid())
+	{
+		UE_LOG(LogJSONLiveLink, Error, TEXT("Failed to open capture file %s"), *Filename);
+		return;
+	}
+
+	uint8 Header[JSONLiveLinkCapture::FileHeaderSize];
+	FJSONLiveLinkBinaryWriter Writer(Header, sizeof(Header));
+	Writer.Write(JSONLiveLinkCapture::CaptureMagic);
+	Writer.Write(JSONLiveLinkCapture::CaptureVersion);
+	FileHandle->Write(Header, sizeof(Header));
+
+	Thread = FRunnableThread::Create(this, TEXT("JSON LiveLink Capture"), 64 * 1024, TPri_BelowNormal);
+}
+
+FJSONLiveLinkCaptureWriter::~FJSONLiveLinkCaptureWriter()
+{
+	Stop();
+	if (Thread != nullptr)
+	{
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+	FPlatformProcess::ReturnSynchEventToPool(FlushEvent);
+}
+
+void FJSONLiveLinkCaptureWriter::Append(const FJSONLiveLinkDatagram& Datagram)
+{
+	// Packets streamed over TCP can be larger than a record holds
+	if (Datagram.Size > MAX_uint16)
+	{
+		NumDropped.Increment();
+		return;
+	}
+
+	uint8 Header[JSONLiveLinkCapture::RecordHeaderSize];
+	FJSONLiveLinkBinaryWriter Writer(Header, sizeof(Header));
+	Writer.Write(Datagram.ArrivalTime);
+	Writer.Write(Datagram.Sender.Address.Value);
+	Writer.Write(Datagram.Sender.Port);
+	Writer.Write((uint16)Datagram.Size);
+
+	FScopeLock Lock(&BufferCriticalSection);
+	if (PendingBuffer.Num() + sizeof(Header) + Datagram.Size > CAPTURE_MAX_PENDING_SIZE)
+	{
+		NumDropped.Increment();
+		return;
+	}
+	PendingBuffer.Append(Header, sizeof(Header));
+	PendingBuffer.Append(Datagram.Data, Datagram.Size);
+}
+
+uint32 FJSONLiveLinkCaptureWriter::Run()
+{
+	while (!Stopping)
+	{
+		FlushEvent->Wait(CAPTURE_FLUSH_INTERVAL_MS);
+		Flush();
+	}
+
+	// Whatever was appended before the receivers stopped
+	Flush();
+	return 0;
+}
+
+void FJSONLiveLinkCaptureWriter::Stop()
+{
+	Stopping = true;
+	FlushEvent->Trigger();
+}
+
+void FJSONLiveLinkCaptureWriter::Flush()
+{
+	{
+		FScopeLock Lock(&BufferCriticalSection);
+		Swap(PendingBuffer, WriteBuffer);
+	}
+
+	if (WriteBuffer.Num() > 0 && !FileHandle->Write(WriteBuffer.GetData(), WriteBuffer.Num()))
+	{
+		UE_LOG(LogJSONLiveLink, Warning, TEXT("Failed to write to capture file %s"), *Filename);
+	}
+
+	// Keeps the allocation so steady state capturing doesn't allocate
+	WriteBuffer.Reset();
+}
+
+FJSONLiveLinkReplayReceiver::FJSONLiveLinkReplayReceiver(const FString& Filename, int32 BatchSize, int32 InMaxDatagramSize, bool bOwnSlots, bool bInAsFastAsPossible)
+: FJSONLiveLinkReceiver(BatchSize, InMaxDatagramSize, bOwnSlots)
+, FileData(nullptr)
+, FileSize(0)
+, ReadPos(JSONLiveLinkCapture::FileHeaderSize)
+, bAsFastAsPossible(bInAsFastAsPossible)
+, FirstArrivalTime(0)
+, StartTime(0)
+, bStarted(false)
+, bFinished(false)
+, WakeEvent(FPlatformProcess::GetSynchEventFromPool())
+{
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	if (MappedFile.IsValid())
+	{
+		MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize(), true));
+	}
+	if (!MappedRegion.IsValid())
+	{
+		UE_LOG(LogJSONLiveLink, Error, TEXT("Failed to open capture file %s"), *Filename);
+		return;
+	}
+
+	FJSONLiveLinkBinaryReader Reader(MappedRegion->GetMappedPtr(), (int32)FMath::Min<int64>(MappedRegion->GetMappedSize(), JSONLiveLinkCapture::FileHeaderSize));
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	if (!Reader.Read(Magic) || !Reader.Read(Version) || Magic != JSONLiveLinkCapture::CaptureMagic || Version != JSONLiveLinkCapture::CaptureVersion)
+	{
+		UE_LOG(LogJSONLiveLink, Error, TEXT("%s is not a JSON LiveLink capture file"), *Filename);
+		return;
+	}
+
+	FileData = MappedRegion->GetMappedPtr();
+	FileSize = MappedRegion->GetMappedSize();
+}
+
+FJSONLiveLinkReplayReceiver::~FJSONLiveLinkReplayReceiver()
+{
+	// The region has to go before the file it maps
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+}
+
+bool FJSONLiveLinkReplayReceiver::IsValid() const
+{
+	return FileData != nullptr;
+}
+
+bool FJSONLiveLinkReplayReceiver::PeekRecord(double& OutArrivalTime, FIPv4Endpoint& OutSender, const uint8*& OutData, int32& OutSize, int64& OutNextPos) const
+{
+	FJSONLiveLinkBinaryReader Reader(FileData + ReadPos, (int32)FMath::Min<int64>(FileSize - ReadPos, JSONLiveLinkCapture::RecordHeaderSize + MAX_uint16));
+	uint16 Size;
+	if (!Reader.Read(OutArrivalTime) || !Reader.Read(OutSender.Address.Value) || !Reader.Read(OutSender.Port) || !Reader.Read(Size))
+	{
+		return false;
+	}
+	OutData = Reader.ReadBytes(Size);
+	OutSize = Size;
+	OutNextPos = ReadPos + JSONLiveLinkCapture::RecordHeaderSize + Size;
+	return OutData != nullptr;
+}
+
+void FJSONLiveLinkReplayReceiver::Wake()
+{
+	WakeEvent->Trigger();
+}
+
+int32 FJSONLiveLinkReplayReceiver::ReceiveBatch(const FTimespan& WaitTime, int32 MaxDatagrams)
+{
+	const double WaitEndTime = WaitTime == FTimespan::MaxValue() ? DBL_MAX : FPlatformTime::Seconds() + WaitTime.GetTotalSeconds();
+
+	MaxDatagrams = FMath::Clamp(MaxDatagrams, 1, Datagrams.Num());
+	int32 NumReceived = 0;
+	while (NumReceived < MaxDatagrams)
+	{
+		double CaptureTime;
+		FIPv4Endpoint Sender;
+		const uint8* Data;
+		int32 Size;
+		int64 NextPos;
+		if (!PeekRecord(CaptureTime, Sender, Data, Size, NextPos))
+		{
+			if (!bFinished)
+			{
+				UE_LOG(LogJSONLiveLink, Display, TEXT("Finished replaying capture file"));
+				bFinished = true;
+			}
+			break;
+		}
+
+		double Now = FPlatformTime::Seconds();
+		if (!bStarted)
+		{
+			FirstArrivalTime = CaptureTime;
+			StartTime = Now;
+			bStarted = true;
+		}
+
+		double ArrivalTime = bAsFastAsPossible ? Now : StartTime + (CaptureTime - FirstArrivalTime);
+		if (ArrivalTime > Now)
+		{
+			// Hand out what's already due, otherwise wait for the next datagram like a socket would
+			if (NumReceived > 0 || ArrivalTime > WaitEndTime)
+			{
+				break;
+			}
+			if (WakeEvent->Wait(FTimespan::FromSeconds(ArrivalTime - Now)))
+			{
+				return 0;
+			}
+		}
+
+		FJSONLiveLinkDatagram& Datagram = Datagrams[NumReceived++];
+		if (Size > MaxDatagramSize)
+		{
+			// Captured with a larger limit than this source has
+			Size = 0;
+			NumTruncated.IncrementExchange();
+		}
+		FMemory::Memcpy(Datagram.Data, Data, Size);
+		Datagram.Size = Size;
+		Datagram.Sender = Sender;
+		Datagram.ArrivalTime = ArrivalTime;
+		ReadPos = NextPos;
+	}
+
+	if (NumReceived == 0)
+	{
+		// Nothing due before the wait time is up, or nothing left to play
+		if (WaitEndTime == DBL_MAX)
+		{
+			WakeEvent->Wait();
+		}
+		else
+		{
+			WakeEvent->Wait(FTimespan::FromSeconds(FMath::Max(WaitEndTime - FPlatformTime::Seconds(), 0.0)));
+		}
+	}
+	return NumReceived;
+}
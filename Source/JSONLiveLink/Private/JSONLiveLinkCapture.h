@@ -0,0 +1,140 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "JSONLiveLinkReceiver.h"
+
+class FEvent;
+class FRunnableThread;
+class IFileHandle;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Capture files hold every datagram a source received, little-endian and packed:
+ *
+ *   uint32 Magic       CaptureMagic
+ *   uint32 Version     CaptureVersion
+ *
+ * followed by one record per datagram:
+ *
+ *   double ArrivalTime FPlatformTime::Seconds() when it was received
+ *   uint32 SenderAddress
+ *   uint16 SenderPort
+ *   uint16 Size
+ *   uint8  Data[Size]
+ */
+namespace JSONLiveLinkCapture
+{
+	// "JLLC" in memory
+	static const uint32 CaptureMagic = 0x434C4C4A;
+
+	static const uint32 CaptureVersion = 1;
+
+	static const int32 FileHeaderSize = 8;
+
+	static const int32 RecordHeaderSize = 16;
+}
+
+/**
+ * Appends datagrams to a capture file. Receiver threads only copy into a memory buffer, a background thread writes it out
+ * so a slow disk never stalls receiving. If the disk can't keep up at all datagrams are dropped once too much is buffered.
+ */
+class FJSONLiveLinkCaptureWriter : public FRunnable
+{
+public:
+
+	FJSONLiveLinkCaptureWriter(const FString& InFilename);
+	virtual ~FJSONLiveLinkCaptureWriter();
+
+	bool IsValid() const { return FileHandle.IsValid(); }
+
+	// Safe to call from any number of receiver threads
+	void Append(const FJSONLiveLinkDatagram& Datagram);
+
+	// Datagrams that didn't make it into the file
+	int32 GetNumDropped() const { return NumDropped.GetValue(); }
+
+	// Begin FRunnable Interface
+
+	virtual bool Init() override { return true; }
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	virtual void Exit() override { }
+
+	// End FRunnable Interface
+
+private:
+
+	// Writes everything appended so far, only called from the writer thread
+	void Flush();
+
+	FString Filename;
+
+	TUniquePtr<IFileHandle> FileHandle;
+
+	// Records appended since the last flush, swapped with WriteBuffer under the lock
+	TArray<uint8> PendingBuffer;
+	TArray<uint8> WriteBuffer;
+	FCriticalSection BufferCriticalSection;
+
+	FThreadSafeCounter NumDropped;
+
+	FThreadSafeBool Stopping;
+
+	FEvent* FlushEvent;
+
+	FRunnableThread* Thread;
+};
+
+/**
+ * Plays a capture file back as if its datagrams were arriving again, either at their original pace or as fast as they can be
+ * decoded. The file is memory mapped, each batch is copied into the slots like a socket would.
+ */
+class FJSONLiveLinkReplayReceiver : public FJSONLiveLinkReceiver
+{
+public:
+
+	FJSONLiveLinkReplayReceiver(const FString& Filename, int32 BatchSize, int32 InMaxDatagramSize, bool bOwnSlots, bool bInAsFastAsPossible);
+	virtual ~FJSONLiveLinkReplayReceiver();
+
+	// Begin FJSONLiveLinkReceiver Interface
+
+	virtual bool IsValid() const override;
+	virtual int32 ReceiveBatch(const FTimespan& WaitTime, int32 MaxDatagrams) override;
+	virtual void Wake() override;
+
+	// Nobody to send to, keyframe requests are dropped and the capture's own keyframes are relied on
+	virtual bool SendTo(const uint8* Data, int32 Size, const FIPv4Endpoint& Endpoint) override { return false; }
+
+	// End FJSONLiveLinkReceiver Interface
+
+private:
+
+	// Reads the record at ReadPos, false at the end of the file or if it's truncated
+	bool PeekRecord(double& OutArrivalTime, FIPv4Endpoint& OutSender, const uint8*& OutData, int32& OutSize, int64& OutNextPos) const;
+
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
+	const uint8* FileData;
+	int64 FileSize;
+	int64 ReadPos;
+
+	bool bAsFastAsPossible;
+
+	// Capture time of the first record and local time it was replayed at, records keep their spacing relative to it
+	double FirstArrivalTime;
+	double StartTime;
+	bool bStarted;
+
+	bool bFinished;
+
+	// Waited on instead of sleeping until the next record is due, triggered by Wake
+	FEvent* WakeEvent;
+};
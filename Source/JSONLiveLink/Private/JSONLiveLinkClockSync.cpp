@@ -0,0 +1,38 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#include "JSONLiveLinkClockSync.h"
+
+// Length of each of the two windows the minimum is taken over
+static const double WindowSeconds = 2.0;
+
+// A sample this much later than the estimate means the sender's clock went back, e.g. it restarted
+static const double ResetThresholdSeconds = 1.0;
+
+void FJSONLiveLinkClockSync::AddSample(double SenderTime, double LocalTime)
+{
+	const double Offset = LocalTime - SenderTime;
+	if (!bValid || Offset - GetOffset() > ResetThresholdSeconds)
+	{
+		Reset(Offset, LocalTime);
+		return;
+	}
+
+	if (LocalTime - WindowStart > WindowSeconds)
+	{
+		PreviousMin = CurrentMin;
+		CurrentMin = Offset;
+		WindowStart = LocalTime;
+	}
+	else
+	{
+		CurrentMin = FMath::Min(CurrentMin, Offset);
+	}
+}
+
+void FJSONLiveLinkClockSync::Reset(double Offset, double LocalTime)
+{
+	CurrentMin = Offset;
+	PreviousMin = Offset;
+	WindowStart = LocalTime;
+	bValid = true;
+}
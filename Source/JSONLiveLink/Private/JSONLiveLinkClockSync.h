@@ -0,0 +1,32 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Estimates the offset from a sender's clock to FPlatformTime::Seconds().
+ * Network and scheduling delays only ever make a packet arrive later, so the smallest arrival minus sender time seen
+ * over a sliding window is the best estimate. Keeping the previous window's minimum too lets it follow clock drift
+ * without losing the estimate every time a window starts.
+ */
+class FJSONLiveLinkClockSync
+{
+public:
+
+	void AddSample(double SenderTime, double LocalTime);
+
+	bool IsValid() const { return bValid; }
+
+	// Add to a sender time to get the local time
+	double GetOffset() const { return FMath::Min(CurrentMin, PreviousMin); }
+
+private:
+
+	void Reset(double Offset, double LocalTime);
+
+	double CurrentMin = 0;
+	double PreviousMin = 0;
+	double WindowStart = 0;
+	bool bValid = false;
+};
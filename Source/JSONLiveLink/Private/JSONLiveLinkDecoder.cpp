@@ -0,0 +1,1250 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#include "JSONLiveLinkDecoder.h"
+#include "JSONLiveLinkBinaryReader.h"
+#include "JSONLiveLinkBinaryWriter.h"
+#include "JSONLiveLinkFramePool.h"
+#include "JSONLiveLinkJsonReader.h"
+#include "JSONLiveLinkProtocol.h"
+#include "JSONLiveLinkSequenceTracker.h"
+
+#include "HAL/PlatformTime.h"
+#include "Misc/Crc.h"
+#include <math.h>
+
+// Keys of the members in EJSONLiveLinkField order
+static const ANSICHAR* const FieldKeys[] = { "Bone", "Parameter", "Name", "Parent", "Location", "Rotation", "Scale", "Value", "Timestamp", "Frame", "Sequence" };
+static const int32 FieldKeyLens[] = { 4, 9, 4, 6, 8, 8, 5, 5, 9, 5, 8 };
+
+// Properties appended after the parameters, derived from the bone rotations
+static const FName HeadRollName(TEXT("headRoll"));
+static const FName HeadPitchName(TEXT("headPitch"));
+static const FName HeadYawName(TEXT("headYaw"));
+
+// Keeps the subject name cache small when a sender keeps inventing new subjects
+static const int32 MaxCachedSubjectNames = 256;
+
+// Builds a bone transform from unaligned little-endian floats in a packet. The vectorized FTransform is loaded register by
+// register, the same loads its FQuat/FVector constructor does, so the result is bit identical to the scalar path.
+static FORCEINLINE FTransform MakeBinaryTransform(const uint8* Location, const uint8* Rotation, const uint8* Scale)
+{
+#if ENABLE_VECTORIZED_TRANSFORM
+	return FTransform(VectorLoad((const float*)Rotation), VectorLoadFloat3_W0((const float*)Location), VectorLoadFloat3_W0((const float*)Scale));
+#else
+	return FTransform(
+		FQuat(FJSONLiveLinkBinaryReader::GetFloat(Rotation, 0), FJSONLiveLinkBinaryReader::GetFloat(Rotation, 1), FJSONLiveLinkBinaryReader::GetFloat(Rotation, 2), FJSONLiveLinkBinaryReader::GetFloat(Rotation, 3)),
+		FVector(FJSONLiveLinkBinaryReader::GetFloat(Location, 0), FJSONLiveLinkBinaryReader::GetFloat(Location, 1), FJSONLiveLinkBinaryReader::GetFloat(Location, 2)),
+		FVector(FJSONLiveLinkBinaryReader::GetFloat(Scale, 0), FJSONLiveLinkBinaryReader::GetFloat(Scale, 1), FJSONLiveLinkBinaryReader::GetFloat(Scale, 2)));
+#endif
+}
+
+static bool KeyMatches(const FJSONLiveLinkStringView& Key, EJSONLiveLinkField Field)
+{
+	const int32 FieldIdx = (int32)Field;
+	return Field != EJSONLiveLinkField::Unknown && Key.Equals(FieldKeys[FieldIdx], FieldKeyLens[FieldIdx]);
+}
+
+static EJSONLiveLinkField ClassifyKey(const FJSONLiveLinkStringView& Key, EJSONLiveLinkField FirstCandidate, EJSONLiveLinkField LastCandidate)
+{
+	for (int32 FieldIdx = (int32)FirstCandidate; FieldIdx <= (int32)LastCandidate; ++FieldIdx)
+	{
+		if (KeyMatches(Key, (EJSONLiveLinkField)FieldIdx))
+		{
+			return (EJSONLiveLinkField)FieldIdx;
+		}
+	}
+	return EJSONLiveLinkField::Unknown;
+}
+
+FName FJSONLiveLinkDecoder::FindSubjectName(const FJSONLiveLinkStringView& SubjectKey)
+{
+	for (const FCachedSubjectName& Cached : SubjectNames)
+	{
+		if (SubjectKey.RawEquals(Cached.RawBytes.GetData(), Cached.RawBytes.Num()))
+		{
+			return Cached.Name;
+		}
+	}
+
+	if (SubjectNames.Num() >= MaxCachedSubjectNames)
+	{
+		SubjectNames.Reset();
+	}
+	FCachedSubjectName& Cached = SubjectNames.AddDefaulted_GetRef();
+	Cached.RawBytes.Append(SubjectKey.Data, SubjectKey.Len);
+	Cached.Name = SubjectKey.ToName();
+	return Cached.Name;
+}
+
+bool FJSONLiveLinkDecoder::DecodeSubject(FJSONLiveLinkJsonReader& Reader, FName SubjectName, FLiveLinkAnimationFrameData& OutFrameData, uint32& OutSchemaHash)
+{
+	FJSONLiveLinkSubjectLayout& Layout = Layouts.FindOrAdd(SubjectName);
+	LastTiming = FJSONLiveLinkFrameTiming();
+
+	bool bDecoded = false;
+	if (Layout.bCompiled)
+	{
+		const FJSONLiveLinkJsonReader SubjectStart = Reader;
+		bDecoded = DecodeCompiled(Reader, Layout, OutFrameData);
+		if (!bDecoded)
+		{
+			// The packet no longer matches what we learned, decode it again the slow way and relearn
+			Reader = SubjectStart;
+		}
+	}
+
+	if (!bDecoded && !DecodeGeneric(Reader, Layout, OutFrameData))
+	{
+		Layout.bCompiled = false;
+		LastStaticData = &Layout.StaticData;
+		return false;
+	}
+
+	LastStaticData = Layout.Mask.bActive ? &Layout.Mask.StaticData : &Layout.StaticData;
+	OutSchemaHash = GetMaskedSchemaHash(Layout.Mask, Layout.SchemaHash);
+	return true;
+}
+
+const FLiveLinkSkeletonStaticData& FJSONLiveLinkDecoder::GetStaticData(FName SubjectName) const
+{
+	const FJSONLiveLinkSubjectLayout& Layout = Layouts.FindChecked(SubjectName);
+	return Layout.Mask.bActive ? Layout.Mask.StaticData : Layout.StaticData;
+}
+
+void FJSONLiveLinkDecoder::SetFilter(const TArray<FName>& Subjects, const TArray<FName>& Bones, const TArray<FName>& Parameters)
+{
+	SubjectFilter = TSet<FName>(Subjects);
+	BoneFilter = TSet<FName>(Bones);
+	ParameterFilter = TSet<FName>(Parameters);
+
+	uint32 NewFilterHash = 0;
+	for (const TArray<FName>* Names : { &Bones, &Parameters })
+	{
+		for (FName Name : *Names)
+		{
+			NewFilterHash = HashCombine(NewFilterHash, GetTypeHash(Name));
+		}
+		NewFilterHash = HashCombine(NewFilterHash, Names->Num());
+	}
+
+	// Only the bones and parameters make up the masks, a new subject list keeps everything compiled
+	if (NewFilterHash == FilterHash)
+	{
+		return;
+	}
+	FilterHash = NewFilterHash;
+
+	// Layouts compile against their mask, relearning them rebuilds it. Binary subjects know their full static data already.
+	for (TPair<FName, FJSONLiveLinkSubjectLayout>& Layout : Layouts)
+	{
+		Layout.Value.bCompiled = false;
+	}
+	for (TPair<FJSONLiveLinkBinarySubjectKey, FJSONLiveLinkBinarySubject>& Subject : BinarySubjects)
+	{
+		BuildMask(Subject.Value.StaticData, Subject.Value.NumParameters, Subject.Value.SchemaHash, Subject.Value.Mask);
+	}
+}
+
+void FJSONLiveLinkDecoder::BuildMask(const FLiveLinkSkeletonStaticData& StaticData, int32 NumParameters, uint32 SchemaHash, FJSONLiveLinkSubjectMask& OutMask) const
+{
+	const uint32 BuiltForHash = HashCombine(SchemaHash, FilterHash);
+	if (OutMask.bBuilt && OutMask.BuiltForHash == BuiltForHash)
+	{
+		return;
+	}
+
+	OutMask.bBuilt = true;
+	OutMask.BuiltForHash = BuiltForHash;
+	OutMask.bActive = BoneFilter.Num() > 0 || ParameterFilter.Num() > 0;
+	OutMask.BoneIndices.Reset();
+	OutMask.ParameterIndices.Reset();
+	OutMask.NumParameters = 0;
+	OutMask.StaticData.BoneNames.Reset();
+	OutMask.StaticData.BoneParents.Reset();
+	OutMask.StaticData.PropertyNames.Reset();
+	if (!OutMask.bActive)
+	{
+		return;
+	}
+
+	const int32 NumBones = StaticData.BoneNames.Num();
+	for (int32 BoneIdx = 0; BoneIdx < NumBones; ++BoneIdx)
+	{
+		const FName BoneName = StaticData.BoneNames[BoneIdx];
+		const bool bKeep = BoneFilter.Num() == 0 || BoneFilter.Contains(BoneName);
+		OutMask.BoneIndices.Add(bKeep ? OutMask.StaticData.BoneNames.Add(BoneName) : INDEX_NONE);
+	}
+
+	for (int32 BoneIdx = 0; BoneIdx < NumBones; ++BoneIdx)
+	{
+		if (OutMask.BoneIndices[BoneIdx] == INDEX_NONE)
+		{
+			continue;
+		}
+
+		// Walk up past masked ancestors, bounded in case the sender's hierarchy has a cycle
+		int32 ParentIdx = StaticData.BoneParents[BoneIdx];
+		for (int32 Depth = 0; Depth < NumBones && StaticData.BoneParents.IsValidIndex(ParentIdx) && OutMask.BoneIndices[ParentIdx] == INDEX_NONE; ++Depth)
+		{
+			ParentIdx = StaticData.BoneParents[ParentIdx];
+		}
+		OutMask.StaticData.BoneParents.Add(StaticData.BoneParents.IsValidIndex(ParentIdx) ? OutMask.BoneIndices[ParentIdx] : INDEX_NONE);
+	}
+
+	for (int32 ParameterIdx = 0; ParameterIdx < NumParameters; ++ParameterIdx)
+	{
+		const FName ParameterName = StaticData.PropertyNames[ParameterIdx];
+		const bool bKeep = ParameterFilter.Num() == 0 || ParameterFilter.Contains(ParameterName);
+		OutMask.ParameterIndices.Add(bKeep ? OutMask.NumParameters++ : INDEX_NONE);
+		if (bKeep)
+		{
+			OutMask.StaticData.PropertyNames.Add(ParameterName);
+		}
+	}
+
+	// The head rotation is derived rather than sent, it's always kept
+	for (int32 PropertyIdx = NumParameters; PropertyIdx < StaticData.PropertyNames.Num(); ++PropertyIdx)
+	{
+		OutMask.StaticData.PropertyNames.Add(StaticData.PropertyNames[PropertyIdx]);
+	}
+}
+
+void FJSONLiveLinkDecoder::ApplyMask(const FJSONLiveLinkSubjectMask& Mask, int32 NumParameters, FLiveLinkAnimationFrameData& InOutFrameData)
+{
+	if (!Mask.bActive)
+	{
+		return;
+	}
+
+	// Kept values only ever move towards the front, so this compacts in place
+	for (int32 BoneIdx = 0; BoneIdx < Mask.BoneIndices.Num(); ++BoneIdx)
+	{
+		if (Mask.BoneIndices[BoneIdx] != INDEX_NONE)
+		{
+			InOutFrameData.Transforms[Mask.BoneIndices[BoneIdx]] = InOutFrameData.Transforms[BoneIdx];
+		}
+	}
+	InOutFrameData.Transforms.SetNum(Mask.StaticData.BoneNames.Num(), false);
+
+	float* Values = InOutFrameData.PropertyValues.GetData();
+	for (int32 ParameterIdx = 0; ParameterIdx < Mask.ParameterIndices.Num(); ++ParameterIdx)
+	{
+		if (Mask.ParameterIndices[ParameterIdx] != INDEX_NONE)
+		{
+			Values[Mask.ParameterIndices[ParameterIdx]] = Values[ParameterIdx];
+		}
+	}
+	const int32 NumDerived = InOutFrameData.PropertyValues.Num() - NumParameters;
+	FMemory::Memmove(Values + Mask.NumParameters, Values + NumParameters, NumDerived * sizeof(float));
+	InOutFrameData.PropertyValues.SetNum(Mask.NumParameters + NumDerived, false);
+}
+
+bool FJSONLiveLinkDecoder::DecodeCompiled(FJSONLiveLinkJsonReader& Reader, const FJSONLiveLinkSubjectLayout& Layout, FLiveLinkAnimationFrameData& OutFrameData)
+{
+	const FJSONLiveLinkSubjectMask& Mask = Layout.Mask;
+	const int32 NumBones = Layout.StaticData.BoneNames.Num();
+	const FLiveLinkSkeletonStaticData& PushedStaticData = Mask.bActive ? Mask.StaticData : Layout.StaticData;
+	FJSONLiveLinkFramePool::SizeFrame(OutFrameData, PushedStaticData.BoneNames.Num(), PushedStaticData.PropertyNames.Num());
+	const int32 NumPushedParameters = Mask.bActive ? Mask.NumParameters : Layout.NumParameters;
+
+	// Masked bones aren't parsed, except the last one whose rotation the head properties are derived from
+	FTransform MaskedLastBone;
+
+	bHasHeadBone = false;
+
+	if (!Reader.ReadObjectStart())
+	{
+		return false;
+	}
+
+	FJSONLiveLinkStringView Key;
+	for (EJSONLiveLinkField Field : Layout.SubjectFields)
+	{
+		if (!Reader.NextMember(Key) || !KeyMatches(Key, Field))
+		{
+			return false;
+		}
+
+		if (Field >= EJSONLiveLinkField::Timestamp && Field <= EJSONLiveLinkField::Sequence)
+		{
+			if (!DecodeTiming(Reader, Field))
+			{
+				return false;
+			}
+			continue;
+		}
+
+		if (!Reader.ReadArrayStart())
+		{
+			return false;
+		}
+
+		if (Field == EJSONLiveLinkField::Bone)
+		{
+			for (int32 BoneIdx = 0; BoneIdx < NumBones; ++BoneIdx)
+			{
+				const int32 PushedIdx = Mask.bActive ? Mask.BoneIndices[BoneIdx] : BoneIdx;
+				FTransform* OutTransform = PushedIdx != INDEX_NONE ? &OutFrameData.Transforms[PushedIdx] : (BoneIdx == NumBones - 1 ? &MaskedLastBone : nullptr);
+				if (!Reader.NextElement() || !DecodeBoneCompiled(Reader, Layout, BoneIdx, OutTransform))
+				{
+					return false;
+				}
+			}
+		}
+		else
+		{
+			for (int32 ParameterIdx = 0; ParameterIdx < Layout.NumParameters; ++ParameterIdx)
+			{
+				const int32 PushedIdx = Mask.bActive ? Mask.ParameterIndices[ParameterIdx] : ParameterIdx;
+				float* OutValue = PushedIdx != INDEX_NONE ? &OutFrameData.PropertyValues[PushedIdx] : nullptr;
+				if (!Reader.NextElement() || !DecodeParameterCompiled(Reader, Layout, ParameterIdx, OutValue))
+				{
+					return false;
+				}
+			}
+		}
+
+		// More elements than we learned
+		if (Reader.NextElement())
+		{
+			return false;
+		}
+	}
+
+	// More members than we learned
+	if (Reader.NextMember(Key) || Reader.HasError())
+	{
+		return false;
+	}
+
+	if (Layout.bHasParameters)
+	{
+		UpdateHeadRotation();
+		OutFrameData.PropertyValues[NumPushedParameters] = HeadRoll;
+		OutFrameData.PropertyValues[NumPushedParameters + 1] = HeadPitch;
+		OutFrameData.PropertyValues[NumPushedParameters + 2] = HeadYaw;
+	}
+	return true;
+}
+
+bool FJSONLiveLinkDecoder::DecodeBoneCompiled(FJSONLiveLinkJsonReader& Reader, const FJSONLiveLinkSubjectLayout& Layout, int32 BoneIdx, FTransform* OutTransform)
+{
+	double Location[3]; // X, Y, Z
+	double Rotation[4]; // X, Y, Z, W
+	double Scale[3]; // X, Y, Z
+
+	if (!Reader.ReadObjectStart())
+	{
+		return false;
+	}
+
+	FJSONLiveLinkStringView Key;
+	for (EJSONLiveLinkField Field : Layout.BoneFields)
+	{
+		if (!Reader.NextMember(Key) || !KeyMatches(Key, Field))
+		{
+			return false;
+		}
+
+		bool bRead;
+		switch (Field)
+		{
+		case EJSONLiveLinkField::Name:
+		{
+			FJSONLiveLinkStringView BoneName;
+			const int32 NameStart = Layout.NameOffsets[BoneIdx];
+			bRead = Reader.ReadString(BoneName) && BoneName.RawEquals(Layout.NameBytes.GetData() + NameStart, Layout.NameOffsets[BoneIdx + 1] - NameStart);
+			break;
+		}
+		case EJSONLiveLinkField::Parent:
+		{
+			double BoneParent;
+			bRead = Reader.ReadNumber(BoneParent) && BoneParent == (double)Layout.StaticData.BoneParents[BoneIdx];
+			break;
+		}
+		case EJSONLiveLinkField::Location:
+			bRead = OutTransform != nullptr ? Reader.ReadNumberArray(Location, 3) : Reader.SkipValue();
+			break;
+		case EJSONLiveLinkField::Rotation:
+			bRead = OutTransform != nullptr ? Reader.ReadNumberArray(Rotation, 4) : Reader.SkipValue();
+			break;
+		case EJSONLiveLinkField::Scale:
+			bRead = OutTransform != nullptr ? Reader.ReadNumberArray(Scale, 3) : Reader.SkipValue();
+			break;
+		default:
+			bRead = false;
+			break;
+		}
+
+		if (!bRead)
+		{
+			return false;
+		}
+	}
+
+	if (Reader.NextMember(Key) || Reader.HasError())
+	{
+		return false;
+	}
+
+	if (OutTransform == nullptr)
+	{
+		return true;
+	}
+
+	const double qx = Rotation[0];
+	const double qy = Rotation[1];
+	const double qz = Rotation[2];
+	const double qw = Rotation[3];
+
+	// Only the last bone's rotation ends up in the head properties, derived once the subject is decoded
+	FMemory::Memcpy(HeadBoneRotation, Rotation, sizeof(HeadBoneRotation));
+	bHasHeadBone = true;
+
+	*OutTransform = FTransform(FQuat(qx, qy, qz, qw), FVector(Location[0], Location[1], Location[2]), FVector(Scale[0], Scale[1], Scale[2]));
+	return true;
+}
+
+bool FJSONLiveLinkDecoder::DecodeParameterCompiled(FJSONLiveLinkJsonReader& Reader, const FJSONLiveLinkSubjectLayout& Layout, int32 ParameterIdx, float* OutValue)
+{
+	if (!Reader.ReadObjectStart())
+	{
+		return false;
+	}
+
+	const int32 NameIdx = Layout.StaticData.BoneNames.Num() + ParameterIdx;
+
+	FJSONLiveLinkStringView Key;
+	for (EJSONLiveLinkField Field : Layout.ParameterFields)
+	{
+		if (!Reader.NextMember(Key) || !KeyMatches(Key, Field))
+		{
+			return false;
+		}
+
+		bool bRead;
+		if (Field == EJSONLiveLinkField::Name)
+		{
+			FJSONLiveLinkStringView ParameterName;
+			const int32 NameStart = Layout.NameOffsets[NameIdx];
+			bRead = Reader.ReadString(ParameterName) && ParameterName.RawEquals(Layout.NameBytes.GetData() + NameStart, Layout.NameOffsets[NameIdx + 1] - NameStart);
+		}
+		else if (OutValue != nullptr)
+		{
+			double Value;
+			bRead = Reader.ReadNumber(Value);
+			*OutValue = (float)Value;
+		}
+		else
+		{
+			bRead = Reader.SkipValue();
+		}
+
+		if (!bRead)
+		{
+			return false;
+		}
+	}
+
+	return !Reader.NextMember(Key) && !Reader.HasError();
+}
+
+bool FJSONLiveLinkDecoder::DecodeGeneric(FJSONLiveLinkJsonReader& Reader, FJSONLiveLinkSubjectLayout& Layout, FLiveLinkAnimationFrameData& OutFrameData)
+{
+	// Names resolved for the previous packet are reused by AddName as long as their bytes match
+	Swap(Layout.CachedNameBytes, Layout.NameBytes);
+	Swap(Layout.CachedNameOffsets, Layout.NameOffsets);
+	Layout.CachedNames.Reset();
+	Layout.CachedNames.Append(Layout.StaticData.BoneNames);
+	Layout.CachedNames.Append(Layout.StaticData.PropertyNames);
+
+	// Keep the allocations from the previous packet
+	Layout.StaticData.BoneNames.Reset();
+	Layout.StaticData.BoneParents.Reset();
+	Layout.StaticData.PropertyNames.Reset();
+	Layout.SubjectFields.Reset();
+	Layout.BoneFields.Reset();
+	Layout.ParameterFields.Reset();
+	Layout.NameBytes.Reset();
+	Layout.NameOffsets.Reset();
+	Layout.NameOffsets.Add(0);
+	Layout.SchemaHash = 0;
+	Layout.NumParameters = 0;
+	Layout.bHasParameters = false;
+	Layout.bCompiled = true;
+
+	OutFrameData.Transforms.Reset();
+	OutFrameData.PropertyValues.Reset();
+
+	bHasHeadBone = false;
+
+	if (!Reader.ReadObjectStart())
+	{
+		return false;
+	}
+
+	// Bone names come before parameter names in NameOffsets, decode parameters after the bones
+	FJSONLiveLinkJsonReader ParameterReader = Reader;
+	bool bHasBones = false;
+
+	FJSONLiveLinkStringView Key;
+	while (Reader.NextMember(Key))
+	{
+		EJSONLiveLinkField Field = ClassifyKey(Key, EJSONLiveLinkField::Bone, EJSONLiveLinkField::Parameter);
+		if (Field == EJSONLiveLinkField::Unknown)
+		{
+			Field = ClassifyKey(Key, EJSONLiveLinkField::Timestamp, EJSONLiveLinkField::Sequence);
+		}
+
+		if (Field == EJSONLiveLinkField::Bone && !bHasBones)
+		{
+			bHasBones = true;
+			if (!Reader.ReadArrayStart())
+			{
+				return false;
+			}
+			while (Reader.NextElement())
+			{
+				if (!DecodeBone(Reader, Layout, OutFrameData))
+				{
+					return false;
+				}
+			}
+		}
+		else if (Field == EJSONLiveLinkField::Parameter && !Layout.bHasParameters)
+		{
+			Layout.bHasParameters = true;
+			ParameterReader = Reader;
+			if (!Reader.SkipValue())
+			{
+				return false;
+			}
+		}
+		else if ((Field == EJSONLiveLinkField::Timestamp && !LastTiming.bHasTimestamp) || (Field == EJSONLiveLinkField::Frame && !LastTiming.bHasFrame)
+			|| (Field == EJSONLiveLinkField::Sequence && !LastTiming.bHasSequence))
+		{
+			if (!DecodeTiming(Reader, Field))
+			{
+				return false;
+			}
+		}
+		else
+		{
+			// Unknown or repeated members
+			Layout.bCompiled = false;
+			if (!Reader.SkipValue())
+			{
+				return false;
+			}
+		}
+
+		if (Reader.HasError())
+		{
+			return false;
+		}
+
+		Layout.SubjectFields.Add(Field);
+	}
+
+	if (Reader.HasError())
+	{
+		return false;
+	}
+
+	if (Layout.bHasParameters)
+	{
+		if (!ParameterReader.ReadArrayStart())
+		{
+			return false;
+		}
+		while (ParameterReader.NextElement())
+		{
+			if (!DecodeParameter(ParameterReader, Layout, OutFrameData))
+			{
+				return false;
+			}
+		}
+		if (ParameterReader.HasError())
+		{
+			return false;
+		}
+
+		// Setup Head Rotation
+		UpdateHeadRotation();
+		Layout.StaticData.PropertyNames.Add(HeadRollName);
+		OutFrameData.PropertyValues.Add(HeadRoll);
+		Layout.StaticData.PropertyNames.Add(HeadPitchName);
+		OutFrameData.PropertyValues.Add(HeadPitch);
+		Layout.StaticData.PropertyNames.Add(HeadYawName);
+		OutFrameData.PropertyValues.Add(HeadYaw);
+	}
+
+	Layout.SchemaHash = FCrc::MemCrc32(&Layout.bHasParameters, sizeof(Layout.bHasParameters), Layout.SchemaHash);
+
+	// Learning needs every name, so the whole packet was decoded and only now cut down to what's kept
+	BuildMask(Layout.StaticData, Layout.NumParameters, Layout.SchemaHash, Layout.Mask);
+	ApplyMask(Layout.Mask, Layout.NumParameters, OutFrameData);
+	return true;
+}
+
+bool FJSONLiveLinkDecoder::DecodeTiming(FJSONLiveLinkJsonReader& Reader, EJSONLiveLinkField Field)
+{
+	double Value;
+	if (!Reader.ReadNumber(Value))
+	{
+		return false;
+	}
+
+	if (Field == EJSONLiveLinkField::Timestamp)
+	{
+		LastTiming.Timestamp = Value;
+		LastTiming.bHasTimestamp = true;
+	}
+	else if (Field == EJSONLiveLinkField::Frame)
+	{
+		// 2^63 itself rounds to MAX_int64 when compared as a double, NaN fails both
+		if (!(Value >= -9223372036854775808.0 && Value < 9223372036854775808.0))
+		{
+			return false;
+		}
+		LastTiming.Frame = (int64)Value;
+		LastTiming.bHasFrame = true;
+	}
+	else
+	{
+		if (Value < 0 || Value > MAX_uint32)
+		{
+			return false;
+		}
+		LastTiming.Sequence = (uint32)Value;
+		LastTiming.bHasSequence = true;
+	}
+	return true;
+}
+
+bool FJSONLiveLinkDecoder::DecodeBone(FJSONLiveLinkJsonReader& Reader, FJSONLiveLinkSubjectLayout& Layout, FLiveLinkAnimationFrameData& OutFrameData)
+{
+	FJSONLiveLinkStringView BoneName;
+	double BoneParent = 0;
+	double Location[3]; // X, Y, Z
+	double Rotation[4]; // X, Y, Z, W
+	double Scale[3]; // X, Y, Z
+
+	bool bHasName = false;
+	bool bHasParent = false;
+	bool bHasLocation = false;
+	bool bHasRotation = false;
+	bool bHasScale = false;
+
+	TArray<EJSONLiveLinkField, TInlineAllocator<8>> Fields;
+
+	if (!Reader.ReadObjectStart())
+	{
+		return false;
+	}
+
+	FJSONLiveLinkStringView Key;
+	while (Reader.NextMember(Key))
+	{
+		const EJSONLiveLinkField Field = ClassifyKey(Key, EJSONLiveLinkField::Name, EJSONLiveLinkField::Scale);
+		Fields.Add(Field);
+
+		bool bRead;
+		switch (Field)
+		{
+		case EJSONLiveLinkField::Name:
+			bRead = bHasName = Reader.ReadString(BoneName);
+			break;
+		case EJSONLiveLinkField::Parent:
+			bRead = bHasParent = Reader.ReadNumber(BoneParent);
+			break;
+		case EJSONLiveLinkField::Location:
+			bRead = bHasLocation = Reader.ReadNumberArray(Location, 3);
+			break;
+		case EJSONLiveLinkField::Rotation:
+			bRead = bHasRotation = Reader.ReadNumberArray(Rotation, 4);
+			break;
+		case EJSONLiveLinkField::Scale:
+			bRead = bHasScale = Reader.ReadNumberArray(Scale, 3);
+			break;
+		default:
+			bRead = Reader.SkipValue();
+			break;
+		}
+
+		if (!bRead)
+		{
+			return false;
+		}
+	}
+
+	if (Reader.HasError() || !bHasName || !bHasParent || !bHasLocation || !bHasRotation || !bHasScale
+		|| BoneParent < MIN_int32 || BoneParent > MAX_int32)
+	{
+		// Invalid Json Format
+		return false;
+	}
+
+	const int32 BoneParentIdx = (int32)BoneParent;
+	LearnFields(Fields, Layout.StaticData.BoneNames.Num() == 0, Layout.BoneFields, Layout.bCompiled);
+	Layout.StaticData.BoneNames.Add(AddName(Layout, BoneName));
+	Layout.StaticData.BoneParents.Add(BoneParentIdx);
+	Layout.SchemaHash = FCrc::MemCrc32(&BoneParentIdx, sizeof(BoneParentIdx), Layout.SchemaHash);
+	if (BoneParent != (double)BoneParentIdx)
+	{
+		// The compiled path compares parents exactly
+		Layout.bCompiled = false;
+	}
+
+	const double qx = Rotation[0];
+	const double qy = Rotation[1];
+	const double qz = Rotation[2];
+	const double qw = Rotation[3];
+
+	// Only the last bone's rotation ends up in the head properties, derived once the subject is decoded
+	FMemory::Memcpy(HeadBoneRotation, Rotation, sizeof(HeadBoneRotation));
+	bHasHeadBone = true;
+
+	OutFrameData.Transforms.Add(FTransform(FQuat(qx, qy, qz, qw), FVector(Location[0], Location[1], Location[2]), FVector(Scale[0], Scale[1], Scale[2])));
+	return true;
+}
+
+bool FJSONLiveLinkDecoder::DecodeParameter(FJSONLiveLinkJsonReader& Reader, FJSONLiveLinkSubjectLayout& Layout, FLiveLinkAnimationFrameData& OutFrameData)
+{
+	FJSONLiveLinkStringView ParameterName;
+	double Value = 0;
+
+	bool bHasName = false;
+	bool bHasValue = false;
+
+	TArray<EJSONLiveLinkField, TInlineAllocator<8>> Fields;
+
+	if (!Reader.ReadObjectStart())
+	{
+		return false;
+	}
+
+	FJSONLiveLinkStringView Key;
+	while (Reader.NextMember(Key))
+	{
+		EJSONLiveLinkField Field = ClassifyKey(Key, EJSONLiveLinkField::Name, EJSONLiveLinkField::Value);
+		if (Field != EJSONLiveLinkField::Name && Field != EJSONLiveLinkField::Value)
+		{
+			Field = EJSONLiveLinkField::Unknown;
+		}
+		Fields.Add(Field);
+
+		bool bRead;
+		if (Field == EJSONLiveLinkField::Name)
+		{
+			bRead = bHasName = Reader.ReadString(ParameterName);
+		}
+		else if (Field == EJSONLiveLinkField::Value)
+		{
+			bRead = bHasValue = Reader.ReadNumber(Value);
+		}
+		else
+		{
+			bRead = Reader.SkipValue();
+		}
+
+		if (!bRead)
+		{
+			return false;
+		}
+	}
+
+	if (Reader.HasError() || !bHasName || !bHasValue)
+	{
+		// invalid json format
+		return false;
+	}
+
+	LearnFields(Fields, Layout.NumParameters == 0, Layout.ParameterFields, Layout.bCompiled);
+	Layout.StaticData.PropertyNames.Add(AddName(Layout, ParameterName));
+	++Layout.NumParameters;
+	OutFrameData.PropertyValues.Add((float)Value);
+	return true;
+}
+
+void FJSONLiveLinkDecoder::LearnFields(const TArray<EJSONLiveLinkField, TInlineAllocator<8>>& Fields, bool bFirst, TArray<EJSONLiveLinkField>& LayoutFields, bool& bCompiled)
+{
+	if (bFirst)
+	{
+		LayoutFields.Reset();
+		LayoutFields.Append(Fields);
+	}
+	else if (Fields.Num() != LayoutFields.Num() || FMemory::Memcmp(Fields.GetData(), LayoutFields.GetData(), Fields.Num() * sizeof(EJSONLiveLinkField)) != 0)
+	{
+		bCompiled = false;
+	}
+
+	if (Fields.Contains(EJSONLiveLinkField::Unknown))
+	{
+		bCompiled = false;
+	}
+}
+
+FName FJSONLiveLinkDecoder::AddName(FJSONLiveLinkSubjectLayout& Layout, const FJSONLiveLinkStringView& Name)
+{
+	const int32 NameIdx = Layout.NameOffsets.Num() - 1;
+	Layout.NameBytes.Append(Name.Data, Name.Len);
+	Layout.NameOffsets.Add(Layout.NameBytes.Num());
+
+	Layout.SchemaHash = FCrc::MemCrc32(&Name.Len, sizeof(Name.Len), Layout.SchemaHash);
+	Layout.SchemaHash = FCrc::MemCrc32(Name.Data, Name.Len, Layout.SchemaHash);
+
+	if (NameIdx + 1 < Layout.CachedNameOffsets.Num() && NameIdx < Layout.CachedNames.Num())
+	{
+		const int32 CachedStart = Layout.CachedNameOffsets[NameIdx];
+		if (Name.RawEquals(Layout.CachedNameBytes.GetData() + CachedStart, Layout.CachedNameOffsets[NameIdx + 1] - CachedStart))
+		{
+			return Layout.CachedNames[NameIdx];
+		}
+	}
+	return Name.ToName();
+}
+
+bool FJSONLiveLinkDecoder::IsBinaryPacket(const uint8* Data, int32 Size)
+{
+	uint32 Magic = 0;
+	if (Size >= JSONLiveLinkProtocol::HeaderSize)
+	{
+		FMemory::Memcpy(&Magic, Data, sizeof(Magic));
+	}
+	return Magic == JSONLiveLinkProtocol::BinaryMagic;
+}
+
+bool FJSONLiveLinkDecoder::IsDependedOnPacket(const uint8* Data, int32 Size)
+{
+	if (!IsBinaryPacket(Data, Size))
+	{
+		return false;
+	}
+	// The packet type follows the magic and version
+	const EJSONLiveLinkPacketType PacketType = (EJSONLiveLinkPacketType)Data[sizeof(uint32) + sizeof(uint8)];
+	return PacketType == EJSONLiveLinkPacketType::Schema || PacketType == EJSONLiveLinkPacketType::Keyframe || PacketType == EJSONLiveLinkPacketType::Delta;
+}
+
+uint32 FJSONLiveLinkDecoder::GetCoalesceKey(const uint8* Data, int32 Size, const FIPv4Endpoint& Sender)
+{
+	if (IsBinaryPacket(Data, Size))
+	{
+		FJSONLiveLinkBinaryReader Reader(Data, Size);
+		uint32 Magic;
+		uint8 Version;
+		uint8 PacketType;
+		uint16 Flags;
+		uint32 SubjectId;
+		if (Reader.Read(Magic) && Reader.Read(Version) && Reader.Read(PacketType) && Reader.Read(Flags) && Reader.Read(SubjectId)
+			&& Version == JSONLiveLinkProtocol::BinaryVersion && PacketType == (uint8)EJSONLiveLinkPacketType::Frame)
+		{
+			return HashCombine(GetTypeHash(FJSONLiveLinkBinarySubjectKey{ Sender, SubjectId }), (uint32)EJSONLiveLinkPacketType::Frame) | 1;
+		}
+		return 0;
+	}
+
+	// Subject names of every top-level member, values are skipped without being tokenized
+	FJSONLiveLinkJsonReader Reader(Data, Size);
+	if (!Reader.ReadObjectStart())
+	{
+		return 0;
+	}
+	uint32 Key = 0;
+	FJSONLiveLinkStringView SubjectKey;
+	while (Reader.NextMember(SubjectKey))
+	{
+		// The length is hashed between the names, so {"AB":..,"C":..} and {"A":..,"BC":..} don't collide
+		const int32 KeyLen = SubjectKey.Len;
+		Key = FCrc::MemCrc32(&KeyLen, sizeof(KeyLen), Key);
+		Key = FCrc::MemCrc32(SubjectKey.Data, SubjectKey.Len, Key);
+		if (!Reader.SkipValue())
+		{
+			return 0;
+		}
+	}
+	// Binary keys are odd, keep JSON keys even and never 0
+	return Reader.HasError() ? 0 : (Key << 1) | 2;
+}
+
+EJSONLiveLinkBinaryResult FJSONLiveLinkDecoder::DecodeBinary(const uint8* Data, int32 Size, const FIPv4Endpoint& Sender, FName& OutSubjectName, FLiveLinkAnimationFrameData& OutFrameData, uint32& OutSchemaHash)
+{
+	FJSONLiveLinkBinaryReader Reader(Data, Size);
+
+	uint32 Magic;
+	uint8 Version;
+	uint8 PacketType;
+	uint16 Flags;
+	uint32 SubjectId;
+	uint32 SchemaId;
+	if (!Reader.Read(Magic) || !Reader.Read(Version) || !Reader.Read(PacketType) || !Reader.Read(Flags) || !Reader.Read(SubjectId) || !Reader.Read(SchemaId)
+		|| Magic != JSONLiveLinkProtocol::BinaryMagic || Version != JSONLiveLinkProtocol::BinaryVersion)
+	{
+		return EJSONLiveLinkBinaryResult::Invalid;
+	}
+
+	LastTiming = FJSONLiveLinkFrameTiming();
+	if ((EJSONLiveLinkPacketType)PacketType != EJSONLiveLinkPacketType::Schema)
+	{
+		if (EnumHasAnyFlags((EJSONLiveLinkPacketFlags)Flags, EJSONLiveLinkPacketFlags::Timestamp))
+		{
+			LastTiming.bHasTimestamp = Reader.Read(LastTiming.Timestamp);
+		}
+		if (EnumHasAnyFlags((EJSONLiveLinkPacketFlags)Flags, EJSONLiveLinkPacketFlags::Frame))
+		{
+			uint32 Frame;
+			LastTiming.bHasFrame = Reader.Read(Frame);
+			LastTiming.Frame = Frame;
+		}
+		if (EnumHasAnyFlags((EJSONLiveLinkPacketFlags)Flags, EJSONLiveLinkPacketFlags::Sequence) && (EJSONLiveLinkPacketType)PacketType == EJSONLiveLinkPacketType::Frame)
+		{
+			LastTiming.bHasSequence = Reader.Read(LastTiming.Sequence);
+		}
+		if (Reader.HasError())
+		{
+			return EJSONLiveLinkBinaryResult::Invalid;
+		}
+	}
+
+	const FJSONLiveLinkBinarySubjectKey Key{ Sender, SubjectId };
+	if ((EJSONLiveLinkPacketType)PacketType == EJSONLiveLinkPacketType::Schema)
+	{
+		return DecodeBinarySchema(Reader, Data, Size, (EJSONLiveLinkPacketFlags)Flags, Key, SchemaId) ? EJSONLiveLinkBinaryResult::NoFrame : EJSONLiveLinkBinaryResult::Invalid;
+	}
+
+	FJSONLiveLinkBinarySubject* Subject = BinarySubjects.Find(Key);
+	if (Subject == nullptr || Subject->SchemaId != SchemaId)
+	{
+		// Frames are meaningless until the matching schema arrives
+		return EJSONLiveLinkBinaryResult::Invalid;
+	}
+
+	if (!IsSubjectAllowed(Subject->SubjectName))
+	{
+		// Deltas can't be followed without decoding them, letting the subject through later waits for a keyframe
+		Subject->bHasKeyframe = false;
+		return EJSONLiveLinkBinaryResult::NoFrame;
+	}
+
+	EJSONLiveLinkBinaryResult Result;
+	switch ((EJSONLiveLinkPacketType)PacketType)
+	{
+	case EJSONLiveLinkPacketType::Frame:
+		Result = DecodeBinaryFrame(Reader, *Subject, OutFrameData, true) ? EJSONLiveLinkBinaryResult::Frame : EJSONLiveLinkBinaryResult::Invalid;
+		break;
+	case EJSONLiveLinkPacketType::Keyframe:
+		Result = DecodeBinaryKeyframe(Reader, *Subject, OutFrameData);
+		break;
+	case EJSONLiveLinkPacketType::Delta:
+		Result = DecodeBinaryDelta(Reader, *Subject, OutFrameData);
+		break;
+	default:
+		Result = EJSONLiveLinkBinaryResult::Invalid;
+		break;
+	}
+
+	if (Result == EJSONLiveLinkBinaryResult::RequestKeyframe)
+	{
+		// Echo the subject and schema ids back along with the last sequence we hold
+		FJSONLiveLinkBinaryWriter Writer(KeyframeRequest, JSONLiveLinkProtocol::KeyframeRequestSize);
+		Writer.Write(JSONLiveLinkProtocol::BinaryMagic);
+		Writer.Write(JSONLiveLinkProtocol::BinaryVersion);
+		Writer.Write((uint8)EJSONLiveLinkPacketType::KeyframeRequest);
+		Writer.Write((uint16)EJSONLiveLinkPacketFlags::None);
+		Writer.Write(SubjectId);
+		Writer.Write(SchemaId);
+		Writer.Write(Subject->Sequence);
+	}
+
+	OutSubjectName = Subject->SubjectName;
+	OutSchemaHash = GetMaskedSchemaHash(Subject->Mask, Subject->SchemaHash);
+	LastStaticData = Subject->Mask.bActive ? &Subject->Mask.StaticData : &Subject->StaticData;
+	return Result;
+}
+
+bool FJSONLiveLinkDecoder::DecodeBinarySchema(FJSONLiveLinkBinaryReader& Reader, const uint8* Data, int32 Size, EJSONLiveLinkPacketFlags Flags, const FJSONLiveLinkBinarySubjectKey& Key, uint32 SchemaId)
+{
+	// Senders repeat the schema for late joiners, don't resolve the names again unless it changed
+	const uint32 SchemaHash = FCrc::MemCrc32(Data + JSONLiveLinkProtocol::HeaderSize, Size - JSONLiveLinkProtocol::HeaderSize, (uint32)Flags);
+	FJSONLiveLinkBinarySubject& Subject = BinarySubjects.FindOrAdd(Key);
+	if (Subject.SchemaId == SchemaId && Subject.SchemaHash == SchemaHash && !Subject.SubjectName.IsNone())
+	{
+		return true;
+	}
+
+	uint16 NumBones;
+	uint16 NumParameters;
+	FJSONLiveLinkStringView SubjectName;
+	if (!Reader.Read(NumBones) || !Reader.Read(NumParameters) || !Reader.ReadString(SubjectName))
+	{
+		BinarySubjects.Remove(Key);
+		return false;
+	}
+
+	Subject.StaticData.BoneNames.Reset(NumBones);
+	Subject.StaticData.BoneParents.Reset(NumBones);
+	Subject.StaticData.PropertyNames.Reset(NumParameters + 3);
+
+	for (int32 BoneIdx = 0; BoneIdx < NumBones; ++BoneIdx)
+	{
+		FJSONLiveLinkStringView BoneName;
+		int32 BoneParent;
+		if (!Reader.ReadString(BoneName) || !Reader.Read(BoneParent))
+		{
+			BinarySubjects.Remove(Key);
+			return false;
+		}
+		Subject.StaticData.BoneNames.Add(BoneName.ToName());
+		Subject.StaticData.BoneParents.Add(BoneParent);
+	}
+
+	for (int32 ParameterIdx = 0; ParameterIdx < NumParameters; ++ParameterIdx)
+	{
+		FJSONLiveLinkStringView ParameterName;
+		if (!Reader.ReadString(ParameterName))
+		{
+			BinarySubjects.Remove(Key);
+			return false;
+		}
+		Subject.StaticData.PropertyNames.Add(ParameterName.ToName());
+	}
+
+	Subject.bHeadRotation = EnumHasAnyFlags(Flags, EJSONLiveLinkPacketFlags::HeadRotation);
+	if (Subject.bHeadRotation)
+	{
+		Subject.StaticData.PropertyNames.Add(HeadRollName);
+		Subject.StaticData.PropertyNames.Add(HeadPitchName);
+		Subject.StaticData.PropertyNames.Add(HeadYawName);
+	}
+
+	Subject.SubjectName = SubjectName.ToName();
+	Subject.bHasKeyframe = false;
+	Subject.SchemaId = SchemaId;
+	Subject.SchemaHash = SchemaHash;
+	Subject.NumParameters = NumParameters;
+	BuildMask(Subject.StaticData, NumParameters, SchemaHash, Subject.Mask);
+	return true;
+}
+
+bool FJSONLiveLinkDecoder::DecodeBinaryFrame(FJSONLiveLinkBinaryReader& Reader, const FJSONLiveLinkBinarySubject& Subject, FLiveLinkAnimationFrameData& OutFrameData, bool bApplyMask)
+{
+	const int32 NumBones = Subject.StaticData.BoneNames.Num();
+
+	uint16 PacketNumBones;
+	uint16 PacketNumParameters;
+	if (!Reader.Read(PacketNumBones) || !Reader.Read(PacketNumParameters) || PacketNumBones != NumBones || PacketNumParameters != Subject.NumParameters)
+	{
+		return false;
+	}
+
+	const uint8* Locations = Reader.ReadFloats(3 * NumBones);
+	const uint8* Rotations = Reader.ReadFloats(4 * NumBones);
+	const uint8* Scales = Reader.ReadFloats(3 * NumBones);
+	const uint8* Values = Reader.ReadFloats(Subject.NumParameters);
+	if (Reader.HasError())
+	{
+		return false;
+	}
+
+	FQuat LastRotation;
+	if (NumBones > 0)
+	{
+		const uint8* Rotation = Rotations + 4 * sizeof(float) * (NumBones - 1);
+		LastRotation = FQuat(FJSONLiveLinkBinaryReader::GetFloat(Rotation, 0), FJSONLiveLinkBinaryReader::GetFloat(Rotation, 1), FJSONLiveLinkBinaryReader::GetFloat(Rotation, 2), FJSONLiveLinkBinaryReader::GetFloat(Rotation, 3));
+	}
+
+	const FJSONLiveLinkSubjectMask& Mask = Subject.Mask;
+	if (bApplyMask && Mask.bActive)
+	{
+		// Masked bones and parameters are never loaded
+		FJSONLiveLinkFramePool::SizeFrame(OutFrameData, Mask.StaticData.BoneNames.Num(), Mask.StaticData.PropertyNames.Num());
+		FTransform* Transforms = OutFrameData.Transforms.GetData();
+		for (int32 BoneIdx = 0; BoneIdx < NumBones; ++BoneIdx)
+		{
+			const int32 PushedIdx = Mask.BoneIndices[BoneIdx];
+			if (PushedIdx != INDEX_NONE)
+			{
+				Transforms[PushedIdx] = MakeBinaryTransform(Locations + 3 * sizeof(float) * BoneIdx, Rotations + 4 * sizeof(float) * BoneIdx, Scales + 3 * sizeof(float) * BoneIdx);
+			}
+		}
+
+		for (int32 ParameterIdx = 0; ParameterIdx < Subject.NumParameters; ++ParameterIdx)
+		{
+			const int32 PushedIdx = Mask.ParameterIndices[ParameterIdx];
+			if (PushedIdx != INDEX_NONE)
+			{
+				OutFrameData.PropertyValues[PushedIdx] = FJSONLiveLinkBinaryReader::GetFloat(Values, ParameterIdx);
+			}
+		}
+
+		AppendHeadRotation(Subject, NumBones > 0 ? &LastRotation : nullptr, Mask.NumParameters, OutFrameData);
+		return true;
+	}
+
+	FJSONLiveLinkFramePool::SizeFrame(OutFrameData, NumBones, Subject.StaticData.PropertyNames.Num());
+	FTransform* Transforms = OutFrameData.Transforms.GetData();
+	for (int32 BoneIdx = 0; BoneIdx < NumBones; ++BoneIdx)
+	{
+		Transforms[BoneIdx] = MakeBinaryTransform(Locations + 3 * sizeof(float) * BoneIdx, Rotations + 4 * sizeof(float) * BoneIdx, Scales + 3 * sizeof(float) * BoneIdx);
+	}
+
+	FMemory::Memcpy(OutFrameData.PropertyValues.GetData(), Values, Subject.NumParameters * sizeof(float));
+
+	AppendHeadRotation(Subject, NumBones > 0 ? &LastRotation : nullptr, Subject.NumParameters, OutFrameData);
+	return true;
+}
+
+EJSONLiveLinkBinaryResult FJSONLiveLinkDecoder::DecodeBinaryKeyframe(FJSONLiveLinkBinaryReader& Reader, FJSONLiveLinkBinarySubject& Subject, FLiveLinkAnimationFrameData& OutFrameData)
+{
+	uint32 Sequence;
+	if (!Reader.Read(Sequence))
+	{
+		return EJSONLiveLinkBinaryResult::Invalid;
+	}
+
+	LastTiming.Sequence = Sequence;
+	LastTiming.bHasSequence = true;
+	const int32 SequenceDelta = (int32)(Sequence - Subject.Sequence);
+	if (Subject.bHasKeyframe && SequenceDelta <= 0 && !FJSONLiveLinkSequenceTracker::IsRestart(SequenceDelta))
+	{
+		// Arrived after deltas newer than it were applied, going back to it would rewind the stream. A restarted sender
+		// repeats the same schema and counts from the start again, its keyframe replaces the old stream.
+		return EJSONLiveLinkBinaryResult::OutOfOrder;
+	}
+
+	// Decoded whole, following deltas may change what's masked out of this frame
+	if (!DecodeBinaryFrame(Reader, Subject, OutFrameData, false))
+	{
+		return EJSONLiveLinkBinaryResult::Invalid;
+	}
+
+	// Hold on to the keyframe, following deltas are applied on top of it
+	Subject.Transforms = OutFrameData.Transforms;
+	Subject.ParameterValues.SetNumUninitialized(Subject.NumParameters);
+	FMemory::Memcpy(Subject.ParameterValues.GetData(), OutFrameData.PropertyValues.GetData(), Subject.NumParameters * sizeof(float));
+	Subject.Sequence = Sequence;
+	Subject.bHasKeyframe = true;
+
+	ApplyMask(Subject.Mask, Subject.NumParameters, OutFrameData);
+	return EJSONLiveLinkBinaryResult::Frame;
+}
+
+EJSONLiveLinkBinaryResult FJSONLiveLinkDecoder::DecodeBinaryDelta(FJSONLiveLinkBinaryReader& Reader, FJSONLiveLinkBinarySubject& Subject, FLiveLinkAnimationFrameData& OutFrameData)
+{
+	uint32 Sequence;
+	uint16 NumChangedBones;
+	uint16 NumChangedParameters;
+	if (!Reader.Read(Sequence) || !Reader.Read(NumChangedBones) || !Reader.Read(NumChangedParameters))
+	{
+		return EJSONLiveLinkBinaryResult::Invalid;
+	}
+
+	LastTiming.Sequence = Sequence;
+	LastTiming.bHasSequence = true;
+
+	const int32 SequenceDelta = (int32)(Sequence - Subject.Sequence);
+	if (Subject.bHasKeyframe && SequenceDelta <= 0 && !FJSONLiveLinkSequenceTracker::IsRestart(SequenceDelta))
+	{
+		// Late or duplicate delta, the state already moved past it
+		return EJSONLiveLinkBinaryResult::OutOfOrder;
+	}
+
+	if (!Subject.bHasKeyframe || SequenceDelta != 1)
+	{
+		// A delta went missing, nothing can be reconstructed until the next keyframe
+		Subject.bHasKeyframe = false;
+
+		const double Now = FPlatformTime::Seconds();
+		if (Now - Subject.LastKeyframeRequestTime < JSONLiveLinkProtocol::KeyframeRequestInterval)
+		{
+			return EJSONLiveLinkBinaryResult::NoFrame;
+		}
+		Subject.LastKeyframeRequestTime = Now;
+		return EJSONLiveLinkBinaryResult::RequestKeyframe;
+	}
+
+	const uint8* BoneIndices = Reader.ReadBytes(NumChangedBones * sizeof(uint16));
+	const uint8* BoneValues = Reader.ReadFloats(10 * NumChangedBones);
+	const uint8* ParameterIndices = Reader.ReadBytes(NumChangedParameters * sizeof(uint16));
+	const uint8* ParameterValues = Reader.ReadFloats(NumChangedParameters);
+	if (Reader.HasError())
+	{
+		return EJSONLiveLinkBinaryResult::Invalid;
+	}
+
+	// Validate every index before touching the state so a bad packet can't leave it half applied
+	const int32 NumBones = Subject.Transforms.Num();
+	for (int32 ChangeIdx = 0; ChangeIdx < NumChangedBones; ++ChangeIdx)
+	{
+		if (FJSONLiveLinkBinaryReader::GetUInt16(BoneIndices, ChangeIdx) >= NumBones)
+		{
+			return EJSONLiveLinkBinaryResult::Invalid;
+		}
+	}
+	for (int32 ChangeIdx = 0; ChangeIdx < NumChangedParameters; ++ChangeIdx)
+	{
+		if (FJSONLiveLinkBinaryReader::GetUInt16(ParameterIndices, ChangeIdx) >= Subject.NumParameters)
+		{
+			return EJSONLiveLinkBinaryResult::Invalid;
+		}
+	}
+
+	for (int32 ChangeIdx = 0; ChangeIdx < NumChangedBones; ++ChangeIdx)
+	{
+		const int32 BoneIdx = FJSONLiveLinkBinaryReader::GetUInt16(BoneIndices, ChangeIdx);
+		const uint8* Values = BoneValues + 10 * sizeof(float) * ChangeIdx;
+		Subject.Transforms[BoneIdx] = MakeBinaryTransform(Values, Values + 3 * sizeof(float), Values + 7 * sizeof(float));
+	}
+
+	for (int32 ChangeIdx = 0; ChangeIdx < NumChangedParameters; ++ChangeIdx)
+	{
+		Subject.ParameterValues[FJSONLiveLinkBinaryReader::GetUInt16(ParameterIndices, ChangeIdx)] = FJSONLiveLinkBinaryReader::GetFloat(ParameterValues, ChangeIdx);
+	}
+
+	Subject.Sequence = Sequence;
+
+	FJSONLiveLinkFramePool::SizeFrame(OutFrameData, NumBones, Subject.StaticData.PropertyNames.Num());
+	FMemory::Memcpy(OutFrameData.Transforms.GetData(), Subject.Transforms.GetData(), NumBones * sizeof(FTransform));
+	FMemory::Memcpy(OutFrameData.PropertyValues.GetData(), Subject.ParameterValues.GetData(), Subject.NumParameters * sizeof(float));
+	const FQuat LastRotation = NumBones > 0 ? Subject.Transforms.Last().GetRotation() : FQuat::Identity;
+	AppendHeadRotation(Subject, NumBones > 0 ? &LastRotation : nullptr, Subject.NumParameters, OutFrameData);
+	ApplyMask(Subject.Mask, Subject.NumParameters, OutFrameData);
+	return EJSONLiveLinkBinaryResult::Frame;
+}
+
+void FJSONLiveLinkDecoder::AppendHeadRotation(const FJSONLiveLinkBinarySubject& Subject, const FQuat* LastRotation, int32 HeadIdx, FLiveLinkAnimationFrameData& OutFrameData)
+{
+	if (Subject.bHeadRotation)
+	{
+		HeadRoll = 0;
+		HeadPitch = 0;
+		HeadYaw = 0;
+		if (LastRotation != nullptr)
+		{
+			SetHeadRotation(LastRotation->X, LastRotation->Y, LastRotation->Z, LastRotation->W);
+		}
+		OutFrameData.PropertyValues[HeadIdx] = HeadRoll;
+		OutFrameData.PropertyValues[HeadIdx + 1] = HeadPitch;
+		OutFrameData.PropertyValues[HeadIdx + 2] = HeadYaw;
+	}
+}
+
+void FJSONLiveLinkDecoder::UpdateHeadRotation()
+{
+	HeadRoll = 0;
+	HeadPitch = 0;
+	HeadYaw = 0;
+	if (bHasHeadBone)
+	{
+		SetHeadRotation(HeadBoneRotation[0], HeadBoneRotation[1], HeadBoneRotation[2], HeadBoneRotation[3]);
+	}
+}
+
+void FJSONLiveLinkDecoder::SetHeadRotation(double qx, double qy, double qz, double qw)
+{
+	HeadRoll = -atan2(2.0*(qx*qy + qw*qz), qw*qw + qx*qx - qy*qy - qz*qz);
+	// HeadPitch = asin(-2.0*(qx*qz - qw*qy));
+	// HeadYaw  = atan2(2.0*(qy*qz + qw*qx), qw*qw - qx*qx - qy*qy + qz*qz);
+	HeadPitch = atan2(2.0*(qy*qz + qw*qx), qw*qw - qx*qx - qy*qy + qz*qz);
+	HeadYaw = -asin(-2.0*(qx*qz - qw*qy));
+}
@@ -0,0 +1,300 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "JSONLiveLinkProtocol.h"
+#include "Roles/LiveLinkAnimationTypes.h"
+
+class FJSONLiveLinkBinaryReader;
+class FJSONLiveLinkJsonReader;
+struct FJSONLiveLinkStringView;
+
+/** Members of the subject, bone and parameter objects */
+enum class EJSONLiveLinkField : uint8
+{
+	Bone,
+	Parameter,
+	Name,
+	Parent,
+	Location,
+	Rotation,
+	Scale,
+	Value,
+	Timestamp,
+	Frame,
+	Sequence,
+	Unknown,
+};
+
+/**
+ * Which bones and parameters of a subject's packets are pushed, built from its full static data and the decoder's filter.
+ * Masked bones are taken out of the hierarchy, their children are parented to the nearest ancestor that's kept.
+ */
+struct FJSONLiveLinkSubjectMask
+{
+	// False when nothing is masked, frames are then pushed as decoded and the other members are empty
+	bool bActive = false;
+
+	// Schema and filter the mask was built for, it's only rebuilt when either changes
+	uint32 BuiltForHash = 0;
+	bool bBuilt = false;
+
+	// Index in the pushed frame of each bone and parameter of the packets, INDEX_NONE when masked
+	TArray<int32> BoneIndices;
+	TArray<int32> ParameterIndices;
+
+	// Parameters kept, any derived properties follow them
+	int32 NumParameters = 0;
+
+	// Static data pushed for the subject
+	FLiveLinkSkeletonStaticData StaticData;
+};
+
+/**
+ * Layout of a subject's packets learned from the first one decoded.
+ * Once learned, packets with the same member order and names are decoded positionally in a single pass.
+ */
+struct FJSONLiveLinkSubjectLayout
+{
+	// Static data described by the packets
+	FLiveLinkSkeletonStaticData StaticData;
+
+	// Hash of the bone names, parents and property names
+	uint32 SchemaHash = 0;
+
+	// Whether the subject can be decoded positionally, false until learned and when the packets contain unknown members
+	bool bCompiled = false;
+
+	// Member order of the subject object, and of every one of its bone and parameter objects
+	TArray<EJSONLiveLinkField> SubjectFields;
+	TArray<EJSONLiveLinkField> BoneFields;
+	TArray<EJSONLiveLinkField> ParameterFields;
+
+	// Raw bone and parameter names as they appear in the packet, NameOffsets has one extra entry marking the end
+	TArray<uint8> NameBytes;
+	TArray<int32> NameOffsets;
+
+	// Names the previous generic decode resolved, indexed like NameOffsets, reused while their raw bytes stay the same
+	TArray<uint8> CachedNameBytes;
+	TArray<int32> CachedNameOffsets;
+	TArray<FName> CachedNames;
+
+	int32 NumParameters = 0;
+	bool bHasParameters = false;
+
+	FJSONLiveLinkSubjectMask Mask;
+};
+
+/** A subject announced by a binary schema packet */
+struct FJSONLiveLinkBinarySubject
+{
+	FName SubjectName;
+
+	uint32 SchemaId = 0;
+
+	// Hash of the schema packet
+	uint32 SchemaHash = 0;
+
+	FLiveLinkSkeletonStaticData StaticData;
+
+	int32 NumParameters = 0;
+	bool bHeadRotation = false;
+
+	// Delta mode, the last reconstructed frame that deltas are applied to. Parameter values exclude the head rotation.
+	TArray<FTransform> Transforms;
+	TArray<float> ParameterValues;
+	uint32 Sequence = 0;
+
+	// False until a keyframe arrives, and again as soon as a delta goes missing
+	bool bHasKeyframe = false;
+
+	FJSONLiveLinkSubjectMask Mask;
+
+	double LastKeyframeRequestTime = 0;
+};
+
+/** Binary subject ids are only unique per sender, two senders counting from the same id mustn't share a subject */
+struct FJSONLiveLinkBinarySubjectKey
+{
+	FIPv4Endpoint Sender;
+	uint32 SubjectId = 0;
+
+	bool operator==(const FJSONLiveLinkBinarySubjectKey& Other) const { return SubjectId == Other.SubjectId && Sender == Other.Sender; }
+
+	friend uint32 GetTypeHash(const FJSONLiveLinkBinarySubjectKey& Key) { return HashCombine(GetTypeHash(Key.Sender), Key.SubjectId); }
+};
+
+/** Sender timing and ordering optionally carried by a subject's packet */
+struct FJSONLiveLinkFrameTiming
+{
+	// Seconds on the sender's clock when the frame was captured
+	double Timestamp = 0;
+
+	// Frame number at the source's frame rate
+	int64 Frame = 0;
+
+	// Increases by one per packet of the subject
+	uint32 Sequence = 0;
+
+	bool bHasTimestamp = false;
+	bool bHasFrame = false;
+	bool bHasSequence = false;
+};
+
+enum class EJSONLiveLinkBinaryResult : uint8
+{
+	// A subject frame was decoded
+	Frame,
+
+	// The packet was consumed without producing a frame, e.g. a schema
+	NoFrame,
+
+	// Malformed packet, or a frame for a subject whose schema hasn't been received
+	Invalid,
+
+	// A delta couldn't be applied because the stream has a gap, GetKeyframeRequest() should be sent back to the sender
+	RequestKeyframe,
+
+	// A late or duplicate keyframe or delta the stream already moved past, GetTiming() has its sequence
+	OutOfOrder,
+};
+
+/**
+ * Decodes JSON subjects, {Bone:[{Name,Parent,Location,Rotation,Scale}], Parameter:[{Name,Value}]} with optional
+ * Timestamp, Frame and Sequence numbers, and the binary packets of JSONLiveLinkProtocol.h into LiveLink animation data.
+ */
+class FJSONLiveLinkDecoder
+{
+public:
+
+	/**
+	 * Decodes the subject object at the reader's position, writing bone transforms and property values into OutFrameData.
+	 * OutSchemaHash covers everything in the static data so it only needs to be pushed again when the hash changes.
+	 * Returns false if the json isn't in the expected format.
+	 */
+	bool DecodeSubject(FJSONLiveLinkJsonReader& Reader, FName SubjectName, FLiveLinkAnimationFrameData& OutFrameData, uint32& OutSchemaHash);
+
+	/**
+	 * Limits what's decoded to the subjects, bones and parameters named, an empty list allows all of them.
+	 * Masked values are skipped without being parsed, and masked bones and parameters are left out of the static data.
+	 */
+	void SetFilter(const TArray<FName>& Subjects, const TArray<FName>& Bones, const TArray<FName>& Parameters);
+
+	// Whether the filter lets the subject through, JSON subjects that don't pass should be skipped rather than decoded
+	bool IsSubjectAllowed(FName SubjectName) const { return SubjectFilter.Num() == 0 || SubjectFilter.Contains(SubjectName); }
+
+	// Resolves the top-level key of a subject, names already seen are found by their raw bytes without touching the name table
+	FName FindSubjectName(const FJSONLiveLinkStringView& SubjectKey);
+
+	// Whether the datagram is a binary packet rather than JSON text
+	static bool IsBinaryPacket(const uint8* Data, int32 Size);
+
+	// Whether the datagram is a binary schema, keyframe or delta, which the packets after it depend on
+	static bool IsDependedOnPacket(const uint8* Data, int32 Size);
+
+	/**
+	 * Identifies the subjects a datagram carries without decoding it, so a queued packet can be skipped when a newer one
+	 * for the same subjects is behind it. Returns 0 for packets that must never be skipped: schemas, keyframes and deltas,
+	 * which later packets depend on, and anything malformed. JSON packets are keyed by their whole set of subjects, so a
+	 * packet only supersedes older ones carrying exactly the same subjects: {"A":..} never skips an older {"A":..,"B":..}.
+	 * Binary packets are keyed by their sender and subject id, like the subjects they're decoded against.
+	 */
+	static uint32 GetCoalesceKey(const uint8* Data, int32 Size, const FIPv4Endpoint& Sender);
+
+	// Decodes a binary packet, schema packets are remembered per sender and frame packets decoded against its schemas
+	EJSONLiveLinkBinaryResult DecodeBinary(const uint8* Data, int32 Size, const FIPv4Endpoint& Sender, FName& OutSubjectName, FLiveLinkAnimationFrameData& OutFrameData, uint32& OutSchemaHash);
+
+	// Static data of the most recently decoded subject
+	const FLiveLinkSkeletonStaticData& GetStaticData() const { return *LastStaticData; }
+
+	// Static data of a JSON subject decoded before, stays valid until another new subject is decoded
+	const FLiveLinkSkeletonStaticData& GetStaticData(FName SubjectName) const;
+
+	// Timing of the most recently decoded subject
+	const FJSONLiveLinkFrameTiming& GetTiming() const { return LastTiming; }
+
+	// Packet asking the sender for a keyframe, valid after DecodeBinary returned RequestKeyframe
+	const uint8* GetKeyframeRequest() const { return KeyframeRequest; }
+
+private:
+
+	// Decodes against the learned layout, fails as soon as the packet deviates from it
+	bool DecodeCompiled(FJSONLiveLinkJsonReader& Reader, const FJSONLiveLinkSubjectLayout& Layout, FLiveLinkAnimationFrameData& OutFrameData);
+	// A null OutTransform or OutValue skips the values, only checking the names still match
+	bool DecodeBoneCompiled(FJSONLiveLinkJsonReader& Reader, const FJSONLiveLinkSubjectLayout& Layout, int32 BoneIdx, FTransform* OutTransform);
+	bool DecodeParameterCompiled(FJSONLiveLinkJsonReader& Reader, const FJSONLiveLinkSubjectLayout& Layout, int32 ParameterIdx, float* OutValue);
+
+	// Decodes any valid packet, learning the layout as it goes
+	bool DecodeGeneric(FJSONLiveLinkJsonReader& Reader, FJSONLiveLinkSubjectLayout& Layout, FLiveLinkAnimationFrameData& OutFrameData);
+	bool DecodeBone(FJSONLiveLinkJsonReader& Reader, FJSONLiveLinkSubjectLayout& Layout, FLiveLinkAnimationFrameData& OutFrameData);
+	bool DecodeParameter(FJSONLiveLinkJsonReader& Reader, FJSONLiveLinkSubjectLayout& Layout, FLiveLinkAnimationFrameData& OutFrameData);
+
+	// Records the member order of one bone or parameter object, the layout can't be compiled unless they all match
+	static void LearnFields(const TArray<EJSONLiveLinkField, TInlineAllocator<8>>& Fields, bool bFirst, TArray<EJSONLiveLinkField>& LayoutFields, bool& bCompiled);
+	// Appends a bone or parameter name to the layout and resolves it, from the layout's cache when possible
+	static FName AddName(FJSONLiveLinkSubjectLayout& Layout, const FJSONLiveLinkStringView& Name);
+
+	// Reads a Timestamp, Frame or Sequence member's value
+	bool DecodeTiming(FJSONLiveLinkJsonReader& Reader, EJSONLiveLinkField Field);
+
+	bool DecodeBinarySchema(FJSONLiveLinkBinaryReader& Reader, const uint8* Data, int32 Size, EJSONLiveLinkPacketFlags Flags, const FJSONLiveLinkBinarySubjectKey& Key, uint32 SchemaId);
+	// With bApplyMask only the bones and parameters the subject's mask keeps are loaded, otherwise the frame is decoded whole
+	bool DecodeBinaryFrame(FJSONLiveLinkBinaryReader& Reader, const FJSONLiveLinkBinarySubject& Subject, FLiveLinkAnimationFrameData& OutFrameData, bool bApplyMask);
+	EJSONLiveLinkBinaryResult DecodeBinaryKeyframe(FJSONLiveLinkBinaryReader& Reader, FJSONLiveLinkBinarySubject& Subject, FLiveLinkAnimationFrameData& OutFrameData);
+	EJSONLiveLinkBinaryResult DecodeBinaryDelta(FJSONLiveLinkBinaryReader& Reader, FJSONLiveLinkBinarySubject& Subject, FLiveLinkAnimationFrameData& OutFrameData);
+	// Writes the head rotation properties from HeadIdx on, derived from the rotation of the subject's last bone if it has any
+	void AppendHeadRotation(const FJSONLiveLinkBinarySubject& Subject, const FQuat* LastRotation, int32 HeadIdx, FLiveLinkAnimationFrameData& OutFrameData);
+
+	// Rebuilds the mask of a subject whose full static data has NumParameters parameters, if the schema or filter changed
+	void BuildMask(const FLiveLinkSkeletonStaticData& StaticData, int32 NumParameters, uint32 SchemaHash, FJSONLiveLinkSubjectMask& OutMask) const;
+
+	// Compacts a whole decoded frame down to what the mask keeps, derived properties included
+	static void ApplyMask(const FJSONLiveLinkSubjectMask& Mask, int32 NumParameters, FLiveLinkAnimationFrameData& InOutFrameData);
+
+	// Schema hash pushed for a subject, changes with the mask so the masked static data is pushed again
+	uint32 GetMaskedSchemaHash(const FJSONLiveLinkSubjectMask& Mask, uint32 SchemaHash) const { return Mask.bActive ? HashCombine(SchemaHash, FilterHash) : SchemaHash; }
+
+	// Derives the head rotation from HeadBoneRotation, zero without bones
+	void UpdateHeadRotation();
+
+	void SetHeadRotation(double qx, double qy, double qz, double qw);
+
+	struct FCachedSubjectName
+	{
+		TArray<uint8> RawBytes;
+		FName Name;
+	};
+
+	// Subject names by the raw bytes of their key
+	TArray<FCachedSubjectName> SubjectNames;
+
+	// Learned layout of every subject seen so far
+	TMap<FName, FJSONLiveLinkSubjectLayout> Layouts;
+
+	// Binary subjects by sender and subject id
+	TMap<FJSONLiveLinkBinarySubjectKey, FJSONLiveLinkBinarySubject> BinarySubjects;
+
+	TSet<FName> SubjectFilter;
+	TSet<FName> BoneFilter;
+	TSet<FName> ParameterFilter;
+
+	// Changes whenever the filter does
+	uint32 FilterHash = 0;
+
+	const FLiveLinkSkeletonStaticData* LastStaticData = nullptr;
+
+	FJSONLiveLinkFrameTiming LastTiming;
+
+	uint8 KeyframeRequest[JSONLiveLinkProtocol::KeyframeRequestSize];
+
+	// Head rotation derived from the bone rotations, exposed as extra properties
+	double HeadRoll;
+	double HeadPitch;
+	double HeadYaw;
+
+	// Rotation of the last JSON bone decoded, X Y Z W
+	double HeadBoneRotation[4];
+	bool bHasHeadBone;
+};
@@ -0,0 +1,143 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#include "JSONLiveLinkDecompressor.h"
+#include "JSONLiveLink.h"
+#include "JSONLiveLinkBinaryReader.h"
+#include "JSONLiveLinkProtocol.h"
+#include "Misc/Compression.h"
+#include "Misc/FileHelper.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "zlib.h"
+THIRD_PARTY_INCLUDES_END
+
+static void* ZAlloc(void* Opaque, uInt Items, uInt Size)
+{
+	return FMemory::Malloc(Items * Size);
+}
+
+static void ZFree(void* Opaque, void* Address)
+{
+	FMemory::Free(Address);
+}
+
+FJSONLiveLinkDecompressor::FJSONLiveLinkDecompressor()
+: Stream(MakeUnique<z_stream_s>())
+, bStreamInitialized(false)
+, bWarnedMissingDictionary(false)
+, bWarnedUnknownMethod(false)
+{
+	FMemory::Memzero(*Stream);
+	Stream->zalloc = &ZAlloc;
+	Stream->zfree = &ZFree;
+}
+
+FJSONLiveLinkDecompressor::~FJSONLiveLinkDecompressor()
+{
+	if (bStreamInitialized)
+	{
+		inflateEnd(Stream.Get());
+	}
+}
+
+bool FJSONLiveLinkDecompressor::LoadDictionary(const FString& Filename)
+{
+	if (!FFileHelper::LoadFileToArray(Dictionary, *Filename))
+	{
+		UE_LOG(LogJSONLiveLink, Error, TEXT("Failed to load compression dictionary %s"), *Filename);
+		Dictionary.Reset();
+		return false;
+	}
+	return true;
+}
+
+bool FJSONLiveLinkDecompressor::IsCompressedPacket(const uint8* Data, int32 Size)
+{
+	uint32 Magic = 0;
+	if (Size >= JSONLiveLinkProtocol::CompressedHeaderSize)
+	{
+		FMemory::Memcpy(&Magic, Data, sizeof(Magic));
+	}
+	return Magic == JSONLiveLinkProtocol::CompressedMagic;
+}
+
+bool FJSONLiveLinkDecompressor::Decompress(const uint8* Data, int32 Size, const uint8*& OutData, int32& OutSize)
+{
+	FJSONLiveLinkBinaryReader Reader(Data, Size);
+	uint32 Magic;
+	uint8 Method;
+	uint32 UncompressedSize;
+	if (!Reader.Read(Magic) || !Reader.Read(Method) || !Reader.Read(UncompressedSize) || UncompressedSize > (uint32)JSONLiveLinkProtocol::MaxStreamPacketSize)
+	{
+		NumFailed.Increment();
+		return false;
+	}
+
+	// Grows to the largest packet and stays there
+	if (Scratch.Num() < (int32)UncompressedSize)
+	{
+		Scratch.SetNumUninitialized(UncompressedSize, false);
+	}
+
+	const uint8* Compressed = Data + Reader.GetPosition();
+	const int32 CompressedSize = Size - Reader.GetPosition();
+	bool bSuccess = false;
+	switch ((EJSONLiveLinkCompression)Method)
+	{
+	case EJSONLiveLinkCompression::Zlib:
+		bSuccess = Inflate(Compressed, CompressedSize, Scratch.GetData(), UncompressedSize);
+		break;
+	case EJSONLiveLinkCompression::LZ4:
+		bSuccess = FCompression::UncompressMemory(NAME_LZ4, Scratch.GetData(), UncompressedSize, Compressed, CompressedSize);
+		break;
+	default:
+		if (!bWarnedUnknownMethod)
+		{
+			UE_LOG(LogJSONLiveLink, Warning, TEXT("Dropping packets compressed with unknown method %d"), Method);
+			bWarnedUnknownMethod = true;
+		}
+		break;
+	}
+
+	if (!bSuccess)
+	{
+		NumFailed.Increment();
+		return false;
+	}
+	OutData = Scratch.GetData();
+	OutSize = UncompressedSize;
+	return true;
+}
+
+bool FJSONLiveLinkDecompressor::Inflate(const uint8* Data, int32 Size, uint8* OutData, int32 OutSize)
+{
+	// Resetting keeps the window allocated by the first packet
+	const int InitResult = bStreamInitialized ? inflateReset(Stream.Get()) : inflateInit(Stream.Get());
+	if (InitResult != Z_OK)
+	{
+		return false;
+	}
+	bStreamInitialized = true;
+
+	Stream->next_in = (Bytef*)Data;
+	Stream->avail_in = Size;
+	Stream->next_out = OutData;
+	Stream->avail_out = OutSize;
+
+	int Result = inflate(Stream.Get(), Z_FINISH);
+	if (Result == Z_NEED_DICT)
+	{
+		// Fails with Z_DATA_ERROR if the stream was deflated with a different dictionary
+		if (Dictionary.Num() == 0 || inflateSetDictionary(Stream.Get(), Dictionary.GetData(), Dictionary.Num()) != Z_OK)
+		{
+			if (!bWarnedMissingDictionary)
+			{
+				UE_LOG(LogJSONLiveLink, Warning, TEXT("Dropping packets deflated with a dictionary the source wasn't given, or a different one"));
+				bWarnedMissingDictionary = true;
+			}
+			return false;
+		}
+		Result = inflate(Stream.Get(), Z_FINISH);
+	}
+	return Result == Z_STREAM_END && Stream->total_out == (uLong)OutSize;
+}
@@ -0,0 +1,49 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeCounter.h"
+
+struct z_stream_s;
+
+/**
+ * Unwraps compressed packets, see JSONLiveLinkProtocol::CompressedMagic, into a scratch buffer that's reused by every packet.
+ * Each worker has its own so decompressing never allocates once the buffer has grown to the largest packet. The zlib stream
+ * is kept between packets and only reset, and carries the preset dictionary small packets are usually deflated with.
+ */
+class FJSONLiveLinkDecompressor
+{
+public:
+
+	FJSONLiveLinkDecompressor();
+	~FJSONLiveLinkDecompressor();
+
+	// Preset dictionary for zlib packets deflated with one, false if the file can't be read
+	bool LoadDictionary(const FString& Filename);
+
+	static bool IsCompressedPacket(const uint8* Data, int32 Size);
+
+	// Decompresses a compressed packet, OutData stays valid until the next call. False if it's corrupt or can't be decompressed.
+	bool Decompress(const uint8* Data, int32 Size, const uint8*& OutData, int32& OutSize);
+
+	// Compressed packets that failed to decompress
+	int32 GetNumFailed() const { return NumFailed.GetValue(); }
+
+private:
+
+	bool Inflate(const uint8* Data, int32 Size, uint8* OutData, int32 OutSize);
+
+	TArray<uint8> Scratch;
+
+	TArray<uint8> Dictionary;
+
+	TUniquePtr<z_stream_s> Stream;
+	bool bStreamInitialized;
+
+	// Only warned about once, every packet would fail the same way
+	bool bWarnedMissingDictionary;
+	bool bWarnedUnknownMethod;
+
+	FThreadSafeCounter NumFailed;
+};
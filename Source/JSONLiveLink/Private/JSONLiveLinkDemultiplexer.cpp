@@ -0,0 +1,193 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#include "JSONLiveLinkDemultiplexer.h"
+#include "JSONLiveLink.h"
+#include "JSONLiveLinkSource.h"
+#include "JSONLiveLinkWorker.h"
+
+#include "LiveLinkTypes.h"
+
+#include "Misc/ScopeLock.h"
+#include "Misc/ScopeRWLock.h"
+
+FJSONLiveLinkDemultiplexer::FJSONLiveLinkDemultiplexer(const FIPv4Endpoint& InEndpoint, const FJSONLiveLinkSourceSettings& InSettings, FJSONLiveLinkCaptureWriter* InCaptureWriter, FJSONLiveLinkDemultiplexer* Predecessor)
+: Endpoint(InEndpoint)
+, Settings(InSettings)
+, CaptureWriter(InCaptureWriter)
+, bStopped(false)
+{
+	// Workers start out decoding what they were configured with, the subjects follow whoever registers
+	SubjectFilter = Settings.AllowedSubjects;
+
+	if (!Settings.ReplayFilename.IsEmpty())
+	{
+		// Replayed datagrams are all read in order by a single worker
+		TUniquePtr<FJSONLiveLinkWorker> Worker = MakeUnique<FJSONLiveLinkWorker>(*this, FIPv4Endpoint(FIPv4Address::Any, 0), false, Settings);
+		if (Predecessor != nullptr && Predecessor->Workers.Num() > 0)
+		{
+			Worker->TakeCaches(*Predecessor->Workers[0]);
+		}
+		Worker->Start(0);
+		Workers.Add(MoveTemp(Worker));
+		return;
+	}
+
+	// Only Linux spreads datagrams sent to one port across several sockets, a stream is always read by one. Multicast
+	// datagrams are delivered to every joined socket instead, each worker would decode and push every frame.
+	const bool bMulticast = Endpoint.Address.IsMulticastAddress();
+	const bool bCanShareEndpoint = PLATFORM_LINUX && Settings.Transport == EJSONLiveLinkTransport::Udp && !bMulticast;
+	if (bMulticast && Settings.WorkersPerEndpoint > 1)
+	{
+		UE_LOG(LogJSONLiveLink, Warning, TEXT("%s is a multicast group, receiving on it with a single worker instead of %d"), *Endpoint.ToString(), Settings.WorkersPerEndpoint);
+	}
+	const int32 WorkersPerEndpoint = bCanShareEndpoint ? FMath::Max(Settings.WorkersPerEndpoint, 1) : 1;
+	const bool bReusePort = WorkersPerEndpoint > 1;
+
+	for (int32 WorkerIdx = 0; WorkerIdx < WorkersPerEndpoint; ++WorkerIdx)
+	{
+		TUniquePtr<FJSONLiveLinkWorker> Worker = MakeUnique<FJSONLiveLinkWorker>(*this, Endpoint, bReusePort, Settings);
+
+		// Senders are spread by the kernel, so with a different worker count some of them land on a worker that didn't know them
+		if (Predecessor != nullptr && WorkerIdx < Predecessor->Workers.Num())
+		{
+			Worker->TakeCaches(*Predecessor->Workers[WorkerIdx]);
+		}
+		Worker->Start(WorkerIdx);
+		Workers.Add(MoveTemp(Worker));
+	}
+}
+
+FJSONLiveLinkDemultiplexer::~FJSONLiveLinkDemultiplexer()
+{
+	// Stop every worker before joining any of them
+	Stop();
+	Workers.Reset();
+}
+
+bool FJSONLiveLinkDemultiplexer::IsValid() const
+{
+	bool bIsValid = Workers.Num() > 0;
+	for (const TUniquePtr<FJSONLiveLinkWorker>& Worker : Workers)
+	{
+		bIsValid &= Worker->IsValid();
+	}
+	return bIsValid;
+}
+
+void FJSONLiveLinkDemultiplexer::Stop()
+{
+	bStopped = true;
+	for (const TUniquePtr<FJSONLiveLinkWorker>& Worker : Workers)
+	{
+		Worker->Stop();
+	}
+}
+
+void FJSONLiveLinkDemultiplexer::Join()
+{
+	Stop();
+	for (const TUniquePtr<FJSONLiveLinkWorker>& Worker : Workers)
+	{
+		Worker->Join();
+	}
+}
+
+void FJSONLiveLinkDemultiplexer::AddSource(FJSONLiveLinkSource& Source, const TArray<FName>& AllowedSubjects)
+{
+	{
+		FRWScopeLock Lock(SourcesLock, SLT_Write);
+		Sources.Add({ &Source, TSet<FName>(AllowedSubjects) });
+	}
+	UpdateSubjectFilter();
+}
+
+int32 FJSONLiveLinkDemultiplexer::RemoveSource(FJSONLiveLinkSource& Source)
+{
+	int32 NumSources;
+	{
+		// Waits for any push to the source that's in flight
+		FRWScopeLock Lock(SourcesLock, SLT_Write);
+		Sources.RemoveAll([&Source](const FRegisteredSource& Registered) { return Registered.Source == &Source; });
+		NumSources = Sources.Num();
+	}
+	UpdateSubjectFilter();
+	return NumSources;
+}
+
+bool FJSONLiveLinkDemultiplexer::HasClient() const
+{
+	FRWScopeLock Lock(SourcesLock, SLT_ReadOnly);
+	for (const FRegisteredSource& Registered : Sources)
+	{
+		if (Registered.Source->HasClient())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void FJSONLiveLinkDemultiplexer::PushSubject(FName SubjectName, uint32 SchemaHash, const FLiveLinkSkeletonStaticData& StaticData, FLiveLinkFrameDataStruct&& FrameDataStruct)
+{
+	FRWScopeLock Lock(SourcesLock, SLT_ReadOnly);
+
+	// Copies for every receiving source but the last, which gets the decoded frame itself
+	FJSONLiveLinkSource* LastSource = nullptr;
+	for (const FRegisteredSource& Registered : Sources)
+	{
+		if (!Registered.Source->HasClient() || (Registered.AllowedSubjects.Num() > 0 && !Registered.AllowedSubjects.Contains(SubjectName)))
+		{
+			continue;
+		}
+
+		if (LastSource != nullptr)
+		{
+			FLiveLinkFrameDataStruct Copy;
+			Copy.InitializeWith(FrameDataStruct);
+			LastSource->PushSubject(SubjectName, SchemaHash, StaticData, MoveTemp(Copy));
+		}
+		LastSource = Registered.Source;
+	}
+
+	if (LastSource != nullptr)
+	{
+		LastSource->PushSubject(SubjectName, SchemaHash, StaticData, MoveTemp(FrameDataStruct));
+	}
+}
+
+void FJSONLiveLinkDemultiplexer::GetSubjectFilter(TArray<FName>& OutSubjects) const
+{
+	FScopeLock Lock(&SubjectFilterCriticalSection);
+	OutSubjects = SubjectFilter;
+}
+
+void FJSONLiveLinkDemultiplexer::UpdateSubjectFilter()
+{
+	TSet<FName> Union;
+	{
+		FRWScopeLock Lock(SourcesLock, SLT_ReadOnly);
+		if (Sources.Num() == 0)
+		{
+			// Nobody to push to, keep decoding what was last needed
+			return;
+		}
+
+		for (const FRegisteredSource& Registered : Sources)
+		{
+			if (Registered.AllowedSubjects.Num() == 0)
+			{
+				Union.Reset();
+				break;
+			}
+			Union.Append(Registered.AllowedSubjects);
+		}
+	}
+
+	TArray<FName> NewFilter = Union.Array();
+	FScopeLock Lock(&SubjectFilterCriticalSection);
+	if (NewFilter.Num() != SubjectFilter.Num() || NewFilter.ContainsByPredicate([this](FName Subject) { return !SubjectFilter.Contains(Subject); }))
+	{
+		SubjectFilter = MoveTemp(NewFilter);
+		SubjectFilterVersion.Increment();
+	}
+}
@@ -0,0 +1,99 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "JSONLiveLinkSourceSettings.h"
+
+class FJSONLiveLinkCaptureWriter;
+class FJSONLiveLinkSource;
+class FJSONLiveLinkWorker;
+struct FLiveLinkFrameDataStruct;
+struct FLiveLinkSkeletonStaticData;
+
+/**
+ * Receives and decodes one endpoint, or a replayed file, once for every source that registered with it. Decoded subjects are
+ * dispatched to each source whose subject filter lets them through, the frame is only copied for all but the last of them.
+ * Sources register and unregister from the GameThread while workers dispatch, the sources are guarded by a read/write lock.
+ */
+class FJSONLiveLinkDemultiplexer
+{
+public:
+
+	// Starts the workers receiving on Endpoint, or replaying the file when Settings has a ReplayFilename.
+	// CaptureWriter, when not null, must outlive the demultiplexer. Predecessor, when not null, is a joined demultiplexer
+	// whose workers hand their caches over to the workers started in its place.
+	FJSONLiveLinkDemultiplexer(const FIPv4Endpoint& InEndpoint, const FJSONLiveLinkSourceSettings& InSettings, FJSONLiveLinkCaptureWriter* InCaptureWriter = nullptr, FJSONLiveLinkDemultiplexer* Predecessor = nullptr);
+
+	~FJSONLiveLinkDemultiplexer();
+
+	bool IsValid() const;
+
+	// Stops every worker, only joined once the demultiplexer is destroyed
+	void Stop();
+
+	bool IsStopped() const { return bStopped; }
+
+	// Stops every worker and waits for them to exit, so their sockets are closed and their caches can be handed over
+	void Join();
+
+	// The source's frames are pushed until it's removed. AllowedSubjects empty receives every subject.
+	void AddSource(FJSONLiveLinkSource& Source, const TArray<FName>& AllowedSubjects);
+
+	// Once this returns the source is never pushed to again. Returns how many sources are left.
+	int32 RemoveSource(FJSONLiveLinkSource& Source);
+
+	// Whether any source has a client to push to
+	bool HasClient() const;
+
+	// Pushes a decoded frame to every source receiving the subject. Safe to call from any worker.
+	void PushSubject(FName SubjectName, uint32 SchemaHash, const FLiveLinkSkeletonStaticData& StaticData, FLiveLinkFrameDataStruct&& FrameDataStruct);
+
+	// Where workers append what they receive, null unless capturing
+	FJSONLiveLinkCaptureWriter* GetCaptureWriter() const { return CaptureWriter; }
+
+	// Union of what the sources receive, empty for every subject. Bumps its version whenever it changes.
+	int32 GetSubjectFilterVersion() const { return SubjectFilterVersion.GetValue(); }
+	void GetSubjectFilter(TArray<FName>& OutSubjects) const;
+
+	const FIPv4Endpoint& GetEndpoint() const { return Endpoint; }
+	const FJSONLiveLinkSourceSettings& GetSettings() const { return Settings; }
+	const TArray<TUniquePtr<FJSONLiveLinkWorker>>& GetWorkers() const { return Workers; }
+
+private:
+
+	void UpdateSubjectFilter();
+
+	FIPv4Endpoint Endpoint;
+
+	FJSONLiveLinkSourceSettings Settings;
+
+	FJSONLiveLinkCaptureWriter* CaptureWriter;
+
+	// Receive and decode threads, WorkersPerEndpoint of them or a single one when replaying
+	TArray<TUniquePtr<FJSONLiveLinkWorker>> Workers;
+
+	struct FRegisteredSource
+	{
+		FJSONLiveLinkSource* Source;
+
+		// Empty for every subject
+		TSet<FName> AllowedSubjects;
+	};
+
+	TArray<FRegisteredSource> Sources;
+
+	// Read while dispatching, written when sources come and go
+	mutable FRWLock SourcesLock;
+
+	TArray<FName> SubjectFilter;
+	FThreadSafeCounter SubjectFilterVersion;
+
+	// Guards SubjectFilter
+	mutable FCriticalSection SubjectFilterCriticalSection;
+
+	bool bStopped;
+};
@@ -0,0 +1,390 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#include "JSONLiveLinkEncoder.h"
+#include "JSONLiveLinkBinaryReader.h"
+#include "JSONLiveLinkBinaryWriter.h"
+
+// Bytes of the timing and sequence that may follow the header of a frame, keyframe or delta packet
+static const int32 MaxTimingSize = sizeof(double) + 2 * sizeof(uint32);
+
+// Quoted UTF-8 string, quotes, backslashes and control characters are escaped
+static void AppendJsonString(TArray<ANSICHAR>& OutText, const FString& String)
+{
+	FTCHARToUTF8 Utf8(*String);
+	OutText.Add('"');
+	for (int32 CharIdx = 0; CharIdx < Utf8.Length(); ++CharIdx)
+	{
+		const ANSICHAR Char = Utf8.Get()[CharIdx];
+		if ((uint8)Char < 0x20)
+		{
+			ANSICHAR Escaped[8];
+			FCStringAnsi::Snprintf(Escaped, sizeof(Escaped), "\\u%04x", (uint8)Char);
+			OutText.Append(Escaped, 6);
+			continue;
+		}
+		if (Char == '"' || Char == '\\')
+		{
+			OutText.Add('\\');
+		}
+		OutText.Add(Char);
+	}
+	OutText.Add('"');
+}
+
+static void AppendLiteral(TArray<ANSICHAR>& OutText, const ANSICHAR* Literal)
+{
+	OutText.Append(Literal, FCStringAnsi::Strlen(Literal));
+}
+
+FJSONLiveLinkEncoder::FJSONLiveLinkEncoder(const FString& InSubjectName, uint32 InSubjectId, const TArray<FString>& InBoneNames, const TArray<int32>& InBoneParents, const TArray<FString>& InParameterNames, uint32 InSchemaId)
+: SubjectName(InSubjectName)
+, SubjectId(InSubjectId)
+, SchemaId(InSchemaId)
+, BoneNames(InBoneNames)
+, BoneParents(InBoneParents)
+, ParameterNames(InParameterNames)
+, FrameSequence(0)
+, DeltaSequence(0)
+, KeyframeInterval(0)
+, FramesSinceKeyframe(0)
+, bKeyframeRequested(true)
+{
+	check(BoneNames.Num() == BoneParents.Num());
+	check(BoneNames.Num() <= MAX_uint16 && ParameterNames.Num() <= MAX_uint16);
+
+	AppendJsonString(JsonSubjectKey, SubjectName);
+	AppendLiteral(JsonSubjectKey, ":{");
+
+	for (int32 BoneIdx = 0; BoneIdx < BoneNames.Num(); ++BoneIdx)
+	{
+		TArray<ANSICHAR>& Prefix = JsonBonePrefixes.AddDefaulted_GetRef();
+		AppendLiteral(Prefix, "{\"Name\":");
+		AppendJsonString(Prefix, BoneNames[BoneIdx]);
+		ANSICHAR Parent[32];
+		FCStringAnsi::Snprintf(Parent, sizeof(Parent), ",\"Parent\":%d,\"Location\":", BoneParents[BoneIdx]);
+		AppendLiteral(Prefix, Parent);
+	}
+
+	for (const FString& ParameterName : ParameterNames)
+	{
+		TArray<ANSICHAR>& Prefix = JsonParameterPrefixes.AddDefaulted_GetRef();
+		AppendLiteral(Prefix, "{\"Name\":");
+		AppendJsonString(Prefix, ParameterName);
+		AppendLiteral(Prefix, ",\"Value\":");
+	}
+}
+
+void FJSONLiveLinkEncoder::BeginJsonPacket(TArray<uint8>& OutPacket)
+{
+	OutPacket.Reset();
+	OutPacket.Add('{');
+}
+
+void FJSONLiveLinkEncoder::AppendJsonSubject(TArray<uint8>& OutPacket, const TArray<FTransform>& Transforms, const TArray<float>& ParameterValues, const FJSONLiveLinkEncoderTiming& Timing)
+{
+	check(Transforms.Num() == BoneNames.Num() && ParameterValues.Num() == ParameterNames.Num());
+
+	if (OutPacket.Num() > 1)
+	{
+		OutPacket.Add(',');
+	}
+	AppendText(OutPacket, JsonSubjectKey);
+
+	if (Timing.bHasTimestamp)
+	{
+		AppendText(OutPacket, "\"Timestamp\":", 12);
+		AppendNumber(OutPacket, Timing.Timestamp, 17);
+		OutPacket.Add(',');
+	}
+	if (Timing.bHasFrame)
+	{
+		AppendText(OutPacket, "\"Frame\":", 8);
+		AppendNumber(OutPacket, Timing.Frame);
+		OutPacket.Add(',');
+	}
+	AppendText(OutPacket, "\"Sequence\":", 11);
+	AppendNumber(OutPacket, FrameSequence++);
+
+	AppendText(OutPacket, ",\"Bone\":[", 9);
+	for (int32 BoneIdx = 0; BoneIdx < Transforms.Num(); ++BoneIdx)
+	{
+		const FTransform& Transform = Transforms[BoneIdx];
+		const FVector Location = Transform.GetTranslation();
+		const FQuat Rotation = Transform.GetRotation();
+		const FVector Scale = Transform.GetScale3D();
+		const float Values[10] = { Location.X, Location.Y, Location.Z, Rotation.X, Rotation.Y, Rotation.Z, Rotation.W, Scale.X, Scale.Y, Scale.Z };
+
+		if (BoneIdx > 0)
+		{
+			OutPacket.Add(',');
+		}
+		AppendText(OutPacket, JsonBonePrefixes[BoneIdx]);
+		AppendNumberArray(OutPacket, Values, 3);
+		AppendText(OutPacket, ",\"Rotation\":", 12);
+		AppendNumberArray(OutPacket, Values + 3, 4);
+		AppendText(OutPacket, ",\"Scale\":", 9);
+		AppendNumberArray(OutPacket, Values + 7, 3);
+		OutPacket.Add('}');
+	}
+	OutPacket.Add(']');
+
+	if (ParameterNames.Num() > 0)
+	{
+		AppendText(OutPacket, ",\"Parameter\":[", 14);
+		for (int32 ParameterIdx = 0; ParameterIdx < ParameterValues.Num(); ++ParameterIdx)
+		{
+			if (ParameterIdx > 0)
+			{
+				OutPacket.Add(',');
+			}
+			AppendText(OutPacket, JsonParameterPrefixes[ParameterIdx]);
+			AppendNumber(OutPacket, ParameterValues[ParameterIdx]);
+			OutPacket.Add('}');
+		}
+		OutPacket.Add(']');
+	}
+	OutPacket.Add('}');
+}
+
+void FJSONLiveLinkEncoder::EndJsonPacket(TArray<uint8>& OutPacket)
+{
+	OutPacket.Add('}');
+}
+
+void FJSONLiveLinkEncoder::WriteSchema(TArray<uint8>& OutPacket) const
+{
+	// Strings are at most 3 UTF-8 bytes per character
+	int32 MaxSize = JSONLiveLinkProtocol::HeaderSize + 2 * sizeof(uint16) + sizeof(uint16) + 3 * SubjectName.Len();
+	for (const FString& BoneName : BoneNames)
+	{
+		MaxSize += sizeof(uint16) + 3 * BoneName.Len() + sizeof(int32);
+	}
+	for (const FString& ParameterName : ParameterNames)
+	{
+		MaxSize += sizeof(uint16) + 3 * ParameterName.Len();
+	}
+
+	OutPacket.SetNumUninitialized(MaxSize, false);
+	FJSONLiveLinkBinaryWriter Writer(OutPacket.GetData(), OutPacket.Num());
+	WriteHeader(Writer, EJSONLiveLinkPacketType::Schema, ParameterNames.Num() > 0 ? EJSONLiveLinkPacketFlags::HeadRotation : EJSONLiveLinkPacketFlags::None);
+	Writer.Write((uint16)BoneNames.Num());
+	Writer.Write((uint16)ParameterNames.Num());
+	Writer.WriteString(SubjectName);
+	for (int32 BoneIdx = 0; BoneIdx < BoneNames.Num(); ++BoneIdx)
+	{
+		Writer.WriteString(BoneNames[BoneIdx]);
+		Writer.Write((int32)BoneParents[BoneIdx]);
+	}
+	for (const FString& ParameterName : ParameterNames)
+	{
+		Writer.WriteString(ParameterName);
+	}
+	OutPacket.SetNum(Writer.GetPosition(), false);
+}
+
+void FJSONLiveLinkEncoder::WriteFrame(TArray<uint8>& OutPacket, const TArray<FTransform>& Transforms, const TArray<float>& ParameterValues, const FJSONLiveLinkEncoderTiming& Timing)
+{
+	check(Transforms.Num() == BoneNames.Num() && ParameterValues.Num() == ParameterNames.Num());
+
+	OutPacket.SetNumUninitialized(GetMaxBinaryPacketSize(), false);
+	FJSONLiveLinkBinaryWriter Writer(OutPacket.GetData(), OutPacket.Num());
+	WriteHeader(Writer, EJSONLiveLinkPacketType::Frame, GetTimingFlags(Timing) | EJSONLiveLinkPacketFlags::Sequence);
+	WriteTiming(Writer, Timing);
+	Writer.Write(FrameSequence++);
+
+	WriteFrameBody(Writer, Transforms, ParameterValues);
+	OutPacket.SetNum(Writer.GetPosition(), false);
+}
+
+void FJSONLiveLinkEncoder::WriteDelta(TArray<uint8>& OutPacket, const TArray<FTransform>& Transforms, const TArray<float>& ParameterValues, const FJSONLiveLinkEncoderTiming& Timing)
+{
+	check(Transforms.Num() == BoneNames.Num() && ParameterValues.Num() == ParameterNames.Num());
+
+	const bool bKeyframe = bKeyframeRequested || (KeyframeInterval > 0 && FramesSinceKeyframe >= KeyframeInterval);
+	if (bKeyframe)
+	{
+		OutPacket.SetNumUninitialized(GetMaxBinaryPacketSize(), false);
+		FJSONLiveLinkBinaryWriter Writer(OutPacket.GetData(), OutPacket.Num());
+		WriteHeader(Writer, EJSONLiveLinkPacketType::Keyframe, GetTimingFlags(Timing));
+		WriteTiming(Writer, Timing);
+		Writer.Write(++DeltaSequence);
+		WriteFrameBody(Writer, Transforms, ParameterValues);
+		OutPacket.SetNum(Writer.GetPosition(), false);
+
+		LastTransforms = Transforms;
+		LastParameterValues = ParameterValues;
+		FramesSinceKeyframe = 0;
+		bKeyframeRequested = false;
+		return;
+	}
+
+	ChangedBones.Reset();
+	for (int32 BoneIdx = 0; BoneIdx < Transforms.Num(); ++BoneIdx)
+	{
+		if (!Transforms[BoneIdx].Equals(LastTransforms[BoneIdx], 0.0f))
+		{
+			ChangedBones.Add(BoneIdx);
+			LastTransforms[BoneIdx] = Transforms[BoneIdx];
+		}
+	}
+	ChangedParameters.Reset();
+	for (int32 ParameterIdx = 0; ParameterIdx < ParameterValues.Num(); ++ParameterIdx)
+	{
+		if (ParameterValues[ParameterIdx] != LastParameterValues[ParameterIdx])
+		{
+			ChangedParameters.Add(ParameterIdx);
+			LastParameterValues[ParameterIdx] = ParameterValues[ParameterIdx];
+		}
+	}
+
+	OutPacket.SetNumUninitialized(GetMaxBinaryPacketSize(), false);
+	FJSONLiveLinkBinaryWriter Writer(OutPacket.GetData(), OutPacket.Num());
+	WriteHeader(Writer, EJSONLiveLinkPacketType::Delta, GetTimingFlags(Timing));
+	WriteTiming(Writer, Timing);
+	Writer.Write(++DeltaSequence);
+	Writer.Write((uint16)ChangedBones.Num());
+	Writer.Write((uint16)ChangedParameters.Num());
+	Writer.WriteBytes(ChangedBones.GetData(), ChangedBones.Num() * sizeof(uint16));
+	for (uint16 BoneIdx : ChangedBones)
+	{
+		const FTransform& Transform = Transforms[BoneIdx];
+		const FVector Location = Transform.GetTranslation();
+		const FQuat Rotation = Transform.GetRotation();
+		const FVector Scale = Transform.GetScale3D();
+		const float Values[10] = { Location.X, Location.Y, Location.Z, Rotation.X, Rotation.Y, Rotation.Z, Rotation.W, Scale.X, Scale.Y, Scale.Z };
+		Writer.WriteBytes(Values, sizeof(Values));
+	}
+	Writer.WriteBytes(ChangedParameters.GetData(), ChangedParameters.Num() * sizeof(uint16));
+	for (uint16 ParameterIdx : ChangedParameters)
+	{
+		Writer.Write(ParameterValues[ParameterIdx]);
+	}
+	OutPacket.SetNum(Writer.GetPosition(), false);
+	++FramesSinceKeyframe;
+}
+
+bool FJSONLiveLinkEncoder::HandleKeyframeRequest(const uint8* Data, int32 Size)
+{
+	FJSONLiveLinkBinaryReader Reader(Data, Size);
+	uint32 Magic;
+	uint8 Version;
+	uint8 PacketType;
+	uint16 Flags;
+	uint32 RequestSubjectId;
+	uint32 RequestSchemaId;
+	if (!Reader.Read(Magic) || !Reader.Read(Version) || !Reader.Read(PacketType) || !Reader.Read(Flags) || !Reader.Read(RequestSubjectId) || !Reader.Read(RequestSchemaId)
+		|| Magic != JSONLiveLinkProtocol::BinaryMagic || PacketType != (uint8)EJSONLiveLinkPacketType::KeyframeRequest
+		|| RequestSubjectId != SubjectId || RequestSchemaId != SchemaId)
+	{
+		return false;
+	}
+
+	bKeyframeRequested = true;
+	return true;
+}
+
+void FJSONLiveLinkEncoder::WriteHeader(FJSONLiveLinkBinaryWriter& Writer, EJSONLiveLinkPacketType PacketType, EJSONLiveLinkPacketFlags Flags) const
+{
+	Writer.Write(JSONLiveLinkProtocol::BinaryMagic);
+	Writer.Write(JSONLiveLinkProtocol::BinaryVersion);
+	Writer.Write((uint8)PacketType);
+	Writer.Write((uint16)Flags);
+	Writer.Write(SubjectId);
+	Writer.Write(SchemaId);
+}
+
+void FJSONLiveLinkEncoder::WriteTiming(FJSONLiveLinkBinaryWriter& Writer, const FJSONLiveLinkEncoderTiming& Timing)
+{
+	if (Timing.bHasTimestamp)
+	{
+		Writer.Write(Timing.Timestamp);
+	}
+	if (Timing.bHasFrame)
+	{
+		Writer.Write(Timing.Frame);
+	}
+}
+
+EJSONLiveLinkPacketFlags FJSONLiveLinkEncoder::GetTimingFlags(const FJSONLiveLinkEncoderTiming& Timing)
+{
+	EJSONLiveLinkPacketFlags Flags = EJSONLiveLinkPacketFlags::None;
+	if (Timing.bHasTimestamp)
+	{
+		Flags |= EJSONLiveLinkPacketFlags::Timestamp;
+	}
+	if (Timing.bHasFrame)
+	{
+		Flags |= EJSONLiveLinkPacketFlags::Frame;
+	}
+	return Flags;
+}
+
+void FJSONLiveLinkEncoder::WriteFrameBody(FJSONLiveLinkBinaryWriter& Writer, const TArray<FTransform>& Transforms, const TArray<float>& ParameterValues)
+{
+	Writer.Write((uint16)Transforms.Num());
+	Writer.Write((uint16)ParameterValues.Num());
+	for (const FTransform& Transform : Transforms)
+	{
+		const FVector Location = Transform.GetTranslation();
+		Writer.Write((float)Location.X);
+		Writer.Write((float)Location.Y);
+		Writer.Write((float)Location.Z);
+	}
+	for (const FTransform& Transform : Transforms)
+	{
+		const FQuat Rotation = Transform.GetRotation();
+		Writer.Write((float)Rotation.X);
+		Writer.Write((float)Rotation.Y);
+		Writer.Write((float)Rotation.Z);
+		Writer.Write((float)Rotation.W);
+	}
+	for (const FTransform& Transform : Transforms)
+	{
+		const FVector Scale = Transform.GetScale3D();
+		Writer.Write((float)Scale.X);
+		Writer.Write((float)Scale.Y);
+		Writer.Write((float)Scale.Z);
+	}
+	Writer.WriteBytes(ParameterValues.GetData(), ParameterValues.Num() * sizeof(float));
+}
+
+int32 FJSONLiveLinkEncoder::GetMaxBinaryPacketSize() const
+{
+	// A delta changing everything is the largest, its indices come on top of a frame's values
+	return JSONLiveLinkProtocol::HeaderSize + MaxTimingSize + 2 * sizeof(uint16)
+		+ BoneNames.Num() * (10 * sizeof(float) + sizeof(uint16)) + ParameterNames.Num() * (sizeof(float) + sizeof(uint16));
+}
+
+void FJSONLiveLinkEncoder::AppendText(TArray<uint8>& OutPacket, const ANSICHAR* Text, int32 Length)
+{
+	OutPacket.Append((const uint8*)Text, Length);
+}
+
+void FJSONLiveLinkEncoder::AppendNumber(TArray<uint8>& OutPacket, double Value, int32 SignificantDigits)
+{
+	// JSON has no NaN or infinity
+	if (!FMath::IsFinite(Value))
+	{
+		OutPacket.Add('0');
+		return;
+	}
+
+	// 9 digits are enough for a float to survive the round trip, a double takes 17
+	ANSICHAR Number[32];
+	const int32 Length = FCStringAnsi::Snprintf(Number, sizeof(Number), "%.*g", SignificantDigits, Value);
+	AppendText(OutPacket, Number, FMath::Clamp(Length, 0, (int32)sizeof(Number) - 1));
+}
+
+void FJSONLiveLinkEncoder::AppendNumberArray(TArray<uint8>& OutPacket, const float* Values, int32 NumValues)
+{
+	OutPacket.Add('[');
+	for (int32 ValueIdx = 0; ValueIdx < NumValues; ++ValueIdx)
+	{
+		if (ValueIdx > 0)
+		{
+			OutPacket.Add(',');
+		}
+		AppendNumber(OutPacket, Values[ValueIdx]);
+	}
+	OutPacket.Add(']');
+}
@@ -0,0 +1,58 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#include "JSONLiveLinkFramePool.h"
+#include "JSONLiveLinkStats.h"
+
+#include "Roles/LiveLinkAnimationTypes.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Frames Allocated"), STAT_JSONLiveLink_FramesAllocated, STATGROUP_JSONLiveLink);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Frames Recycled"), STAT_JSONLiveLink_FramesRecycled, STATGROUP_JSONLiveLink);
+
+FJSONLiveLinkFramePool::FJSONLiveLinkFramePool(int32 InMaxFrames)
+: MaxFrames(InMaxFrames)
+{
+	Frames.Reserve(MaxFrames);
+}
+
+FLiveLinkFrameDataStruct FJSONLiveLinkFramePool::Acquire()
+{
+	if (Frames.Num() > 0)
+	{
+		INC_DWORD_STAT(STAT_JSONLiveLink_FramesRecycled);
+		return Frames.Pop(false);
+	}
+
+	INC_DWORD_STAT(STAT_JSONLiveLink_FramesAllocated);
+	return FLiveLinkFrameDataStruct(FLiveLinkAnimationFrameData::StaticStruct());
+}
+
+void FJSONLiveLinkFramePool::Release(FLiveLinkFrameDataStruct&& FrameDataStruct)
+{
+	FLiveLinkAnimationFrameData* FrameData = FrameDataStruct.Cast<FLiveLinkAnimationFrameData>();
+	if (FrameData == nullptr || Frames.Num() >= MaxFrames)
+	{
+		return;
+	}
+
+	// Emptied without giving up the arrays' memory
+	FrameData->Transforms.Reset();
+	FrameData->PropertyValues.Reset();
+	FrameData->WorldTime = FLiveLinkWorldTime();
+	FrameData->MetaData = FLiveLinkMetaData();
+	Frames.Add(MoveTemp(FrameDataStruct));
+}
+
+void FJSONLiveLinkFramePool::SizeFrame(FLiveLinkAnimationFrameData& FrameData, int32 NumTransforms, int32 NumProperties)
+{
+	if (FrameData.Transforms.Max() < NumTransforms)
+	{
+		FrameData.Transforms.Reserve(NumTransforms);
+	}
+	FrameData.Transforms.SetNumUninitialized(NumTransforms, false);
+
+	if (FrameData.PropertyValues.Max() < NumProperties)
+	{
+		FrameData.PropertyValues.Reserve(NumProperties);
+	}
+	FrameData.PropertyValues.SetNumUninitialized(NumProperties, false);
+}
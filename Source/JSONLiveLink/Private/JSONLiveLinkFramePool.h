@@ -0,0 +1,34 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LiveLinkTypes.h"
+
+/**
+ * Animation frame structs recycled between the subjects a worker decodes. Frames pushed to LiveLink are owned by it from then
+ * on, what comes back are the frames decoded but never pushed, e.g. dropped as out of order or as part of an invalid packet,
+ * along with the memory of their transform and property arrays. Only used by the thread decoding at the time.
+ */
+class FJSONLiveLinkFramePool
+{
+public:
+
+	explicit FJSONLiveLinkFramePool(int32 InMaxFrames);
+
+	// An empty animation frame, a recycled one when there's any
+	FLiveLinkFrameDataStruct Acquire();
+
+	// Keeps the frame for the next Acquire, unless the pool is full
+	void Release(FLiveLinkFrameDataStruct&& FrameDataStruct);
+
+	// Sizes a frame's arrays to exactly what it holds when they need to grow, instead of with the usual slack, since frames
+	// pushed to LiveLink are never resized and stay buffered for a while
+	static void SizeFrame(FLiveLinkAnimationFrameData& FrameData, int32 NumTransforms, int32 NumProperties);
+
+private:
+
+	TArray<FLiveLinkFrameDataStruct> Frames;
+
+	int32 MaxFrames;
+};
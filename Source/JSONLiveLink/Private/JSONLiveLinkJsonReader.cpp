@@ -0,0 +1,369 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#include "JSONLiveLinkJsonReader.h"
+
+// Longest number token handed to the libc fallback
+#define MAX_NUMBER_TOKEN_LEN 128
+
+FName FJSONLiveLinkStringView::ToName() const
+{
+	bool bIsAnsi = !bHasEscapes;
+	for (int32 Idx = 0; bIsAnsi && Idx < Len; ++Idx)
+	{
+		bIsAnsi = Data[Idx] < 0x80;
+	}
+
+	if (bIsAnsi)
+	{
+		return FName(Len, (const ANSICHAR*)Data);
+	}
+
+	TArray<ANSICHAR, TInlineAllocator<NAME_SIZE>> Utf8;
+	if (!Unescape(Utf8))
+	{
+		return NAME_None;
+	}
+
+	FUTF8ToTCHAR Converted(Utf8.GetData(), Utf8.Num());
+	return FName(Converted.Length(), Converted.Get());
+}
+
+bool FJSONLiveLinkStringView::EqualsEscaped(const ANSICHAR* Literal, int32 LiteralLen) const
+{
+	TArray<ANSICHAR, TInlineAllocator<64>> Utf8;
+	return Unescape(Utf8) && Utf8.Num() == LiteralLen && FMemory::Memcmp(Utf8.GetData(), Literal, LiteralLen) == 0;
+}
+
+FJSONLiveLinkJsonReader::FJSONLiveLinkJsonReader(const uint8* InData, int32 InSize)
+: Data(InData)
+, Size(InSize)
+, Pos(0)
+, bAtContainerStart(false)
+, bError(false)
+{
+}
+
+bool FJSONLiveLinkJsonReader::ReadObjectStart()
+{
+	SkipWhitespace();
+	if (Pos >= Size || Data[Pos] != '{')
+	{
+		return Fail();
+	}
+	++Pos;
+	bAtContainerStart = true;
+	return true;
+}
+
+bool FJSONLiveLinkJsonReader::NextMember(FJSONLiveLinkStringView& OutKey)
+{
+	SkipWhitespace();
+	if (Pos >= Size)
+	{
+		return Fail();
+	}
+
+	if (Data[Pos] == '}')
+	{
+		++Pos;
+		bAtContainerStart = false;
+		return false;
+	}
+
+	if (!bAtContainerStart)
+	{
+		if (Data[Pos] != ',')
+		{
+			return Fail();
+		}
+		++Pos;
+	}
+
+	if (!ReadString(OutKey))
+	{
+		return false;
+	}
+
+	SkipWhitespace();
+	if (Pos >= Size || Data[Pos] != ':')
+	{
+		return Fail();
+	}
+	++Pos;
+	return true;
+}
+
+bool FJSONLiveLinkJsonReader::ReadArrayStart()
+{
+	SkipWhitespace();
+	if (Pos >= Size || Data[Pos] != '[')
+	{
+		return Fail();
+	}
+	++Pos;
+	bAtContainerStart = true;
+	return true;
+}
+
+bool FJSONLiveLinkJsonReader::NextElement()
+{
+	SkipWhitespace();
+	if (Pos >= Size)
+	{
+		return Fail();
+	}
+
+	if (Data[Pos] == ']')
+	{
+		++Pos;
+		bAtContainerStart = false;
+		return false;
+	}
+
+	if (!bAtContainerStart)
+	{
+		if (Data[Pos] != ',')
+		{
+			return Fail();
+		}
+		++Pos;
+	}
+	return true;
+}
+
+bool FJSONLiveLinkJsonReader::ReadString(FJSONLiveLinkStringView& OutString)
+{
+	SkipWhitespace();
+	if (Pos >= Size || Data[Pos] != '"')
+	{
+		return Fail();
+	}
+
+	const int32 Start = ++Pos;
+	bool bHasEscapes = false;
+	while (Pos < Size)
+	{
+		const uint8 C = Data[Pos];
+		if (C == '"')
+		{
+			OutString.Data = Data + Start;
+			OutString.Len = Pos - Start;
+			OutString.bHasEscapes = bHasEscapes;
+			++Pos;
+			bAtContainerStart = false;
+			return true;
+		}
+		else if (C == '\\')
+		{
+			bHasEscapes = true;
+			Pos += 2;
+		}
+		else if (C < 0x20)
+		{
+			// Control characters must be escaped
+			return Fail();
+		}
+		else
+		{
+			++Pos;
+		}
+	}
+	return Fail();
+}
+
+bool FJSONLiveLinkJsonReader::ReadNumber(double& OutNumber)
+{
+	// Powers of ten that are exactly representable as doubles
+	static const double ExactPowersOfTen[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	SkipWhitespace();
+	const int32 Start = Pos;
+
+	const bool bNegative = Pos < Size && Data[Pos] == '-';
+	if (bNegative)
+	{
+		++Pos;
+	}
+
+	uint64 Mantissa = 0;
+	int32 NumDigits = 0;
+	int32 Exponent = 0;
+
+	const int32 IntegerStart = Pos;
+	while (Pos < Size && Data[Pos] >= '0' && Data[Pos] <= '9')
+	{
+		Mantissa = Mantissa * 10 + (Data[Pos] - '0');
+		++NumDigits;
+		++Pos;
+	}
+	if (Pos == IntegerStart)
+	{
+		return Fail();
+	}
+
+	if (Pos < Size && Data[Pos] == '.')
+	{
+		const int32 FractionStart = ++Pos;
+		while (Pos < Size && Data[Pos] >= '0' && Data[Pos] <= '9')
+		{
+			Mantissa = Mantissa * 10 + (Data[Pos] - '0');
+			++NumDigits;
+			--Exponent;
+			++Pos;
+		}
+		if (Pos == FractionStart)
+		{
+			return Fail();
+		}
+	}
+
+	if (Pos < Size && (Data[Pos] == 'e' || Data[Pos] == 'E'))
+	{
+		++Pos;
+		const bool bNegativeExponent = Pos < Size && Data[Pos] == '-';
+		if (Pos < Size && (Data[Pos] == '-' || Data[Pos] == '+'))
+		{
+			++Pos;
+		}
+
+		const int32 ExponentStart = Pos;
+		int32 ExplicitExponent = 0;
+		while (Pos < Size && Data[Pos] >= '0' && Data[Pos] <= '9')
+		{
+			ExplicitExponent = FMath::Min(ExplicitExponent * 10 + (Data[Pos] - '0'), 100000);
+			++Pos;
+		}
+		if (Pos == ExponentStart)
+		{
+			return Fail();
+		}
+		Exponent += bNegativeExponent ? -ExplicitExponent : ExplicitExponent;
+	}
+
+	bAtContainerStart = false;
+
+	// When both the mantissa and the power of ten are exact a single multiply or divide is correctly rounded,
+	// which matches what strtod returns for the common short decimals
+	if (NumDigits <= 19 && Mantissa <= (1ull << 53) && Exponent >= -22 && Exponent <= 22)
+	{
+		double Value = (double)Mantissa;
+		Value = Exponent < 0 ? Value / ExactPowersOfTen[-Exponent] : Value * ExactPowersOfTen[Exponent];
+		OutNumber = bNegative ? -Value : Value;
+		return true;
+	}
+
+	const int32 TokenLen = Pos - Start;
+	if (TokenLen >= MAX_NUMBER_TOKEN_LEN)
+	{
+		return Fail();
+	}
+
+	ANSICHAR Token[MAX_NUMBER_TOKEN_LEN];
+	FMemory::Memcpy(Token, Data + Start, TokenLen);
+	Token[TokenLen] = '\0';
+	OutNumber = FCStringAnsi::Atod(Token);
+	return true;
+}
+
+bool FJSONLiveLinkJsonReader::ReadNumberArray(double* OutNumbers, int32 Count)
+{
+	if (!ReadArrayStart())
+	{
+		return false;
+	}
+
+	int32 NumRead = 0;
+	while (NextElement())
+	{
+		if (NumRead >= Count || !ReadNumber(OutNumbers[NumRead]))
+		{
+			return Fail();
+		}
+		++NumRead;
+	}
+	if (bError || NumRead != Count)
+	{
+		return Fail();
+	}
+	return true;
+}
+
+bool FJSONLiveLinkJsonReader::SkipValue()
+{
+	SkipWhitespace();
+	if (Pos >= Size)
+	{
+		return Fail();
+	}
+
+	switch (Data[Pos])
+	{
+	case '"':
+	{
+		FJSONLiveLinkStringView Unused;
+		return ReadString(Unused);
+	}
+	case '{':
+	case '[':
+		return SkipContainer();
+	case 't':
+		return SkipLiteral("true", 4);
+	case 'f':
+		return SkipLiteral("false", 5);
+	case 'n':
+		return SkipLiteral("null", 4);
+	default:
+	{
+		double Unused;
+		return ReadNumber(Unused);
+	}
+	}
+}
+
+bool FJSONLiveLinkJsonReader::SkipContainer()
+{
+	// Only brackets and strings are tracked, the skipped contents are never tokenized
+	int32 Depth = 0;
+	while (Pos < Size)
+	{
+		const uint8 C = Data[Pos++];
+		if (C == '"')
+		{
+			while (Pos < Size && Data[Pos] != '"')
+			{
+				Pos += Data[Pos] == '\\' ? 2 : 1;
+			}
+			++Pos;
+		}
+		else if (C == '{' || C == '[')
+		{
+			++Depth;
+		}
+		else if (C == '}' || C == ']')
+		{
+			if (--Depth == 0)
+			{
+				bAtContainerStart = false;
+				return true;
+			}
+		}
+	}
+	return Fail();
+}
+
+bool FJSONLiveLinkJsonReader::SkipLiteral(const ANSICHAR* Literal, int32 LiteralLen)
+{
+	if (Pos + LiteralLen > Size || FMemory::Memcmp(Data + Pos, Literal, LiteralLen) != 0)
+	{
+		return Fail();
+	}
+	Pos += LiteralLen;
+	bAtContainerStart = false;
+	return true;
+}
+
+#undef MAX_NUMBER_TOKEN_LEN
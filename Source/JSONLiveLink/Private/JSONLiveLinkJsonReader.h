@@ -0,0 +1,209 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** A string token pointing into the buffer being read, escape sequences are left in place */
+struct FJSONLiveLinkStringView
+{
+	const uint8* Data = nullptr;
+	int32 Len = 0;
+	bool bHasEscapes = false;
+
+	bool Equals(const ANSICHAR* Literal, int32 LiteralLen) const
+	{
+		if (bHasEscapes)
+		{
+			return EqualsEscaped(Literal, LiteralLen);
+		}
+		return Len == LiteralLen && FMemory::Memcmp(Data, Literal, LiteralLen) == 0;
+	}
+
+	template<int32 N>
+	bool Equals(const ANSICHAR (&Literal)[N]) const
+	{
+		return Equals(Literal, N - 1);
+	}
+
+	// Compares the raw bytes, as they appear in the buffer
+	bool RawEquals(const uint8* OtherData, int32 OtherLen) const
+	{
+		return Len == OtherLen && FMemory::Memcmp(Data, OtherData, OtherLen) == 0;
+	}
+
+	// Resolves the string, decoding escapes and UTF-8, into a name
+	FName ToName() const;
+
+	// Decodes escape sequences, if any, into UTF-8, returns false on a malformed escape
+	template<typename AllocatorType>
+	bool Unescape(TArray<ANSICHAR, AllocatorType>& OutUtf8) const;
+
+private:
+
+	bool EqualsEscaped(const ANSICHAR* Literal, int32 LiteralLen) const;
+};
+
+/**
+ * Pull reader over a UTF-8 JSON buffer.
+ * Tokens are parsed in place without building an FString or a FJsonValue tree, so reading does not allocate.
+ * Every method returns false on malformed input and flags the reader, use HasError() to tell the end of a
+ * container apart from an error. The reader is a plain value, copy it to remember a position to rewind to.
+ */
+class FJSONLiveLinkJsonReader
+{
+public:
+
+	FJSONLiveLinkJsonReader(const uint8* InData, int32 InSize);
+
+	// Consumes the '{' starting an object
+	bool ReadObjectStart();
+
+	// Moves to the next member of the current object and reads its key, returns false once the closing '}' is consumed
+	bool NextMember(FJSONLiveLinkStringView& OutKey);
+
+	// Consumes the '[' starting an array
+	bool ReadArrayStart();
+
+	// Moves to the next element of the current array, returns false once the closing ']' is consumed
+	bool NextElement();
+
+	bool ReadString(FJSONLiveLinkStringView& OutString);
+
+	bool ReadNumber(double& OutNumber);
+
+	// Reads an array which must contain exactly Count numbers
+	bool ReadNumberArray(double* OutNumbers, int32 Count);
+
+	// Skips over the next value of any type without tokenizing its contents
+	bool SkipValue();
+
+	bool HasError() const { return bError; }
+
+	int32 GetPosition() const { return Pos; }
+
+private:
+
+	void SkipWhitespace()
+	{
+		while (Pos < Size && (Data[Pos] == ' ' || Data[Pos] == '\t' || Data[Pos] == '\n' || Data[Pos] == '\r'))
+		{
+			++Pos;
+		}
+	}
+
+	bool Fail()
+	{
+		bError = true;
+		return false;
+	}
+
+	bool SkipContainer();
+	bool SkipLiteral(const ANSICHAR* Literal, int32 LiteralLen);
+
+	const uint8* Data;
+	int32 Size;
+	int32 Pos;
+
+	// True right after a '{' or '[', when no ',' is expected before the next member or element
+	bool bAtContainerStart;
+
+	bool bError;
+};
+
+template<typename AllocatorType>
+bool FJSONLiveLinkStringView::Unescape(TArray<ANSICHAR, AllocatorType>& OutUtf8) const
+{
+	OutUtf8.Reset(Len);
+
+	auto ParseHex4 = [this](int32 Idx, uint32& OutValue)
+	{
+		if (Idx + 4 > Len)
+		{
+			return false;
+		}
+		OutValue = 0;
+		for (int32 HexIdx = Idx; HexIdx < Idx + 4; ++HexIdx)
+		{
+			const uint8 C = Data[HexIdx];
+			uint32 Digit;
+			if (C >= '0' && C <= '9') { Digit = C - '0'; }
+			else if (C >= 'a' && C <= 'f') { Digit = C - 'a' + 10; }
+			else if (C >= 'A' && C <= 'F') { Digit = C - 'A' + 10; }
+			else { return false; }
+			OutValue = (OutValue << 4) | Digit;
+		}
+		return true;
+	};
+
+	for (int32 Idx = 0; Idx < Len; ++Idx)
+	{
+		if (!bHasEscapes || Data[Idx] != '\\')
+		{
+			OutUtf8.Add((ANSICHAR)Data[Idx]);
+			continue;
+		}
+
+		if (++Idx >= Len)
+		{
+			return false;
+		}
+
+		switch (Data[Idx])
+		{
+		case '"': OutUtf8.Add('"'); break;
+		case '\\': OutUtf8.Add('\\'); break;
+		case '/': OutUtf8.Add('/'); break;
+		case 'b': OutUtf8.Add('\b'); break;
+		case 'f': OutUtf8.Add('\f'); break;
+		case 'n': OutUtf8.Add('\n'); break;
+		case 'r': OutUtf8.Add('\r'); break;
+		case 't': OutUtf8.Add('\t'); break;
+		case 'u':
+		{
+			uint32 CodePoint;
+			if (!ParseHex4(Idx + 1, CodePoint))
+			{
+				return false;
+			}
+			Idx += 4;
+
+			// Combine surrogate pairs
+			uint32 LowSurrogate;
+			if (CodePoint >= 0xD800 && CodePoint <= 0xDBFF && Idx + 2 < Len && Data[Idx + 1] == '\\' && Data[Idx + 2] == 'u'
+				&& ParseHex4(Idx + 3, LowSurrogate) && LowSurrogate >= 0xDC00 && LowSurrogate <= 0xDFFF)
+			{
+				CodePoint = 0x10000 + ((CodePoint - 0xD800) << 10) + (LowSurrogate - 0xDC00);
+				Idx += 6;
+			}
+
+			if (CodePoint < 0x80)
+			{
+				OutUtf8.Add((ANSICHAR)CodePoint);
+			}
+			else if (CodePoint < 0x800)
+			{
+				OutUtf8.Add((ANSICHAR)(0xC0 | (CodePoint >> 6)));
+				OutUtf8.Add((ANSICHAR)(0x80 | (CodePoint & 0x3F)));
+			}
+			else if (CodePoint < 0x10000)
+			{
+				OutUtf8.Add((ANSICHAR)(0xE0 | (CodePoint >> 12)));
+				OutUtf8.Add((ANSICHAR)(0x80 | ((CodePoint >> 6) & 0x3F)));
+				OutUtf8.Add((ANSICHAR)(0x80 | (CodePoint & 0x3F)));
+			}
+			else
+			{
+				OutUtf8.Add((ANSICHAR)(0xF0 | (CodePoint >> 18)));
+				OutUtf8.Add((ANSICHAR)(0x80 | ((CodePoint >> 12) & 0x3F)));
+				OutUtf8.Add((ANSICHAR)(0x80 | ((CodePoint >> 6) & 0x3F)));
+				OutUtf8.Add((ANSICHAR)(0x80 | (CodePoint & 0x3F)));
+			}
+			break;
+		}
+		default:
+			return false;
+		}
+	}
+	return true;
+}
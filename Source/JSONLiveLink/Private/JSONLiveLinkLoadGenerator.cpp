@@ -0,0 +1,486 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#include "JSONLiveLink.h"
+#include "JSONLiveLinkEncoder.h"
+#include "JSONLiveLinkProtocol.h"
+#include "JSONLiveLinkSourceSettings.h"
+
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/ThreadSafeBool.h"
+#include "Misc/Parse.h"
+
+#include "Common/TcpSocketBuilder.h"
+#include "Common/UdpSocketBuilder.h"
+#include "IPAddress.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+#if !UE_BUILD_SHIPPING
+
+namespace JSONLiveLinkLoadGenerator
+{
+	enum class EMode : uint8
+	{
+		// Packets of as many subjects as fit
+		Json,
+
+		// A frame packet per subject and tick, schemas once a second
+		Binary,
+
+		// Keyframes and deltas per subject and tick, schemas once a second
+		Delta,
+	};
+
+	struct FOptions
+	{
+		FIPv4Endpoint Endpoint = FIPv4Endpoint(FIPv4Address(127, 0, 0, 1), 54321);
+		EJSONLiveLinkTransport Transport = EJSONLiveLinkTransport::Udp;
+		EMode Mode = EMode::Json;
+		int32 NumSubjects = 1;
+		int32 NumBones = 60;
+		int32 NumParameters = 0;
+		double Rate = 60.0;
+
+		// Stops after this long, 0 runs until stopped
+		double Seconds = 0.0;
+
+		// Fraction of the bones and parameters that move, the rest stay put so deltas have something to leave out
+		float Animated = 1.0f;
+
+		// Frames between keyframes in delta mode
+		int32 KeyframeInterval = 60;
+	};
+
+	static float AnimationValue(int64 Tick, int32 ValueIdx)
+	{
+		return FMath::Sin(Tick * 0.05f + ValueIdx * 0.37f);
+	}
+
+	/** Sends generated subjects to an endpoint at a fixed rate from its own thread, logging what it sent once a second */
+	class FGenerator : public FRunnable
+	{
+	public:
+
+		FGenerator(const FOptions& InOptions)
+		: Options(InOptions)
+		, Socket(nullptr)
+		, bStopping(false)
+		, Thread(nullptr)
+		{
+			for (int32 SubjectIdx = 0; SubjectIdx < Options.NumSubjects; ++SubjectIdx)
+			{
+				TArray<FString> BoneNames;
+				TArray<int32> BoneParents;
+				for (int32 BoneIdx = 0; BoneIdx < Options.NumBones; ++BoneIdx)
+				{
+					BoneNames.Add(FString::Printf(TEXT("bone_%d"), BoneIdx));
+					BoneParents.Add(BoneIdx - 1);
+				}
+
+				TArray<FString> ParameterNames;
+				for (int32 ParameterIdx = 0; ParameterIdx < Options.NumParameters; ++ParameterIdx)
+				{
+					ParameterNames.Add(FString::Printf(TEXT("blendshape_%d"), ParameterIdx));
+				}
+
+				FSubject& Subject = Subjects.AddDefaulted_GetRef();
+				Subject.Encoder = MakeUnique<FJSONLiveLinkEncoder>(FString::Printf(TEXT("LoadSubject_%d"), SubjectIdx), SubjectIdx + 1, BoneNames, BoneParents, ParameterNames);
+				Subject.Encoder->SetKeyframeInterval(Options.KeyframeInterval);
+				Subject.Transforms.Init(FTransform::Identity, Options.NumBones);
+				Subject.ParameterValues.Init(0.0f, Options.NumParameters);
+			}
+
+			Thread = FRunnableThread::Create(this, TEXT("JSON LiveLink Load Generator"));
+		}
+
+		virtual ~FGenerator()
+		{
+			if (Thread != nullptr)
+			{
+				Thread->Kill(true);
+				delete Thread;
+			}
+
+			if (Socket != nullptr)
+			{
+				Socket->Close();
+				ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+			}
+		}
+
+		// Begin FRunnable Interface
+
+		virtual bool Init() override
+		{
+			if (Options.Transport == EJSONLiveLinkTransport::Tcp)
+			{
+				Socket = FTcpSocketBuilder(TEXT("JSONLOADGENERATORSOCKET"))
+					.WithSendBufferSize(4 * 1024 * 1024);
+				if (Socket != nullptr)
+				{
+					TSharedRef<FInternetAddr> Addr = Options.Endpoint.ToInternetAddr();
+					if (!Socket->Connect(*Addr))
+					{
+						UE_LOG(LogJSONLiveLink, Error, TEXT("Load generator failed to connect to %s"), *Options.Endpoint.ToString());
+						return false;
+					}
+				}
+			}
+			else
+			{
+				// Bound to receive the keyframe requests sent back to it
+				Socket = FUdpSocketBuilder(TEXT("JSONLOADGENERATORSOCKET"))
+					.AsNonBlocking()
+					.BoundToPort(0)
+					.WithSendBufferSize(4 * 1024 * 1024);
+			}
+
+			if (Socket == nullptr)
+			{
+				UE_LOG(LogJSONLiveLink, Error, TEXT("Load generator failed to create a socket"));
+				return false;
+			}
+
+			DestinationAddr = Options.Endpoint.ToInternetAddr();
+			SenderAddr = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+			return true;
+		}
+
+		virtual uint32 Run() override
+		{
+			const double TickInterval = 1.0 / Options.Rate;
+			const double StartTime = FPlatformTime::Seconds();
+			double NextTickTime = StartTime;
+			double NextReportTime = StartTime + 1.0;
+			double NextSchemaTime = StartTime;
+
+			int32 NumPackets = 0;
+			int64 NumBytes = 0;
+			int32 NumLateTicks = 0;
+
+			for (int64 Tick = 0; !bStopping; ++Tick)
+			{
+				const double TickTime = FPlatformTime::Seconds();
+				if (Options.Seconds > 0.0 && TickTime - StartTime >= Options.Seconds)
+				{
+					break;
+				}
+
+				ReceiveKeyframeRequests();
+
+				FJSONLiveLinkEncoderTiming Timing;
+				Timing.Timestamp = TickTime;
+				Timing.Frame = (uint32)Tick;
+				Timing.bHasTimestamp = true;
+				Timing.bHasFrame = true;
+
+				for (FSubject& Subject : Subjects)
+				{
+					Animate(Subject, Tick);
+				}
+
+				if (Options.Mode == EMode::Json)
+				{
+					SendJsonPackets(Timing, NumPackets, NumBytes);
+				}
+				else
+				{
+					const bool bSendSchemas = TickTime >= NextSchemaTime;
+					if (bSendSchemas)
+					{
+						NextSchemaTime = TickTime + 1.0;
+					}
+
+					for (FSubject& Subject : Subjects)
+					{
+						if (bSendSchemas)
+						{
+							Subject.Encoder->WriteSchema(Packet);
+							Send(Packet, NumPackets, NumBytes);
+						}
+
+						if (Options.Mode == EMode::Delta)
+						{
+							Subject.Encoder->WriteDelta(Packet, Subject.Transforms, Subject.ParameterValues, Timing);
+						}
+						else
+						{
+							Subject.Encoder->WriteFrame(Packet, Subject.Transforms, Subject.ParameterValues, Timing);
+						}
+						Send(Packet, NumPackets, NumBytes);
+					}
+				}
+
+				// Ticks more than one behind are dropped rather than sent in a burst to catch up
+				NextTickTime += TickInterval;
+				const double Now = FPlatformTime::Seconds();
+				if (Now > NextTickTime + TickInterval)
+				{
+					++NumLateTicks;
+					NextTickTime = Now;
+				}
+				else if (NextTickTime > Now)
+				{
+					FPlatformProcess::SleepNoStats((float)(NextTickTime - Now));
+				}
+
+				if (Now >= NextReportTime)
+				{
+					const double Elapsed = Now - NextReportTime + 1.0;
+					UE_LOG(LogJSONLiveLink, Display, TEXT("Load generator: %.0f packets/s, %.2f MB/s, %d late ticks"),
+						NumPackets / Elapsed, NumBytes / Elapsed / (1024.0 * 1024.0), NumLateTicks);
+					NumPackets = 0;
+					NumBytes = 0;
+					NumLateTicks = 0;
+					NextReportTime = Now + 1.0;
+				}
+			}
+
+			UE_LOG(LogJSONLiveLink, Display, TEXT("Load generator stopped"));
+			return 0;
+		}
+
+		virtual void Stop() override
+		{
+			bStopping = true;
+		}
+
+		// End FRunnable Interface
+
+	private:
+
+		struct FSubject
+		{
+			TUniquePtr<FJSONLiveLinkEncoder> Encoder;
+			TArray<FTransform> Transforms;
+			TArray<float> ParameterValues;
+		};
+
+		void Animate(FSubject& Subject, int64 Tick) const
+		{
+			const int32 NumAnimatedBones = FMath::CeilToInt(Options.NumBones * Options.Animated);
+			for (int32 BoneIdx = 0; BoneIdx < NumAnimatedBones; ++BoneIdx)
+			{
+				FTransform& Transform = Subject.Transforms[BoneIdx];
+				Transform.SetLocation(FVector(AnimationValue(Tick, 3 * BoneIdx), AnimationValue(Tick, 3 * BoneIdx + 1), AnimationValue(Tick, 3 * BoneIdx + 2)));
+				Transform.SetRotation(FQuat(FRotator(AnimationValue(Tick, BoneIdx) * 90.0f, AnimationValue(Tick, BoneIdx + 1) * 90.0f, 0.0f)));
+			}
+
+			const int32 NumAnimatedParameters = FMath::CeilToInt(Options.NumParameters * Options.Animated);
+			for (int32 ParameterIdx = 0; ParameterIdx < NumAnimatedParameters; ++ParameterIdx)
+			{
+				Subject.ParameterValues[ParameterIdx] = FMath::Abs(AnimationValue(Tick, ParameterIdx));
+			}
+		}
+
+		void SendJsonPackets(const FJSONLiveLinkEncoderTiming& Timing, int32& NumPackets, int64& NumBytes)
+		{
+			const int32 MaxPacketSize = Options.Transport == EJSONLiveLinkTransport::Tcp ? JSONLiveLinkProtocol::MaxStreamPacketSize : JSONLiveLinkProtocol::MaxDatagramSize;
+
+			FJSONLiveLinkEncoder::BeginJsonPacket(Packet);
+			int32 NumPacketSubjects = 0;
+			for (FSubject& Subject : Subjects)
+			{
+				// Subjects are encoded into the packet and moved to the next one when they don't fit
+				const int32 SubjectStart = Packet.Num();
+				Subject.Encoder->AppendJsonSubject(Packet, Subject.Transforms, Subject.ParameterValues, Timing);
+				if (NumPacketSubjects > 0 && Packet.Num() + 1 > MaxPacketSize)
+				{
+					// Without the comma that separated it from the previous subject
+					SubjectScratch.Reset();
+					SubjectScratch.Append(Packet.GetData() + SubjectStart + 1, Packet.Num() - SubjectStart - 1);
+					Packet.SetNum(SubjectStart, false);
+					FJSONLiveLinkEncoder::EndJsonPacket(Packet);
+					Send(Packet, NumPackets, NumBytes);
+
+					FJSONLiveLinkEncoder::BeginJsonPacket(Packet);
+					Packet.Append(SubjectScratch);
+					NumPacketSubjects = 0;
+				}
+				++NumPacketSubjects;
+			}
+			FJSONLiveLinkEncoder::EndJsonPacket(Packet);
+			Send(Packet, NumPackets, NumBytes);
+		}
+
+		void Send(const TArray<uint8>& InPacket, int32& NumPackets, int64& NumBytes)
+		{
+			if (Options.Transport == EJSONLiveLinkTransport::Tcp)
+			{
+				const uint32 Size = InPacket.Num();
+				if (!SendAll((const uint8*)&Size, sizeof(Size)) || !SendAll(InPacket.GetData(), InPacket.Num()))
+				{
+					UE_LOG(LogJSONLiveLink, Error, TEXT("Load generator lost its connection to %s"), *Options.Endpoint.ToString());
+					bStopping = true;
+					return;
+				}
+				NumBytes += JSONLiveLinkProtocol::StreamHeaderSize;
+			}
+			else
+			{
+				// A full send buffer drops the datagram like the network would
+				int32 BytesSent = 0;
+				Socket->SendTo(InPacket.GetData(), InPacket.Num(), BytesSent, *DestinationAddr);
+			}
+
+			++NumPackets;
+			NumBytes += InPacket.Num();
+		}
+
+		bool SendAll(const uint8* Data, int32 Size)
+		{
+			while (Size > 0)
+			{
+				int32 BytesSent = 0;
+				if (!Socket->Send(Data, Size, BytesSent) || BytesSent <= 0)
+				{
+					return false;
+				}
+				Data += BytesSent;
+				Size -= BytesSent;
+			}
+			return true;
+		}
+
+		void ReceiveKeyframeRequests()
+		{
+			if (Options.Mode != EMode::Delta)
+			{
+				return;
+			}
+
+			uint32 PendingSize = 0;
+			while (Socket->HasPendingData(PendingSize))
+			{
+				const int32 Offset = ReceiveBuffer.Num();
+				ReceiveBuffer.SetNumUninitialized(Offset + FMath::Max<int32>(PendingSize, 1), false);
+
+				int32 BytesRead = 0;
+				const bool bReceived = Options.Transport == EJSONLiveLinkTransport::Tcp
+					? Socket->Recv(ReceiveBuffer.GetData() + Offset, ReceiveBuffer.Num() - Offset, BytesRead)
+					: Socket->RecvFrom(ReceiveBuffer.GetData() + Offset, ReceiveBuffer.Num() - Offset, BytesRead, *SenderAddr);
+				ReceiveBuffer.SetNum(Offset + (bReceived ? BytesRead : 0), false);
+				if (!bReceived || BytesRead <= 0)
+				{
+					break;
+				}
+
+				if (Options.Transport == EJSONLiveLinkTransport::Udp)
+				{
+					HandleKeyframeRequest(ReceiveBuffer.GetData(), ReceiveBuffer.Num());
+					ReceiveBuffer.Reset();
+				}
+			}
+
+			// Streamed requests are length prefixed like everything else on the stream
+			int32 Consumed = 0;
+			while (ReceiveBuffer.Num() - Consumed >= JSONLiveLinkProtocol::StreamHeaderSize)
+			{
+				uint32 Size = 0;
+				FMemory::Memcpy(&Size, ReceiveBuffer.GetData() + Consumed, sizeof(Size));
+				if ((int64)ReceiveBuffer.Num() - Consumed - JSONLiveLinkProtocol::StreamHeaderSize < Size)
+				{
+					break;
+				}
+				HandleKeyframeRequest(ReceiveBuffer.GetData() + Consumed + JSONLiveLinkProtocol::StreamHeaderSize, Size);
+				Consumed += JSONLiveLinkProtocol::StreamHeaderSize + Size;
+			}
+			ReceiveBuffer.RemoveAt(0, Consumed, false);
+		}
+
+		void HandleKeyframeRequest(const uint8* Data, int32 Size)
+		{
+			for (FSubject& Subject : Subjects)
+			{
+				if (Subject.Encoder->HandleKeyframeRequest(Data, Size))
+				{
+					break;
+				}
+			}
+		}
+
+		FOptions Options;
+
+		TArray<FSubject> Subjects;
+
+		FSocket* Socket;
+		TSharedPtr<FInternetAddr> DestinationAddr;
+		TSharedPtr<FInternetAddr> SenderAddr;
+
+		// Reused for every packet sent and request received
+		TArray<uint8> Packet;
+		TArray<uint8> SubjectScratch;
+		TArray<uint8> ReceiveBuffer;
+
+		FThreadSafeBool bStopping;
+
+		FRunnableThread* Thread;
+	};
+
+	static TUniquePtr<FGenerator> Generator;
+
+	static void Start(const TArray<FString>& Args)
+	{
+		FOptions Options;
+		if (Args.Num() > 0 && !Args[0].Contains(TEXT("=")) && !FIPv4Endpoint::Parse(Args[0], Options.Endpoint))
+		{
+			UE_LOG(LogJSONLiveLink, Error, TEXT("Load generator: invalid endpoint %s"), *Args[0]);
+			return;
+		}
+
+		const FString Params = FString::Join(Args, TEXT(" "));
+		FParse::Value(*Params, TEXT("Subjects="), Options.NumSubjects);
+		FParse::Value(*Params, TEXT("Bones="), Options.NumBones);
+		FParse::Value(*Params, TEXT("Parameters="), Options.NumParameters);
+		FParse::Value(*Params, TEXT("Rate="), Options.Rate);
+		FParse::Value(*Params, TEXT("Seconds="), Options.Seconds);
+		FParse::Value(*Params, TEXT("Animated="), Options.Animated);
+		FParse::Value(*Params, TEXT("KeyframeInterval="), Options.KeyframeInterval);
+
+		FString Mode;
+		if (FParse::Value(*Params, TEXT("Mode="), Mode))
+		{
+			Options.Mode = Mode == TEXT("Binary") ? EMode::Binary : Mode == TEXT("Delta") ? EMode::Delta : EMode::Json;
+		}
+
+		FString Transport;
+		if (FParse::Value(*Params, TEXT("Transport="), Transport))
+		{
+			Options.Transport = Transport == TEXT("Tcp") ? EJSONLiveLinkTransport::Tcp : EJSONLiveLinkTransport::Udp;
+		}
+
+		Options.NumSubjects = FMath::Max(Options.NumSubjects, 1);
+		Options.NumBones = FMath::Clamp(Options.NumBones, 1, (int32)MAX_uint16);
+		Options.NumParameters = FMath::Clamp(Options.NumParameters, 0, (int32)MAX_uint16);
+		Options.Rate = FMath::Max(Options.Rate, 1.0);
+		Options.Animated = FMath::Clamp(Options.Animated, 0.0f, 1.0f);
+
+		// One generator at a time, starting another replaces it
+		Generator.Reset();
+		Generator = MakeUnique<FGenerator>(Options);
+
+		UE_LOG(LogJSONLiveLink, Display, TEXT("Load generator sending %d subjects of %d bones and %d parameters at %.0f Hz to %s"),
+			Options.NumSubjects, Options.NumBones, Options.NumParameters, Options.Rate, *Options.Endpoint.ToString());
+	}
+
+	static void Stop()
+	{
+		Generator.Reset();
+	}
+
+	static FAutoConsoleCommand LoadGeneratorCommand(
+		TEXT("JSONLiveLink.LoadGenerator"),
+		TEXT("Sends generated subjects to an endpoint until stopped. Arguments: [Address:Port] Subjects=1 Bones=60 Parameters=0 Rate=60 Mode=Json|Binary|Delta Transport=Udp|Tcp Seconds=0 Animated=1.0 KeyframeInterval=60"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&Start));
+
+	static FAutoConsoleCommand StopLoadGeneratorCommand(
+		TEXT("JSONLiveLink.StopLoadGenerator"),
+		TEXT("Stops the load generator started by JSONLiveLink.LoadGenerator."),
+		FConsoleCommandDelegate::CreateStatic(&Stop));
+}
+
+#endif
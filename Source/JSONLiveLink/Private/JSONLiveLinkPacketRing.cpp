@@ -0,0 +1,120 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#include "JSONLiveLinkPacketRing.h"
+
+FJSONLiveLinkPacketRing::FJSONLiveLinkPacketRing(int32 Capacity, int32 InMaxPacketSize)
+: MaxPacketSize(InMaxPacketSize)
+, WritePos(0)
+, ReadPos(0)
+, ClaimedPos(0)
+, bClaimed(false)
+, NumOverruns(0)
+{
+	const uint32 NumSlots = FMath::RoundUpToPowerOfTwo((uint32)FMath::Max(Capacity, 2));
+	Mask = NumSlots - 1;
+
+	SlotMemory.SetNumUninitialized(NumSlots * MaxPacketSize);
+	Slots.SetNum(NumSlots);
+	for (uint32 SlotIdx = 0; SlotIdx < NumSlots; ++SlotIdx)
+	{
+		Slots[SlotIdx].Sequence.Store(SlotIdx, EMemoryOrder::Relaxed);
+		Slots[SlotIdx].Packet.Data = SlotMemory.GetData() + SlotIdx * MaxPacketSize;
+	}
+}
+
+int32 FJSONLiveLinkPacketRing::AcquireSlots(uint8** OutSlots, int32 MaxSlots)
+{
+	// Only this thread moves WritePos
+	const uint32 Pos = WritePos.Load(EMemoryOrder::Relaxed);
+
+	// Acquiring doesn't change any state, slots stay free until committed
+	int32 NumSlots = 0;
+	while (NumSlots < FMath::Min(MaxSlots, Slots.Num()) && Slots[(Pos + NumSlots) & Mask].Sequence.Load() == Pos + NumSlots)
+	{
+		OutSlots[NumSlots] = Slots[(Pos + NumSlots) & Mask].Packet.Data;
+		++NumSlots;
+	}
+	return NumSlots;
+}
+
+uint8* FJSONLiveLinkPacketRing::AcquireOverrunSlot()
+{
+	const uint32 Pos = WritePos.Load(EMemoryOrder::Relaxed);
+	FSlot& Slot = Slots[Pos & Mask];
+	if (Slot.Sequence.Load() == Pos)
+	{
+		// The consumer caught up while the datagram was received
+		return Slot.Packet.Data;
+	}
+
+	// Still holding the packet written one lap ago, one of the two is lost
+	if (DropOldest(Pos - Slots.Num()))
+	{
+		NumOverruns.IncrementExchange();
+		return Slot.Packet.Data;
+	}
+
+	// The consumer claimed it, and may have released it since
+	if (Slot.Sequence.Load() == Pos)
+	{
+		return Slot.Packet.Data;
+	}
+	NumOverruns.IncrementExchange();
+	return nullptr;
+}
+
+void FJSONLiveLinkPacketRing::Commit(int32 Size, const FIPv4Endpoint& Sender, double ArrivalTime, uint32 CoalesceKey)
+{
+	const uint32 Pos = WritePos.Load(EMemoryOrder::Relaxed);
+	FSlot& Slot = Slots[Pos & Mask];
+	check(Slot.Sequence.Load(EMemoryOrder::Relaxed) == Pos && Size <= MaxPacketSize);
+
+	Slot.Packet.Size = Size;
+	Slot.Packet.Sender = Sender;
+	Slot.Packet.ArrivalTime = ArrivalTime;
+	Slot.Packet.CoalesceKey = CoalesceKey;
+	Slot.Packet.Position = Pos;
+	Slot.Sequence.Store(Pos + 1);
+	WritePos.Store(Pos + 1, EMemoryOrder::Relaxed);
+}
+
+bool FJSONLiveLinkPacketRing::DropOldest(uint32 OldestPos)
+{
+	uint32 Expected = OldestPos;
+	if (!ReadPos.CompareExchange(Expected, OldestPos + 1))
+	{
+		// The consumer claimed it and is still decoding it
+		return false;
+	}
+	Slots[OldestPos & Mask].Sequence.Store(OldestPos + Slots.Num());
+	return true;
+}
+
+const FJSONLiveLinkPacket* FJSONLiveLinkPacketRing::Peek()
+{
+	check(!bClaimed);
+	for (;;)
+	{
+		uint32 Pos = ReadPos.Load();
+		FSlot& Slot = Slots[Pos & Mask];
+		if (Slot.Sequence.Load() != Pos + 1)
+		{
+			return nullptr;
+		}
+
+		// Races the producer dropping this packet
+		if (ReadPos.CompareExchange(Pos, Pos + 1))
+		{
+			ClaimedPos = Pos;
+			bClaimed = true;
+			return &Slot.Packet;
+		}
+	}
+}
+
+void FJSONLiveLinkPacketRing::Release()
+{
+	check(bClaimed);
+	bClaimed = false;
+	Slots[ClaimedPos & Mask].Sequence.Store(ClaimedPos + Slots.Num());
+}
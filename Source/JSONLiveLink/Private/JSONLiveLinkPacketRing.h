@@ -0,0 +1,91 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "Templates/Atomic.h"
+
+/** A datagram copied into one of the ring's slots */
+struct FJSONLiveLinkPacket
+{
+	uint8* Data = nullptr;
+	int32 Size = 0;
+	FIPv4Endpoint Sender;
+
+	// FPlatformTime::Seconds() when the datagram was received
+	double ArrivalTime = 0;
+
+	// Set by the producer, see FJSONLiveLinkDecoder::GetCoalesceKey
+	uint32 CoalesceKey = 0;
+
+	// Position the packet was written at, increases by one per enqueued packet
+	uint32 Position = 0;
+};
+
+/**
+ * Fixed capacity lock-free ring of reusable packet slots, with a single producer (the receiver thread) and a single consumer.
+ * The producer receives datagrams directly into the slots, nothing is copied. When the ring is full the producer receives
+ * into a buffer of its own, and only once it has a datagram in hand drops the oldest packet to copy it in, unless the consumer
+ * freed a slot meanwhile or is decoding the oldest packet, in which case the incoming one is dropped. Each lost packet bumps
+ * the overrun counter once. Nothing is allocated after construction.
+ */
+class FJSONLiveLinkPacketRing
+{
+public:
+
+	// Capacity is rounded up to a power of two, every slot holds up to MaxPacketSize bytes
+	FJSONLiveLinkPacketRing(int32 Capacity, int32 MaxPacketSize);
+
+	// Producer: data of the free slots from the next position on, up to MaxSlots, for datagrams to be received straight into.
+	// Returns 0 when the ring is full.
+	int32 AcquireSlots(uint8** OutSlots, int32 MaxSlots);
+
+	// Producer: the next slot for a datagram received elsewhere while the ring was full, to be copied in and committed. The
+	// oldest packet is dropped when it's still waiting. Returns null, the datagram being the one dropped, while it's decoded.
+	uint8* AcquireOverrunSlot();
+
+	// Producer: publishes the packet received into the next acquired slot
+	void Commit(int32 Size, const FIPv4Endpoint& Sender, double ArrivalTime, uint32 CoalesceKey = 0);
+
+	int32 GetMaxPacketSize() const { return MaxPacketSize; }
+
+	// Producer: position the next enqueued packet will be written at
+	uint32 GetNextPosition() const { return WritePos.Load(EMemoryOrder::Relaxed); }
+
+	// Consumer: claims the oldest packet, which stays valid and untouched by the producer until Release
+	const FJSONLiveLinkPacket* Peek();
+	void Release();
+
+	// Packets waiting for the consumer, approximate while the producer is running
+	int32 GetNum() const { return (int32)(WritePos.Load(EMemoryOrder::Relaxed) - ReadPos.Load(EMemoryOrder::Relaxed)); }
+
+	// Number of packets dropped because the consumer fell behind
+	uint32 GetNumOverruns() const { return NumOverruns.Load(EMemoryOrder::Relaxed); }
+
+private:
+
+	struct FSlot
+	{
+		// Vyukov style sequence, Pos when free for the producer at Pos, Pos + 1 once it holds the packet written at Pos
+		TAtomic<uint32> Sequence;
+		FJSONLiveLinkPacket Packet;
+	};
+
+	// Producer side drop of the oldest packet, fails if the consumer claimed it first
+	bool DropOldest(uint32 OldestPos);
+
+	TArray<FSlot> Slots;
+	TArray<uint8> SlotMemory;
+	uint32 Mask;
+	int32 MaxPacketSize;
+
+	TAtomic<uint32> WritePos;
+	TAtomic<uint32> ReadPos;
+
+	// Position of the packet handed out by Peek, only touched by the consumer
+	uint32 ClaimedPos;
+	bool bClaimed;
+
+	TAtomic<uint32> NumOverruns;
+};
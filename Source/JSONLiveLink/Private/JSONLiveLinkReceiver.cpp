@@ -0,0 +1,340 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#include "JSONLiveLinkReceiver.h"
+#include "JSONLiveLink.h"
+#include "JSONLiveLinkProtocol.h"
+
+#if PLATFORM_LINUX
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#else
+#include "Common/UdpSocketBuilder.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+// Longest FSocket::Wait blocks, in case the wake datagram is filtered out
+#define MAX_SOCKET_WAIT_SECONDS 1
+#endif
+
+FJSONLiveLinkReceiver::FJSONLiveLinkReceiver(int32 BatchSize, int32 InMaxDatagramSize, bool bOwnSlots)
+: MaxDatagramSize(FMath::Clamp(InMaxDatagramSize, 1, JSONLiveLinkProtocol::MaxDatagramSize))
+, NumTruncated(0)
+{
+	Datagrams.SetNum(FMath::Max(BatchSize, 1));
+	if (bOwnSlots)
+	{
+		SlotMemory.SetNumUninitialized(Datagrams.Num() * GetSlotSize());
+		for (int32 SlotIdx = 0; SlotIdx < Datagrams.Num(); ++SlotIdx)
+		{
+			Datagrams[SlotIdx].Data = SlotMemory.GetData() + SlotIdx * GetSlotSize();
+		}
+	}
+}
+
+#if PLATFORM_LINUX
+
+struct FJSONLiveLinkUdpReceiver::FNativeBatch
+{
+	TArray<mmsghdr> Messages;
+	TArray<iovec> Buffers;
+	TArray<sockaddr_in> Senders;
+};
+
+static sockaddr_in ToSockAddr(const FIPv4Address& Address, uint16 Port)
+{
+	sockaddr_in SockAddr;
+	FMemory::Memzero(SockAddr);
+	SockAddr.sin_family = AF_INET;
+	SockAddr.sin_addr.s_addr = htonl(Address.Value);
+	SockAddr.sin_port = htons(Port);
+	return SockAddr;
+}
+
+FJSONLiveLinkUdpReceiver::FJSONLiveLinkUdpReceiver(const FIPv4Endpoint& Endpoint, int32 ReceiveBufferSize, int32 BatchSize, int32 InMaxDatagramSize, bool bOwnSlots, bool bReusePort)
+: FJSONLiveLinkReceiver(BatchSize, InMaxDatagramSize, bOwnSlots)
+, NativeBatch(MakeUnique<FNativeBatch>())
+, NativeSocket(-1)
+, WakeFd(-1)
+{
+	NativeSocket = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+	if (NativeSocket < 0)
+	{
+		UE_LOG(LogJSONLiveLink, Error, TEXT("Failed to create socket: %s"), UTF8_TO_TCHAR(strerror(errno)));
+		return;
+	}
+
+	const int Enable = 1;
+	setsockopt(NativeSocket, SOL_SOCKET, SO_REUSEADDR, &Enable, sizeof(Enable));
+	if (bReusePort)
+	{
+		// Datagrams are distributed by a hash of the sender address, so each sender sticks to one receiver
+		setsockopt(NativeSocket, SOL_SOCKET, SO_REUSEPORT, &Enable, sizeof(Enable));
+	}
+	setsockopt(NativeSocket, SOL_SOCKET, SO_RCVBUF, &ReceiveBufferSize, sizeof(ReceiveBufferSize));
+
+	const bool bMulticast = Endpoint.Address.IsMulticastAddress();
+	const sockaddr_in BindAddr = ToSockAddr(bMulticast ? FIPv4Address::Any : Endpoint.Address, Endpoint.Port);
+	bool bSuccess = bind(NativeSocket, (const sockaddr*)&BindAddr, sizeof(BindAddr)) == 0;
+
+	if (bSuccess && bMulticast)
+	{
+		ip_mreq Group;
+		Group.imr_multiaddr.s_addr = htonl(Endpoint.Address.Value);
+		Group.imr_interface.s_addr = htonl(INADDR_ANY);
+		const int Loopback = 1;
+		const int Ttl = 2;
+		bSuccess = setsockopt(NativeSocket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &Group, sizeof(Group)) == 0
+			&& setsockopt(NativeSocket, IPPROTO_IP, IP_MULTICAST_LOOP, &Loopback, sizeof(Loopback)) == 0
+			&& setsockopt(NativeSocket, IPPROTO_IP, IP_MULTICAST_TTL, &Ttl, sizeof(Ttl)) == 0;
+	}
+
+	if (!bSuccess)
+	{
+		UE_LOG(LogJSONLiveLink, Error, TEXT("Failed to bind socket to %s: %s"), *Endpoint.ToString(), UTF8_TO_TCHAR(strerror(errno)));
+		close(NativeSocket);
+		NativeSocket = -1;
+		return;
+	}
+
+	WakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (WakeFd < 0)
+	{
+		UE_LOG(LogJSONLiveLink, Error, TEXT("Failed to create eventfd: %s"), UTF8_TO_TCHAR(strerror(errno)));
+		close(NativeSocket);
+		NativeSocket = -1;
+		return;
+	}
+
+	NativeBatch->Messages.SetNumZeroed(Datagrams.Num());
+	NativeBatch->Buffers.SetNumZeroed(Datagrams.Num());
+	NativeBatch->Senders.SetNumZeroed(Datagrams.Num());
+	for (int32 SlotIdx = 0; SlotIdx < Datagrams.Num(); ++SlotIdx)
+	{
+		iovec& Buffer = NativeBatch->Buffers[SlotIdx];
+		Buffer.iov_len = MaxDatagramSize;
+
+		msghdr& Header = NativeBatch->Messages[SlotIdx].msg_hdr;
+		Header.msg_iov = &Buffer;
+		Header.msg_iovlen = 1;
+		Header.msg_name = &NativeBatch->Senders[SlotIdx];
+	}
+}
+
+FJSONLiveLinkUdpReceiver::~FJSONLiveLinkUdpReceiver()
+{
+	if (NativeSocket >= 0)
+	{
+		close(NativeSocket);
+	}
+	if (WakeFd >= 0)
+	{
+		close(WakeFd);
+	}
+}
+
+bool FJSONLiveLinkUdpReceiver::IsValid() const
+{
+	return NativeSocket >= 0;
+}
+
+int32 FJSONLiveLinkUdpReceiver::ReceiveBatch(const FTimespan& WaitTime, int32 MaxDatagrams)
+{
+	pollfd PollFds[2];
+	PollFds[0].fd = NativeSocket;
+	PollFds[0].events = POLLIN;
+	PollFds[0].revents = 0;
+	PollFds[1].fd = WakeFd;
+	PollFds[1].events = POLLIN;
+	PollFds[1].revents = 0;
+
+	const int Timeout = WaitTime == FTimespan::MaxValue() ? -1 : (int)WaitTime.GetTotalMilliseconds();
+	if (poll(PollFds, 2, Timeout) <= 0)
+	{
+		return 0;
+	}
+
+	if (PollFds[1].revents & POLLIN)
+	{
+		// Consume the wakeup so the next wait blocks again
+		uint64 Count;
+		ssize_t Result = read(WakeFd, &Count, sizeof(Count));
+		(void)Result;
+		return 0;
+	}
+
+	// The slots may have moved since the last batch
+	MaxDatagrams = FMath::Clamp(MaxDatagrams, 1, Datagrams.Num());
+	for (int32 MessageIdx = 0; MessageIdx < MaxDatagrams; ++MessageIdx)
+	{
+		NativeBatch->Buffers[MessageIdx].iov_base = Datagrams[MessageIdx].Data;
+		NativeBatch->Messages[MessageIdx].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+	}
+
+	const int NumReceived = recvmmsg(NativeSocket, NativeBatch->Messages.GetData(), MaxDatagrams, MSG_DONTWAIT, nullptr);
+	const double ArrivalTime = FPlatformTime::Seconds();
+	for (int32 MessageIdx = 0; MessageIdx < NumReceived; ++MessageIdx)
+	{
+		const mmsghdr& Message = NativeBatch->Messages[MessageIdx];
+		const sockaddr_in& Sender = NativeBatch->Senders[MessageIdx];
+		FJSONLiveLinkDatagram& Datagram = Datagrams[MessageIdx];
+		Datagram.Size = Message.msg_len;
+		if (Message.msg_hdr.msg_flags & MSG_TRUNC)
+		{
+			Datagram.Size = 0;
+			NumTruncated.IncrementExchange();
+		}
+		Datagram.Sender = FIPv4Endpoint(FIPv4Address(ntohl(Sender.sin_addr.s_addr)), ntohs(Sender.sin_port));
+		Datagram.ArrivalTime = ArrivalTime;
+	}
+	return FMath::Max(NumReceived, 0);
+}
+
+void FJSONLiveLinkUdpReceiver::Wake()
+{
+	if (WakeFd >= 0)
+	{
+		const uint64 Count = 1;
+		ssize_t Result = write(WakeFd, &Count, sizeof(Count));
+		(void)Result;
+	}
+}
+
+bool FJSONLiveLinkUdpReceiver::SendTo(const uint8* Data, int32 Size, const FIPv4Endpoint& Endpoint)
+{
+	const sockaddr_in Destination = ToSockAddr(Endpoint.Address, Endpoint.Port);
+	return sendto(NativeSocket, Data, Size, MSG_DONTWAIT, (const sockaddr*)&Destination, sizeof(Destination)) == Size;
+}
+
+#else
+
+FJSONLiveLinkUdpReceiver::FJSONLiveLinkUdpReceiver(const FIPv4Endpoint& Endpoint, int32 ReceiveBufferSize, int32 BatchSize, int32 InMaxDatagramSize, bool bOwnSlots, bool bReusePort)
+: FJSONLiveLinkReceiver(BatchSize, InMaxDatagramSize, bOwnSlots)
+, Socket(nullptr)
+{
+	//setup socket
+	if (Endpoint.Address.IsMulticastAddress())
+	{
+		Socket = FUdpSocketBuilder(TEXT("JSONSOCKET"))
+			.AsNonBlocking()
+			.AsReusable()
+			.BoundToPort(Endpoint.Port)
+			.WithReceiveBufferSize(ReceiveBufferSize)
+
+			.BoundToAddress(FIPv4Address::Any)
+			.JoinedToGroup(Endpoint.Address)
+			.WithMulticastLoopback()
+			.WithMulticastTtl(2);
+	}
+	else
+	{
+		Socket = FUdpSocketBuilder(TEXT("JSONSOCKET"))
+			.AsNonBlocking()
+			.AsReusable()
+			.BoundToAddress(Endpoint.Address)
+			.BoundToPort(Endpoint.Port)
+			.WithReceiveBufferSize(ReceiveBufferSize);
+	}
+
+	if (Socket != nullptr)
+	{
+		SenderAddr = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+
+		// Sockets bound to any address are reached through loopback
+		WakeAddr = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+		Socket->GetAddress(*WakeAddr);
+		uint32 BoundAddress = 0;
+		WakeAddr->GetIp(BoundAddress);
+		if (BoundAddress == FIPv4Address::Any.Value)
+		{
+			WakeAddr->SetIp(FIPv4Address(127, 0, 0, 1).Value);
+		}
+	}
+	else
+	{
+		UE_LOG(LogJSONLiveLink, Error, TEXT("Failed to bind socket to %s"), *Endpoint.ToString());
+	}
+}
+
+FJSONLiveLinkUdpReceiver::~FJSONLiveLinkUdpReceiver()
+{
+	if (Socket != nullptr)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+	}
+}
+
+bool FJSONLiveLinkUdpReceiver::IsValid() const
+{
+	return Socket != nullptr && Socket->GetSocketType() == SOCKTYPE_Datagram;
+}
+
+int32 FJSONLiveLinkUdpReceiver::ReceiveBatch(const FTimespan& WaitTime, int32 MaxDatagrams)
+{
+	if (!Socket->Wait(ESocketWaitConditions::WaitForRead, FMath::Min(WaitTime, FTimespan::FromSeconds(MAX_SOCKET_WAIT_SECONDS))))
+	{
+		return 0;
+	}
+
+	// Drain until the socket would block instead of probing with HasPendingData before every read
+	const double ArrivalTime = FPlatformTime::Seconds();
+	MaxDatagrams = FMath::Clamp(MaxDatagrams, 1, Datagrams.Num());
+	int32 NumReceived = 0;
+	while (NumReceived < MaxDatagrams)
+	{
+		FJSONLiveLinkDatagram& Datagram = Datagrams[NumReceived];
+		int32 Read = 0;
+		bool bTruncated = false;
+		if (!Socket->RecvFrom(Datagram.Data, GetSlotSize(), Read, *SenderAddr))
+		{
+			// Windows fails datagrams larger than the slot, after taking them off the socket
+			if (ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLastErrorCode() != SE_EMSGSIZE)
+			{
+				break;
+			}
+			bTruncated = true;
+		}
+		else if (Read <= 0)
+		{
+			continue;
+		}
+
+		// Elsewhere they're silently cut to the slot, which has a byte to spare to tell
+		bTruncated |= Read > MaxDatagramSize;
+
+		// Kept with no data like on Linux, the slot was used
+		Datagram.Size = bTruncated ? 0 : Read;
+		Datagram.Sender = FIPv4Endpoint(SenderAddr);
+		Datagram.ArrivalTime = ArrivalTime;
+		if (bTruncated)
+		{
+			NumTruncated.IncrementExchange();
+		}
+		++NumReceived;
+	}
+	return NumReceived;
+}
+
+void FJSONLiveLinkUdpReceiver::Wake()
+{
+	// An empty datagram ends the wait and is skipped when draining
+	if (Socket != nullptr)
+	{
+		uint8 Empty = 0;
+		int32 BytesSent = 0;
+		Socket->SendTo(&Empty, 0, BytesSent, *WakeAddr);
+	}
+}
+
+bool FJSONLiveLinkUdpReceiver::SendTo(const uint8* Data, int32 Size, const FIPv4Endpoint& Endpoint)
+{
+	int32 BytesSent = 0;
+	return Socket->SendTo(Data, Size, BytesSent, *Endpoint.ToInternetAddr()) && BytesSent == Size;
+}
+
+#endif
@@ -0,0 +1,115 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "Templates/Atomic.h"
+
+class FSocket;
+
+/** A datagram received into one of the receiver's slots */
+struct FJSONLiveLinkDatagram
+{
+	uint8* Data = nullptr;
+
+	// 0 when the datagram didn't fit its slot and was dropped
+	int32 Size = 0;
+	FIPv4Endpoint Sender;
+
+	// FPlatformTime::Seconds() when the batch was received
+	double ArrivalTime = 0;
+};
+
+/**
+ * Source of datagrams for a FJSONLiveLinkWorker of up to MaxDatagramSize bytes, received in batches into slots.
+ * The slots are either the receiver's own or lent by the caller, so datagrams can land straight where they're queued.
+ */
+class FJSONLiveLinkReceiver
+{
+public:
+
+	// Without bOwnSlots nothing is allocated and SetSlot has to be called for every datagram before each ReceiveBatch
+	FJSONLiveLinkReceiver(int32 BatchSize, int32 InMaxDatagramSize, bool bOwnSlots);
+
+	virtual ~FJSONLiveLinkReceiver() { }
+
+	virtual bool IsValid() const = 0;
+
+	// Waits up to WaitTime for data then receives up to MaxDatagrams, at most the batch size, returns how many were received.
+	// FTimespan::MaxValue() waits until data arrives or Wake is called.
+	virtual int32 ReceiveBatch(const FTimespan& WaitTime, int32 MaxDatagrams) = 0;
+
+	int32 GetBatchSize() const { return Datagrams.Num(); }
+
+	int32 GetMaxDatagramSize() const { return MaxDatagramSize; }
+
+	// Bytes of each slot, one more than the largest datagram so one filling it can be told from a larger one cut short
+	int32 GetSlotSize() const { return MaxDatagramSize + 1; }
+
+	// Datagram Index of the next batch is received into Slot, which must hold GetSlotSize() bytes
+	void SetSlot(int32 Index, uint8* Slot) { Datagrams[Index].Data = Slot; }
+
+	// Datagrams dropped because they were larger than MaxDatagramSize
+	uint32 GetNumTruncated() const { return NumTruncated.Load(EMemoryOrder::Relaxed); }
+
+	// Makes a ReceiveBatch waiting on another thread return straight away, so stopping doesn't wait for data
+	virtual void Wake() = 0;
+
+	// Datagram received by the last ReceiveBatch, valid until the next one
+	const FJSONLiveLinkDatagram& GetDatagram(int32 Index) const { return Datagrams[Index]; }
+
+	// Sends back to a sender, returns false when the receiver has no way to
+	virtual bool SendTo(const uint8* Data, int32 Size, const FIPv4Endpoint& Endpoint) = 0;
+
+protected:
+
+	TArray<FJSONLiveLinkDatagram> Datagrams;
+
+	TArray<uint8> SlotMemory;
+
+	int32 MaxDatagramSize;
+
+	TAtomic<uint32> NumTruncated;
+};
+
+/**
+ * UDP socket receiving datagrams in batches into preallocated slots.
+ * On Linux the socket is created natively so a whole batch is pulled with a single recvmmsg call, and waits are a poll on
+ * the socket and an eventfd. Elsewhere it's an FSocket drained with RecvFrom until it would block, woken by a datagram
+ * sent to itself.
+ */
+class FJSONLiveLinkUdpReceiver : public FJSONLiveLinkReceiver
+{
+public:
+
+	// With bReusePort, Linux only, several receivers can bind the same endpoint and the kernel spreads senders across them
+	FJSONLiveLinkUdpReceiver(const FIPv4Endpoint& Endpoint, int32 ReceiveBufferSize, int32 BatchSize, int32 InMaxDatagramSize, bool bOwnSlots, bool bReusePort = false);
+	virtual ~FJSONLiveLinkUdpReceiver();
+
+	// Begin FJSONLiveLinkReceiver Interface
+
+	virtual bool IsValid() const override;
+	virtual int32 ReceiveBatch(const FTimespan& WaitTime, int32 MaxDatagrams) override;
+	virtual void Wake() override;
+	virtual bool SendTo(const uint8* Data, int32 Size, const FIPv4Endpoint& Endpoint) override;
+
+	// End FJSONLiveLinkReceiver Interface
+
+private:
+
+#if PLATFORM_LINUX
+	struct FNativeBatch;
+	TUniquePtr<FNativeBatch> NativeBatch;
+	int NativeSocket;
+
+	// eventfd polled along with the socket, written to by Wake
+	int WakeFd;
+#else
+	TSharedPtr<FInternetAddr> SenderAddr;
+	FSocket* Socket;
+
+	// Our own bound address, Wake sends an empty datagram there to end the socket wait
+	TSharedPtr<FInternetAddr> WakeAddr;
+#endif
+};
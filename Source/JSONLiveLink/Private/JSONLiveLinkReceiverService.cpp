@@ -0,0 +1,135 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#include "JSONLiveLinkReceiverService.h"
+#include "JSONLiveLink.h"
+#include "JSONLiveLinkDemultiplexer.h"
+#include "JSONLiveLinkSource.h"
+#include "JSONLiveLinkStats.h"
+#include "JSONLiveLinkWorker.h"
+
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeLock.h"
+
+TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe> FJSONLiveLinkReceiverService::Acquire(const FIPv4Endpoint& Endpoint, const FJSONLiveLinkSourceSettings& Settings, FJSONLiveLinkDemultiplexer* Predecessor)
+{
+	FScopeLock Lock(&CriticalSection);
+	RemoveReleased();
+
+	const FString Key = MakeSharingKey(Endpoint, Settings);
+	TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe> Demultiplexer = Demultiplexers.FindRef(Key).Pin();
+	if (Demultiplexer.IsValid() && !Demultiplexer->IsStopped())
+	{
+		return Demultiplexer;
+	}
+
+	// Another socket bound to the same port would only get some of the datagrams, if any, so the settings of the one
+	// already receiving win
+	for (const TPair<FString, TWeakPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>>& Other : Demultiplexers)
+	{
+		TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe> OtherDemultiplexer = Other.Value.Pin();
+		if (OtherDemultiplexer.IsValid() && !OtherDemultiplexer->IsStopped() && OtherDemultiplexer->GetEndpoint() == Endpoint)
+		{
+			UE_LOG(LogJSONLiveLink, Warning, TEXT("%s is already received on as %s, sharing it and ignoring the settings %s"), *Endpoint.ToString(), *Other.Key, *Key);
+			return OtherDemultiplexer;
+		}
+	}
+
+	FJSONLiveLinkSourceSettings SharedSettings = Settings;
+	SharedSettings.CaptureFilename.Empty();
+	Demultiplexer = MakeShared<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>(Endpoint, SharedSettings, nullptr, Predecessor);
+	Demultiplexers.Add(Key, Demultiplexer);
+	return Demultiplexer;
+}
+
+TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe> FJSONLiveLinkReceiverService::CreatePrivate(const FIPv4Endpoint& Endpoint, const FJSONLiveLinkSourceSettings& Settings, FJSONLiveLinkCaptureWriter* CaptureWriter, FJSONLiveLinkDemultiplexer* Predecessor)
+{
+	FScopeLock Lock(&CriticalSection);
+	RemoveReleased();
+
+	TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe> Demultiplexer = MakeShared<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>(Endpoint, Settings, CaptureWriter, Predecessor);
+	PrivateDemultiplexers.Add(Demultiplexer);
+	return Demultiplexer;
+}
+
+void FJSONLiveLinkReceiverService::GetDemultiplexers(TArray<TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>>& OutDemultiplexers)
+{
+	FScopeLock Lock(&CriticalSection);
+	OutDemultiplexers.Reset();
+
+	auto AddRunning = [&OutDemultiplexers](const TWeakPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>& Weak)
+	{
+		TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe> Demultiplexer = Weak.Pin();
+		if (Demultiplexer.IsValid() && !Demultiplexer->IsStopped())
+		{
+			OutDemultiplexers.Add(MoveTemp(Demultiplexer));
+		}
+	};
+	for (const TPair<FString, TWeakPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>>& Shared : Demultiplexers)
+	{
+		AddRunning(Shared.Value);
+	}
+	for (const TWeakPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>& Private : PrivateDemultiplexers)
+	{
+		AddRunning(Private);
+	}
+}
+
+FString FJSONLiveLinkReceiverService::MakeSharingKey(const FIPv4Endpoint& Endpoint, const FJSONLiveLinkSourceSettings& Settings)
+{
+	// Each source filters subjects out of what's dispatched to it, and sources that capture never share
+	FJSONLiveLinkSourceSettings KeySettings = Settings;
+	KeySettings.AllowedSubjects.Reset();
+	KeySettings.CaptureFilename.Empty();
+	return FJSONLiveLinkSource::MakeConnectionString({ Endpoint }, KeySettings);
+}
+
+void FJSONLiveLinkReceiverService::RemoveReleased()
+{
+	for (auto It = Demultiplexers.CreateIterator(); It; ++It)
+	{
+		if (!It.Value().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+	PrivateDemultiplexers.RemoveAll([](const TWeakPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>& Private) { return !Private.IsValid(); });
+}
+
+static void LogLatency(const TArray<FString>& Args)
+{
+	TArray<TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>> Demultiplexers;
+	FJSONLiveLinkModule::Get().GetReceiverService().GetDemultiplexers(Demultiplexers);
+
+	for (const TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>& Demultiplexer : Demultiplexers)
+	{
+		TMap<FName, FJSONLiveLinkLatencyStats::FHistograms> Subjects;
+		for (const TUniquePtr<FJSONLiveLinkWorker>& Worker : Demultiplexer->GetWorkers())
+		{
+			Worker->GetLatencyStats().AddTo(Subjects);
+		}
+
+		const FString Name = Demultiplexer->GetSettings().ReplayFilename.IsEmpty() ? Demultiplexer->GetEndpoint().ToString() : Demultiplexer->GetSettings().ReplayFilename;
+		UE_LOG(LogJSONLiveLink, Display, TEXT("%s: %d subjects, microseconds p50/p99 of each step since it started"), *Name, Subjects.Num());
+
+		Subjects.KeySort([](FName A, FName B) { return A.Compare(B) < 0; });
+		for (const TPair<FName, FJSONLiveLinkLatencyStats::FHistograms>& Subject : Subjects)
+		{
+			FString Line = FString::Printf(TEXT("  %s (%llu frames):"), *Subject.Key.ToString(), Subject.Value.GetNum(FJSONLiveLinkLatencyStats::Total));
+			for (int32 Stage = 0; Stage < FJSONLiveLinkLatencyStats::NumStages; ++Stage)
+			{
+				const FJSONLiveLinkLatencyStats::EStage LatencyStage = (FJSONLiveLinkLatencyStats::EStage)Stage;
+				if (Subject.Value.GetNum(LatencyStage) > 0)
+				{
+					Line += FString::Printf(TEXT(" %s %.0f/%.0f"), FJSONLiveLinkLatencyStats::GetStageName(LatencyStage),
+						Subject.Value.GetPercentile(LatencyStage, 0.5), Subject.Value.GetPercentile(LatencyStage, 0.99));
+				}
+			}
+			UE_LOG(LogJSONLiveLink, Display, TEXT("%s"), *Line);
+		}
+	}
+}
+
+static FAutoConsoleCommand LatencyCommand(
+	TEXT("JSONLiveLink.Latency"),
+	TEXT("Logs, for every subject received, the p50 and p99 of how long its frames took from the sender to arrival, in the queue, decoding and being pushed to LiveLink."),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&LogLatency));
@@ -0,0 +1,47 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "JSONLiveLinkSourceSettings.h"
+
+class FJSONLiveLinkCaptureWriter;
+class FJSONLiveLinkDemultiplexer;
+
+/**
+ * Hands out one FJSONLiveLinkDemultiplexer per endpoint to every source receiving on it, so N sources on the same port or
+ * multicast group cost one socket, one receive and one decode. Owned by FJSONLiveLinkModule.
+ * Sources share when their settings match apart from their subject filter, and an endpoint is never received on twice
+ * with different ones. A demultiplexer lives as long as a source holds on to it. Capturing and replaying sources get private ones from it too, so every demultiplexer can be listed.
+ */
+class FJSONLiveLinkReceiverService
+{
+public:
+
+	// The endpoint's running demultiplexer for these settings, started if there's none yet. One that's started takes the
+	// caches of Predecessor when it's not null, see FJSONLiveLinkDemultiplexer. When the endpoint is already received on
+	// with other settings that demultiplexer is shared instead, the settings asked for are logged and ignored.
+	TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe> Acquire(const FIPv4Endpoint& Endpoint, const FJSONLiveLinkSourceSettings& Settings, FJSONLiveLinkDemultiplexer* Predecessor = nullptr);
+
+	// A demultiplexer only the caller receives on, for capturing and replaying sources. CaptureWriter must outlive it.
+	TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe> CreatePrivate(const FIPv4Endpoint& Endpoint, const FJSONLiveLinkSourceSettings& Settings, FJSONLiveLinkCaptureWriter* CaptureWriter, FJSONLiveLinkDemultiplexer* Predecessor = nullptr);
+
+	// Every demultiplexer still running, shared or not
+	void GetDemultiplexers(TArray<TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>>& OutDemultiplexers);
+
+private:
+
+	// Settings that change what's received or how it's decoded, as a connection string
+	static FString MakeSharingKey(const FIPv4Endpoint& Endpoint, const FJSONLiveLinkSourceSettings& Settings);
+
+	void RemoveReleased();
+
+	TMap<FString, TWeakPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>> Demultiplexers;
+
+	// Only kept track of to be listed
+	TArray<TWeakPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>> PrivateDemultiplexers;
+
+	FCriticalSection CriticalSection;
+};
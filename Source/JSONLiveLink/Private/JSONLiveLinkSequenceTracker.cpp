@@ -0,0 +1,39 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#include "JSONLiveLinkSequenceTracker.h"
+
+bool FJSONLiveLinkSequenceTracker::Accept(FName SubjectName, uint32 Sequence)
+{
+	uint32* LastSequence = LastSequences.Find(SubjectName);
+	if (LastSequence == nullptr)
+	{
+		LastSequences.Add(SubjectName, Sequence);
+		return true;
+	}
+
+	// Wraps around with the sequence
+	const int32 SequenceDelta = (int32)(Sequence - *LastSequence);
+	if (SequenceDelta == 0)
+	{
+		NumDuplicates.Increment();
+		return false;
+	}
+
+	if (SequenceDelta < 0 && !IsRestart(SequenceDelta))
+	{
+		// The packet was counted as lost when the newer one arrived, it's only late
+		NumReordered.Increment();
+		if (NumLost.GetValue() > 0)
+		{
+			NumLost.Decrement();
+		}
+		return false;
+	}
+
+	if (SequenceDelta > 1)
+	{
+		NumLost.Add(SequenceDelta - 1);
+	}
+	*LastSequence = Sequence;
+	return true;
+}
@@ -0,0 +1,42 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeCounter.h"
+
+/**
+ * Orders the frames of sequenced subjects: a frame older than, or the same as, the newest one accepted for its subject
+ * is rejected, and gaps are counted as lost packets. Only one thread checks frames at a time, the counters can be read
+ * from any thread.
+ */
+class FJSONLiveLinkSequenceTracker
+{
+public:
+
+	// Whether the subject's frame with this sequence should be pushed
+	bool Accept(FName SubjectName, uint32 Sequence);
+
+	// Whether a sequence this far behind the newest one means the sender restarted, rather than a packet arriving late
+	static bool IsRestart(int32 SequenceDelta) { return SequenceDelta <= -RestartThreshold; }
+
+	int32 GetNumLost() const { return NumLost.GetValue(); }
+	int32 GetNumReordered() const { return NumReordered.GetValue(); }
+	int32 GetNumDuplicates() const { return NumDuplicates.GetValue(); }
+
+private:
+
+	static const int32 RestartThreshold = 1024;
+
+	// Newest sequence accepted for each subject
+	TMap<FName, uint32> LastSequences;
+
+	// Packets that never arrived, or hadn't by the time a newer one did
+	FThreadSafeCounter NumLost;
+
+	// Packets that arrived after a newer one and were dropped
+	FThreadSafeCounter NumReordered;
+
+	// Packets received more than once
+	FThreadSafeCounter NumDuplicates;
+};
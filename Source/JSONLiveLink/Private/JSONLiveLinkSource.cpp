@@ -1,88 +1,184 @@
 // Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
 
 #include "JSONLiveLinkSource.h"
+#include "JSONLiveLink.h"
+#include "JSONLiveLinkCapture.h"
+#include "JSONLiveLinkDemultiplexer.h"
+#include "JSONLiveLinkReceiverService.h"
+#include "JSONLiveLinkStats.h"
+#include "JSONLiveLinkWorker.h"
 
 #include "ILiveLinkClient.h"
 #include "LiveLinkTypes.h"
 #include "Roles/LiveLinkAnimationRole.h"
 #include "Roles/LiveLinkAnimationTypes.h"
 
-#include "Async/Async.h"
-#include "Common/UdpSocketBuilder.h"
-#include "HAL/RunnableThread.h"
-#include "Json.h"
-#include "Sockets.h"
-#include "SocketSubsystem.h"
-#include <math.h>
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
 
 #define LOCTEXT_NAMESPACE "JSONLiveLinkSource"
 
-#define RECV_BUFFER_SIZE 1024 * 1024
+FJSONLiveLinkSource::FJSONLiveLinkSource(FIPv4Endpoint InEndpoint, const FJSONLiveLinkSourceSettings& InSettings)
+: FJSONLiveLinkSource(TArray<FIPv4Endpoint>({ InEndpoint }), InSettings)
+{
+}
 
-FJSONLiveLinkSource::FJSONLiveLinkSource(FIPv4Endpoint InEndpoint)
-: Socket(nullptr)
-, Stopping(false)
-, Thread(nullptr)
-, WaitTime(FTimespan::FromMilliseconds(100))
+FJSONLiveLinkSource::FJSONLiveLinkSource(const TArray<FIPv4Endpoint>& InEndpoints, const FJSONLiveLinkSourceSettings& InSettings)
+: Client(nullptr)
+, Settings(InSettings)
+, StatusSummary(MakeUnique<FJSONLiveLinkStatusSummary>())
 {
 	// defaults
-	DeviceEndpoint = InEndpoint;
+	DeviceEndpoints = InEndpoints;
+
+	{
+		FScopeLock Lock(&LiveSourcesCriticalSection);
+		LiveSources.Add(this);
+	}
+
+	StartReceiving(TArray<TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>>());
+}
 
+void FJSONLiveLinkSource::StartReceiving(const TArray<TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>>& Predecessors)
+{
 	SourceStatus = LOCTEXT("SourceStatus_DeviceNotFound", "Device Not Found");
 	SourceType = LOCTEXT("JSONLiveLinkSourceType", "JSON LiveLink");
 	SourceMachineName = LOCTEXT("JSONLiveLinkSourceMachineName", "localhost");
 
-	//setup socket
-	if (DeviceEndpoint.Address.IsMulticastAddress())
+	// A reconfigured source still capturing to the same file keeps appending to it
+	if (!Settings.CaptureFilename.IsEmpty() && !CaptureWriter.IsValid())
+	{
+		CaptureWriter = MakeUnique<FJSONLiveLinkCaptureWriter>(Settings.CaptureFilename);
+		if (!CaptureWriter->IsValid())
+		{
+			CaptureWriter.Reset();
+		}
+	}
+
+	// What the demultiplexer replacing one of the same endpoint, or else in the same place, carries over
+	TArray<FJSONLiveLinkDemultiplexer*> UnusedPredecessors;
+	for (const TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>& Predecessor : Predecessors)
+	{
+		UnusedPredecessors.Add(Predecessor.Get());
+	}
+	auto TakePredecessor = [&UnusedPredecessors](const FIPv4Endpoint& Endpoint) -> FJSONLiveLinkDemultiplexer*
+	{
+		if (UnusedPredecessors.Num() == 0)
+		{
+			return nullptr;
+		}
+		int32 Index = UnusedPredecessors.IndexOfByPredicate([&Endpoint](FJSONLiveLinkDemultiplexer* Predecessor) { return Predecessor->GetEndpoint() == Endpoint; });
+		Index = Index != INDEX_NONE ? Index : 0;
+		FJSONLiveLinkDemultiplexer* Predecessor = UnusedPredecessors[Index];
+		UnusedPredecessors.RemoveAt(Index);
+		return Predecessor;
+	};
+
+	if (!Settings.ReplayFilename.IsEmpty())
 	{
-		Socket = FUdpSocketBuilder(TEXT("JSONSOCKET"))
-			.AsNonBlocking()
-			.AsReusable()
-			.BoundToPort(DeviceEndpoint.Port)
-			.WithReceiveBufferSize(RECV_BUFFER_SIZE)
+		SourceType = LOCTEXT("JSONLiveLinkReplaySourceType", "JSON LiveLink Replay");
+		SourceMachineName = FText::FromString(FPaths::GetCleanFilename(Settings.ReplayFilename));
 
-			.BoundToAddress(FIPv4Address::Any)
-			.JoinedToGroup(DeviceEndpoint.Address)
-			.WithMulticastLoopback()
-			.WithMulticastTtl(2);
-					
+		const FIPv4Endpoint ReplayEndpoint(FIPv4Address::Any, 0);
+		Demultiplexers.Add(FJSONLiveLinkModule::Get().GetReceiverService().CreatePrivate(ReplayEndpoint, Settings, CaptureWriter.Get(), TakePredecessor(ReplayEndpoint)));
 	}
 	else
 	{
-		Socket = FUdpSocketBuilder(TEXT("JSONSOCKET"))
-			.AsNonBlocking()
-			.AsReusable()
-			.BoundToAddress(DeviceEndpoint.Address)
-			.BoundToPort(DeviceEndpoint.Port)
-			.WithReceiveBufferSize(RECV_BUFFER_SIZE);
+		for (const FIPv4Endpoint& Endpoint : DeviceEndpoints)
+		{
+			// What's captured is only what this source received, so capturing sources receive on their own
+			if (CaptureWriter.IsValid())
+			{
+				Demultiplexers.Add(FJSONLiveLinkModule::Get().GetReceiverService().CreatePrivate(Endpoint, Settings, CaptureWriter.Get(), TakePredecessor(Endpoint)));
+			}
+			else
+			{
+				Demultiplexers.Add(FJSONLiveLinkModule::Get().GetReceiverService().Acquire(Endpoint, Settings, TakePredecessor(Endpoint)));
+			}
+		}
 	}
 
-	RecvBuffer.SetNumUninitialized(RECV_BUFFER_SIZE);
-
-	if ((Socket != nullptr) && (Socket->GetSocketType() == SOCKTYPE_Datagram))
+	for (const TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>& Demultiplexer : Demultiplexers)
 	{
-		SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
-
-		Start();
+		Demultiplexer->AddSource(*this, Settings.AllowedSubjects);
+	}
 
+	if (IsSourceStillValid())
+	{
 		SourceStatus = LOCTEXT("SourceStatus_Receiving", "Receiving");
 	}
 }
 
-FJSONLiveLinkSource::~FJSONLiveLinkSource()
+bool FJSONLiveLinkSource::Reconfigure(const TArray<FIPv4Endpoint>& InEndpoints, const FJSONLiveLinkSourceSettings& InSettings)
 {
-	Stop();
-	if (Thread != nullptr)
+	if (InEndpoints.Num() == 0 && InSettings.ReplayFilename.IsEmpty())
 	{
-		Thread->WaitForCompletion();
-		delete Thread;
-		Thread = nullptr;
+		return false;
 	}
-	if (Socket != nullptr)
+
+	// Endpoints only this source received on are closed before anything is bound, the new sockets may want the same ports.
+	// Shared ones keep receiving for the other sources on them.
+	TArray<TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>> Predecessors;
+	for (const TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>& Demultiplexer : Demultiplexers)
+	{
+		if (Demultiplexer->RemoveSource(*this) == 0)
+		{
+			Demultiplexer->Join();
+			Predecessors.Add(Demultiplexer);
+		}
+	}
+	Demultiplexers.Reset();
+
+	// Nothing appends to it anymore, flushed before another capture may open the same file. Opening the same one again
+	// would truncate what's been captured so far, that writer is kept.
+	if (InSettings.CaptureFilename != Settings.CaptureFilename)
 	{
-		Socket->Close();
-		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		CaptureWriter.Reset();
 	}
+
+	DeviceEndpoints = InEndpoints;
+	Settings = InSettings;
+
+	// The subjects stay registered, their static data is only pushed again where the new settings change it
+	StartReceiving(Predecessors);
+
+	// The new workers count from zero
+	StatusSummary = MakeUnique<FJSONLiveLinkStatusSummary>();
+
+	UE_LOG(LogJSONLiveLink, Log, TEXT("Reconfigured source to %s"), *GetConnectionString());
+	return true;
+}
+
+bool FJSONLiveLinkSource::Reconfigure(const FString& ConnectionString)
+{
+	// Options the string leaves out keep their current value
+	TArray<FIPv4Endpoint> Endpoints;
+	FJSONLiveLinkSourceSettings NewSettings = Settings;
+	return ParseConnectionString(ConnectionString, Endpoints, NewSettings) && Reconfigure(Endpoints, NewSettings);
+}
+
+FString FJSONLiveLinkSource::GetConnectionString() const
+{
+	return MakeConnectionString(DeviceEndpoints, Settings);
+}
+
+TArray<FJSONLiveLinkSource*> FJSONLiveLinkSource::LiveSources;
+FCriticalSection FJSONLiveLinkSource::LiveSourcesCriticalSection;
+
+void FJSONLiveLinkSource::GetLiveSources(TArray<FJSONLiveLinkSource*>& OutSources)
+{
+	FScopeLock Lock(&LiveSourcesCriticalSection);
+	OutSources = LiveSources;
+}
+
+FJSONLiveLinkSource::~FJSONLiveLinkSource()
+{
+	// Stop every worker before joining any of them, then flush what they captured. Shared endpoints keep receiving for the
+	// other sources on them.
+	RequestSourceShutdown();
+	Demultiplexers.Reset();
+	CaptureWriter.Reset();
 }
 
 void FJSONLiveLinkSource::ReceiveClient(ILiveLinkClient* InClient, FGuid InSourceGuid)
@@ -94,259 +190,450 @@ void FJSONLiveLinkSource::ReceiveClient(ILiveLinkClient* InClient, FGuid InSourc
 
 bool FJSONLiveLinkSource::IsSourceStillValid() const
 {
-	// Source is valid if we have a valid thread and socket
-	bool bIsSourceValid = !Stopping && Thread != nullptr && Socket != nullptr;
+	// Source is valid if every worker has a valid thread and socket
+	bool bIsSourceValid = Demultiplexers.Num() > 0;
+	for (const TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>& Demultiplexer : Demultiplexers)
+	{
+		bIsSourceValid &= Demultiplexer->IsValid();
+	}
 	return bIsSourceValid;
 }
 
 
 bool FJSONLiveLinkSource::RequestSourceShutdown()
 {
-	Stop();
+	{
+		FScopeLock Lock(&LiveSourcesCriticalSection);
+		LiveSources.Remove(this);
+	}
+
+	// Nothing is pushed to us once removed, the workers only stop when no other source is left on them
+	for (const TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>& Demultiplexer : Demultiplexers)
+	{
+		if (Demultiplexer->RemoveSource(*this) == 0)
+		{
+			Demultiplexer->Stop();
+		}
+	}
 
 	return true;
 }
-// FRunnable interface
 
-void FJSONLiveLinkSource::Start()
+FText FJSONLiveLinkSource::GetSourceStatus() const
 {
-	ThreadName = "JSON UDP Receiver ";
-	ThreadName.AppendInt(FAsyncThreadIndex::GetNext());
-	
-	Thread = FRunnableThread::Create(this, *ThreadName, 128 * 1024, TPri_AboveNormal, FPlatformAffinity::GetPoolThreadMask());
-}
+	const double Now = FPlatformTime::Seconds();
+	if (!IsSourceStillValid() || !StatusSummary->IsUpdateDue(Now))
+	{
+		return IsSourceStillValid() ? StatusSummary->GetStatus() : SourceStatus;
+	}
 
-void FJSONLiveLinkSource::Stop()
-{
-	Stopping = true;
-}
+	FJSONLiveLinkStatusCounters Counters;
 
-uint32 FJSONLiveLinkSource::Run()
-{
-	TSharedRef<FInternetAddr> Sender = SocketSubsystem->CreateInternetAddr();
-	
-	while (!Stopping)
+	// Shared endpoints count everything they received, for every source on them
+	for (const TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>& Demultiplexer : Demultiplexers)
 	{
-		if (Socket->Wait(ESocketWaitConditions::WaitForRead, WaitTime))
+		for (const TUniquePtr<FJSONLiveLinkWorker>& Worker : Demultiplexer->GetWorkers())
 		{
-			uint32 Size;
-
-			while (Socket->HasPendingData(Size))
+			Worker->GetStats().AddTo(Counters.Stats);
+			Worker->GetLatencyStats().AddTotalTo(Counters.Latency);
+			Counters.QueueDepth += Worker->GetQueueDepth();
+			Counters.NumDropped += Worker->GetNumOverruns() + Worker->GetNumDecompressFailures();
+			Counters.NumCoalesced += Worker->GetNumCoalescedFrames();
+			Counters.NumLost += Worker->GetSequenceTracker().GetNumLost();
+			Counters.NumReordered += Worker->GetSequenceTracker().GetNumReordered();
+			Counters.NumDuplicates += Worker->GetSequenceTracker().GetNumDuplicates();
+			Counters.NumShed += Worker->GetBackpressure().GetNumShed();
+			++Counters.NumWorkers;
+			if (Worker->GetBackpressure().IsDegraded(Now))
 			{
-				int32 Read = 0;
-
-				if (Socket->RecvFrom(RecvBuffer.GetData(), RecvBuffer.Num(), Read, *Sender))
-				{
-					if (Read > 0)
-					{
-						TSharedPtr<TArray<uint8>, ESPMode::ThreadSafe> ReceivedData = MakeShareable(new TArray<uint8>());
-						ReceivedData->SetNumUninitialized(Read);
-						memcpy(ReceivedData->GetData(), RecvBuffer.GetData(), Read);
-						AsyncTask(ENamedThreads::GameThread, [this, ReceivedData]() { HandleReceivedData(ReceivedData); });
-					}
-				}
+				++Counters.NumDegraded;
+				Counters.DegradedPolicy = GetBackpressurePolicyName(Worker->GetBackpressure().GetPolicy());
 			}
 		}
 	}
-	return 0;
+	if (CaptureWriter.IsValid())
+	{
+		Counters.NumCaptureDropped = CaptureWriter->GetNumDropped();
+	}
+	{
+		FScopeLock Lock(&SubjectsCriticalSection);
+		for (const TPair<FName, FSubjectState>& Subject : EncounteredSubjects)
+		{
+			Counters.SubjectFrames.Add(Subject.Key, Subject.Value.NumFrames);
+		}
+	}
+
+	StatusSummary->Update(Now, SourceStatus, MoveTemp(Counters));
+	return StatusSummary->GetStatus();
 }
 
-void FJSONLiveLinkSource::HandleReceivedData(TSharedPtr<TArray<uint8>, ESPMode::ThreadSafe> ReceivedData)
+bool FJSONLiveLinkSource::ParseConnectionString(const FString& ConnectionString, TArray<FIPv4Endpoint>& OutEndpoints, FJSONLiveLinkSourceSettings& InOutSettings)
 {
-	FString JsonString;
-	JsonString.Empty(ReceivedData->Num());
-	for (uint8& Byte : *ReceivedData.Get())
+	FString EndpointList = ConnectionString;
+	FString Options;
+	ConnectionString.Split(TEXT(";"), &EndpointList, &Options);
+
+	TArray<FString> EndpointStrings;
+	EndpointList.ParseIntoArray(EndpointStrings, TEXT(","));
+	OutEndpoints.Reset();
+	for (const FString& EndpointString : EndpointStrings)
 	{
-		JsonString += TCHAR(Byte);
+		FIPv4Endpoint Endpoint;
+		if (!FIPv4Endpoint::Parse(EndpointString.TrimStartAndEnd(), Endpoint))
+		{
+			UE_LOG(LogJSONLiveLink, Warning, TEXT("Ignoring invalid endpoint '%s'"), *EndpointString);
+			continue;
+		}
+		OutEndpoints.Add(Endpoint);
 	}
-	//UE_LOG(LogTemp, Warning, TEXT("This is the data: %s"), *JsonString);
 
+	FParse::Value(*Options, TEXT("Workers="), InOutSettings.WorkersPerEndpoint);
+	FParse::Value(*Options, TEXT("Capture="), InOutSettings.CaptureFilename);
+	FParse::Value(*Options, TEXT("Replay="), InOutSettings.ReplayFilename);
+	FParse::Bool(*Options, TEXT("ReplayFast="), InOutSettings.bReplayAsFastAsPossible);
+	FParse::Value(*Options, TEXT("StackSize="), InOutSettings.ThreadStackSize);
+	FParse::Value(*Options, TEXT("RecvBuffer="), InOutSettings.SocketReceiveBufferSize);
+	FParse::Value(*Options, TEXT("MaxDatagram="), InOutSettings.MaxDatagramSize);
+	FParse::Value(*Options, TEXT("Dictionary="), InOutSettings.CompressionDictionaryFilename);
+	FParse::Value(*Options, TEXT("ParallelDecode="), InOutSettings.ParallelDecodeThreshold);
+	FParse::Value(*Options, TEXT("Batch="), InOutSettings.ReceiveBatchSize);
+	FParse::Value(*Options, TEXT("Ring="), InOutSettings.PacketRingCapacity);
+	FParse::Bool(*Options, TEXT("Coalesce="), InOutSettings.bCoalesceFrames);
+
+	FString DecodeOn;
+	if (FParse::Value(*Options, TEXT("DecodeOn="), DecodeOn))
+	{
+		if (DecodeOn == TEXT("GameThread"))
+		{
+			InOutSettings.bDecodeOnReceiverThread = false;
+		}
+		else if (DecodeOn == TEXT("ReceiverThread"))
+		{
+			InOutSettings.bDecodeOnReceiverThread = true;
+		}
+		else
+		{
+			UE_LOG(LogJSONLiveLink, Warning, TEXT("Ignoring invalid decode thread '%s'"), *DecodeOn);
+		}
+	}
 
-	
-	TSharedPtr<FJsonObject> JsonObject;
-	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(JsonString);
-	// UE_LOG(LogTemp, Warning, TEXT("Some warning message2"));
+	FString Delay;
+	if (FParse::Value(*Options, TEXT("Delay="), Delay))
+	{
+		InOutSettings.InterpolationDelay = FCString::Atod(*Delay);
+	}
 
+	// Numerator/Denominator, e.g. 30000/1001
+	FString FrameRate;
+	if (FParse::Value(*Options, TEXT("FrameRate="), FrameRate))
+	{
+		FString Numerator = FrameRate;
+		FString Denominator = TEXT("1");
+		FrameRate.Split(TEXT("/"), &Numerator, &Denominator);
+		const int32 ParsedNumerator = FCString::Atoi(*Numerator);
+		const int32 ParsedDenominator = FCString::Atoi(*Denominator);
+		if (ParsedNumerator > 0 && ParsedDenominator > 0)
+		{
+			InOutSettings.FrameRate = FFrameRate(ParsedNumerator, ParsedDenominator);
+		}
+		else
+		{
+			UE_LOG(LogJSONLiveLink, Warning, TEXT("Ignoring invalid frame rate '%s'"), *FrameRate);
+		}
+	}
 
-	if (FJsonSerializer::Deserialize(Reader, JsonObject))
+	FString NameList;
+	if (FParse::Value(*Options, TEXT("Subjects="), NameList))
 	{
-		for (TPair<FString, TSharedPtr<FJsonValue>>& JsonField : JsonObject->Values)
+		ParseNameList(NameList, InOutSettings.AllowedSubjects);
+	}
+	if (FParse::Value(*Options, TEXT("Bones="), NameList))
+	{
+		ParseNameList(NameList, InOutSettings.AllowedBones);
+	}
+	if (FParse::Value(*Options, TEXT("Parameters="), NameList))
+	{
+		ParseNameList(NameList, InOutSettings.AllowedParameters);
+	}
+
+	FString Transport;
+	if (FParse::Value(*Options, TEXT("Transport="), Transport))
+	{
+		if (Transport == TEXT("Tcp"))
 		{
-			const TSharedPtr<FJsonObject> MyJsonObject = JsonField.Value->AsObject();
+			InOutSettings.Transport = EJSONLiveLinkTransport::Tcp;
+		}
+		else if (Transport == TEXT("Udp"))
+		{
+			InOutSettings.Transport = EJSONLiveLinkTransport::Udp;
+		}
+		else
+		{
+			UE_LOG(LogJSONLiveLink, Warning, TEXT("Ignoring invalid transport '%s'"), *Transport);
+		}
+	}
+
+	FString Backpressure;
+	if (FParse::Value(*Options, TEXT("Backpressure="), Backpressure) && !ParseBackpressurePolicy(Backpressure, InOutSettings.BackpressurePolicy))
+	{
+		UE_LOG(LogJSONLiveLink, Warning, TEXT("Ignoring invalid backpressure policy '%s'"), *Backpressure);
+	}
+	FParse::Value(*Options, TEXT("DecimateRate="), InOutSettings.DecimateRate);
+	FParse::Value(*Options, TEXT("QueueDepth="), InOutSettings.BackpressureQueueDepth);
+	FParse::Value(*Options, TEXT("BusyThreshold="), InOutSettings.BackpressureBusyThreshold);
 
-			FName SubjectName(*JsonField.Key);
-			const TArray<TSharedPtr<FJsonValue>>* BoneArray ;
-			const TArray<TSharedPtr<FJsonValue>>* ParameterArray;
+	FString Priority;
+	if (FParse::Value(*Options, TEXT("Priority="), Priority) && !ParseThreadPriority(Priority, InOutSettings.ThreadPriority))
+	{
+		UE_LOG(LogJSONLiveLink, Warning, TEXT("Ignoring invalid thread priority '%s'"), *Priority);
+	}
 
-			bool bCreateSubject = !EncounteredSubjects.Contains(SubjectName);
+	// Hex with a 0x prefix, decimal otherwise
+	FString Affinity;
+	if (FParse::Value(*Options, TEXT("Affinity="), Affinity))
+	{
+		InOutSettings.ThreadAffinityMask = FCString::Strtoui64(*Affinity, nullptr, 0);
+	}
 
-			
+	return OutEndpoints.Num() > 0 || !InOutSettings.ReplayFilename.IsEmpty();
+}
 
+FString FJSONLiveLinkSource::MakeConnectionString(const TArray<FIPv4Endpoint>& Endpoints, const FJSONLiveLinkSourceSettings& Settings)
+{
+	FString ConnectionString;
+	for (const FIPv4Endpoint& Endpoint : Endpoints)
+	{
+		if (!ConnectionString.IsEmpty())
+		{
+			ConnectionString += TEXT(",");
+		}
+		ConnectionString += Endpoint.ToString();
+	}
+	if (Settings.Transport == EJSONLiveLinkTransport::Tcp)
+	{
+		ConnectionString += TEXT(";Transport=Tcp");
+	}
+	if (Settings.WorkersPerEndpoint > 1)
+	{
+		ConnectionString += FString::Printf(TEXT(";Workers=%d"), Settings.WorkersPerEndpoint);
+	}
+	if (!Settings.CaptureFilename.IsEmpty())
+	{
+		ConnectionString += FString::Printf(TEXT(";Capture=\"%s\""), *Settings.CaptureFilename);
+	}
+	if (!Settings.ReplayFilename.IsEmpty())
+	{
+		ConnectionString += FString::Printf(TEXT(";Replay=\"%s\""), *Settings.ReplayFilename);
+		if (Settings.bReplayAsFastAsPossible)
+		{
+			ConnectionString += TEXT(";ReplayFast=true");
+		}
+	}
 
+	if (Settings.ParallelDecodeThreshold > 0)
+	{
+		ConnectionString += FString::Printf(TEXT(";ParallelDecode=%d"), Settings.ParallelDecodeThreshold);
+	}
+	if (!Settings.CompressionDictionaryFilename.IsEmpty())
+	{
+		ConnectionString += FString::Printf(TEXT(";Dictionary=\"%s\""), *Settings.CompressionDictionaryFilename);
+	}
+	if (Settings.AllowedSubjects.Num() > 0)
+	{
+		ConnectionString += FString::Printf(TEXT(";Subjects=\"%s\""), *JoinNameList(Settings.AllowedSubjects));
+	}
+	if (Settings.AllowedBones.Num() > 0)
+	{
+		ConnectionString += FString::Printf(TEXT(";Bones=\"%s\""), *JoinNameList(Settings.AllowedBones));
+	}
+	if (Settings.AllowedParameters.Num() > 0)
+	{
+		ConnectionString += FString::Printf(TEXT(";Parameters=\"%s\""), *JoinNameList(Settings.AllowedParameters));
+	}
 
-			FLiveLinkStaticDataStruct StaticDataStruct = FLiveLinkStaticDataStruct(FLiveLinkSkeletonStaticData::StaticStruct());
-			FLiveLinkSkeletonStaticData& StaticData = *StaticDataStruct.Cast<FLiveLinkSkeletonStaticData>();
+	const FJSONLiveLinkSourceSettings Defaults;
+	if (Settings.bDecodeOnReceiverThread != Defaults.bDecodeOnReceiverThread)
+	{
+		ConnectionString += Settings.bDecodeOnReceiverThread ? TEXT(";DecodeOn=ReceiverThread") : TEXT(";DecodeOn=GameThread");
+	}
+	if (Settings.ReceiveBatchSize != Defaults.ReceiveBatchSize)
+	{
+		ConnectionString += FString::Printf(TEXT(";Batch=%d"), Settings.ReceiveBatchSize);
+	}
+	if (Settings.PacketRingCapacity != Defaults.PacketRingCapacity)
+	{
+		ConnectionString += FString::Printf(TEXT(";Ring=%d"), Settings.PacketRingCapacity);
+	}
+	if (Settings.bCoalesceFrames != Defaults.bCoalesceFrames)
+	{
+		ConnectionString += Settings.bCoalesceFrames ? TEXT(";Coalesce=true") : TEXT(";Coalesce=false");
+	}
+	if (Settings.InterpolationDelay != Defaults.InterpolationDelay)
+	{
+		ConnectionString += FString::Printf(TEXT(";Delay=%g"), Settings.InterpolationDelay);
+	}
+	if (Settings.FrameRate != Defaults.FrameRate)
+	{
+		ConnectionString += FString::Printf(TEXT(";FrameRate=%d/%d"), Settings.FrameRate.Numerator, Settings.FrameRate.Denominator);
+	}
+	if (Settings.BackpressurePolicy != Defaults.BackpressurePolicy)
+	{
+		ConnectionString += FString::Printf(TEXT(";Backpressure=%s"), GetBackpressurePolicyName(Settings.BackpressurePolicy));
+	}
+	if (Settings.DecimateRate != Defaults.DecimateRate)
+	{
+		ConnectionString += FString::Printf(TEXT(";DecimateRate=%g"), Settings.DecimateRate);
+	}
+	if (Settings.BackpressureQueueDepth != Defaults.BackpressureQueueDepth)
+	{
+		ConnectionString += FString::Printf(TEXT(";QueueDepth=%d"), Settings.BackpressureQueueDepth);
+	}
+	if (Settings.BackpressureBusyThreshold != Defaults.BackpressureBusyThreshold)
+	{
+		ConnectionString += FString::Printf(TEXT(";BusyThreshold=%g"), Settings.BackpressureBusyThreshold);
+	}
+	if (Settings.ThreadPriority != Defaults.ThreadPriority)
+	{
+		ConnectionString += FString::Printf(TEXT(";Priority=%s"), GetThreadPriorityName(Settings.ThreadPriority));
+	}
+	if (Settings.ThreadAffinityMask != Defaults.ThreadAffinityMask)
+	{
+		ConnectionString += FString::Printf(TEXT(";Affinity=0x%llx"), Settings.ThreadAffinityMask);
+	}
+	if (Settings.ThreadStackSize != Defaults.ThreadStackSize)
+	{
+		ConnectionString += FString::Printf(TEXT(";StackSize=%u"), Settings.ThreadStackSize);
+	}
+	if (Settings.SocketReceiveBufferSize != Defaults.SocketReceiveBufferSize)
+	{
+		ConnectionString += FString::Printf(TEXT(";RecvBuffer=%d"), Settings.SocketReceiveBufferSize);
+	}
+	if (Settings.MaxDatagramSize != Defaults.MaxDatagramSize)
+	{
+		ConnectionString += FString::Printf(TEXT(";MaxDatagram=%d"), Settings.MaxDatagramSize);
+	}
+	return ConnectionString;
+}
 
-			FLiveLinkFrameDataStruct FrameDataStruct = FLiveLinkFrameDataStruct(FLiveLinkAnimationFrameData::StaticStruct());
-			FLiveLinkAnimationFrameData& FrameData = *FrameDataStruct.Cast<FLiveLinkAnimationFrameData>();
+void FJSONLiveLinkSource::ParseNameList(const FString& NameList, TArray<FName>& OutNames)
+{
+	TArray<FString> NameStrings;
+	NameList.ParseIntoArray(NameStrings, TEXT(","));
+	OutNames.Reset();
+	for (const FString& NameString : NameStrings)
+	{
+		const FString Name = NameString.TrimStartAndEnd();
+		if (!Name.IsEmpty())
+		{
+			OutNames.AddUnique(FName(*Name));
+		}
+	}
+}
 
+FString FJSONLiveLinkSource::JoinNameList(const TArray<FName>& Names)
+{
+	FString NameList;
+	for (FName Name : Names)
+	{
+		if (!NameList.IsEmpty())
+		{
+			NameList += TEXT(",");
+		}
+		NameList += Name.ToString();
+	}
+	return NameList;
+}
 
-			double headRoll = 0;
-			double headPitch = 0;
-			double headYaw = 0;
-			
-			if (MyJsonObject->TryGetArrayField(TEXT("Bone"), BoneArray))
-			{
-				StaticData.BoneNames.SetNumUninitialized(BoneArray->Num());
-				StaticData.BoneParents.SetNumUninitialized(BoneArray->Num());
-				FrameData.Transforms.SetNumUninitialized(BoneArray->Num());
-			
-
-				for (int BoneIdx = 0; BoneIdx < BoneArray->Num(); ++BoneIdx)
-				{
-					const TSharedPtr<FJsonValue>& Bone = (*BoneArray)[BoneIdx];
-					const TSharedPtr<FJsonObject> BoneObject = Bone->AsObject();
-
-					FString BoneName;
-					if (BoneObject->TryGetStringField(TEXT("Name"), BoneName))
-					{
-						StaticData.BoneNames[BoneIdx] = FName(*BoneName);
-					}
-					else
-					{
-						// Invalid Json Format
-						return;
-					}
-
-					int32 BoneParentIdx;
-					if (BoneObject->TryGetNumberField("Parent", BoneParentIdx))
-					{
-						StaticData.BoneParents[BoneIdx] = BoneParentIdx;
-					}
-					else
-					{
-						// Invalid Json Format
-						return;
-					}
-				}
-
-				for (int BoneIdx = 0; BoneIdx < BoneArray->Num(); ++BoneIdx)
-				{
-					const TSharedPtr<FJsonValue>& Bone = (*BoneArray)[BoneIdx];
-					const TSharedPtr<FJsonObject> BoneObject = Bone->AsObject();
-
-					const TArray<TSharedPtr<FJsonValue>>* LocationArray;
-					FVector BoneLocation;
-					if (BoneObject->TryGetArrayField(TEXT("Location"), LocationArray) 
-						&& LocationArray->Num() == 3) // X, Y, Z
-					{
-						double X = (*LocationArray)[0]->AsNumber();
-						double Y = (*LocationArray)[1]->AsNumber();
-						double Z = (*LocationArray)[2]->AsNumber();
-						BoneLocation = FVector(X, Y, Z);
-					}
-					else
-					{
-						// Invalid Json Format
-						return;
-					}
-
-					const TArray<TSharedPtr<FJsonValue>>* RotationArray;
-					FQuat BoneQuat;
-					if (BoneObject->TryGetArrayField(TEXT("Rotation"), RotationArray)
-						&& RotationArray->Num() == 4) // X, Y, Z, W
-					{
-						double qx = (*RotationArray)[0]->AsNumber();
-						double qy = (*RotationArray)[1]->AsNumber();
-						double qz = (*RotationArray)[2]->AsNumber();
-						double qw = (*RotationArray)[3]->AsNumber();
-						headRoll  = -atan2(2.0*(qx*qy + qw*qz), qw*qw + qx*qx - qy*qy - qz*qz);
-						// headPitch = asin(-2.0*(qx*qz - qw*qy));
-						// headYaw  = atan2(2.0*(qy*qz + qw*qx), qw*qw - qx*qx - qy*qy + qz*qz);
-						headPitch  = atan2(2.0*(qy*qz + qw*qx), qw*qw - qx*qx - qy*qy + qz*qz);
-						headYaw = -asin(-2.0*(qx*qz - qw*qy));
-						BoneQuat = FQuat(qx, qy, qz, qw);
-					}
-					else
-					{
-						// Invalid Json Format
-						return;
-					}
-
-					const TArray<TSharedPtr<FJsonValue>>* ScaleArray;
-					FVector BoneScale;
-					if (BoneObject->TryGetArrayField(TEXT("Scale"), ScaleArray)
-						&& ScaleArray->Num() == 3) // X, Y, Z
-					{
-						double X = (*ScaleArray)[0]->AsNumber();
-						double Y = (*ScaleArray)[1]->AsNumber();
-						double Z = (*ScaleArray)[2]->AsNumber();
-						BoneScale = FVector(X, Y, Z);
-					}
-					else
-					{
-						// Invalid Json Format
-						return;
-					}
-
-					FrameData.Transforms[BoneIdx] = FTransform(BoneQuat, BoneLocation, BoneScale);
-				}
-			}
+static const TPair<EThreadPriority, const TCHAR*> ThreadPriorityNames[] =
+{
+	{ TPri_Lowest, TEXT("Lowest") },
+	{ TPri_BelowNormal, TEXT("BelowNormal") },
+	{ TPri_Normal, TEXT("Normal") },
+	{ TPri_AboveNormal, TEXT("AboveNormal") },
+	{ TPri_Highest, TEXT("Highest") },
+	{ TPri_TimeCritical, TEXT("TimeCritical") },
+};
+
+const TCHAR* FJSONLiveLinkSource::GetThreadPriorityName(EThreadPriority Priority)
+{
+	for (const TPair<EThreadPriority, const TCHAR*>& Name : ThreadPriorityNames)
+	{
+		if (Name.Key == Priority)
+		{
+			return Name.Value;
+		}
+	}
+	return TEXT("Normal");
+}
 
-			if (MyJsonObject->TryGetArrayField(TEXT("Parameter"), ParameterArray))
-			{
-				int raw_array_length = ParameterArray->Num();
-				StaticData.PropertyNames.SetNumUninitialized(raw_array_length+3);
-				FrameData.PropertyValues.SetNumUninitialized(raw_array_length+3);
-
-				// Setup Head Rotation
-				StaticData.PropertyNames[raw_array_length] = FName("headRoll");
-				FrameData.PropertyValues[raw_array_length] = headRoll;
-				StaticData.PropertyNames[raw_array_length+1] = FName("headPitch");
-				FrameData.PropertyValues[raw_array_length+1] = headPitch;
-				StaticData.PropertyNames[raw_array_length+2] = FName("headYaw");
-				FrameData.PropertyValues[raw_array_length+2] = headYaw;
-
-				// UE_LOG(LogTemp, Warning, TEXT("headRoll: %.4f, headPitch: %.4f, headYaw: %.4f"), headRoll, headPitch, headYaw);
-
-				for (int i = 0; i < ParameterArray->Num(); ++i)
-				{
-					const TSharedPtr<FJsonValue>& param = (*ParameterArray)[i];
-					const TSharedPtr<FJsonObject> paramobject = param->AsObject();
-
-					FString parameterName;
-					if (paramobject->TryGetStringField(TEXT("Name"), parameterName))
-					{
-						StaticData.PropertyNames[i] = FName(*parameterName);
-					}
-					else
-					{
-						// invalid json format
-						return;
-					}
-				}
-
-				for (int i = 0; i < ParameterArray->Num(); i++) 
-				{
-					const TSharedPtr<FJsonValue>& param = (*ParameterArray)[i];
-					const TSharedPtr<FJsonObject> paramObject = param->AsObject();
-					double value;
-					if (paramObject->TryGetNumberField(TEXT("Value"), value)) 
-					{
-						FrameData.PropertyValues[i] = (float)value;
-					}
-					else
-					{
-						return;
-					}
-				}
-			}
+bool FJSONLiveLinkSource::ParseThreadPriority(const FString& Name, EThreadPriority& OutPriority)
+{
+	for (const TPair<EThreadPriority, const TCHAR*>& PriorityName : ThreadPriorityNames)
+	{
+		if (Name.Equals(PriorityName.Value, ESearchCase::IgnoreCase))
+		{
+			OutPriority = PriorityName.Key;
+			return true;
+		}
+	}
+	return false;
+}
+
+static const TPair<EJSONLiveLinkBackpressurePolicy, const TCHAR*> BackpressurePolicyNames[] =
+{
+	{ EJSONLiveLinkBackpressurePolicy::None, TEXT("None") },
+	{ EJSONLiveLinkBackpressurePolicy::DropOldest, TEXT("DropOldest") },
+	{ EJSONLiveLinkBackpressurePolicy::Coalesce, TEXT("Coalesce") },
+	{ EJSONLiveLinkBackpressurePolicy::Decimate, TEXT("Decimate") },
+};
 
-			Client->PushSubjectStaticData_AnyThread({ SourceGuid, SubjectName }, ULiveLinkAnimationRole::StaticClass(), MoveTemp(StaticDataStruct));
-			EncounteredSubjects.Add(SubjectName);
-			Client->PushSubjectFrameData_AnyThread({SourceGuid, SubjectName}, MoveTemp(FrameDataStruct));
+const TCHAR* FJSONLiveLinkSource::GetBackpressurePolicyName(EJSONLiveLinkBackpressurePolicy Policy)
+{
+	for (const TPair<EJSONLiveLinkBackpressurePolicy, const TCHAR*>& Name : BackpressurePolicyNames)
+	{
+		if (Name.Key == Policy)
+		{
+			return Name.Value;
 		}
 	}
+	return TEXT("None");
+}
+
+bool FJSONLiveLinkSource::ParseBackpressurePolicy(const FString& Name, EJSONLiveLinkBackpressurePolicy& OutPolicy)
+{
+	for (const TPair<EJSONLiveLinkBackpressurePolicy, const TCHAR*>& PolicyName : BackpressurePolicyNames)
+	{
+		if (Name.Equals(PolicyName.Value, ESearchCase::IgnoreCase))
+		{
+			OutPolicy = PolicyName.Key;
+			return true;
+		}
+	}
+	return false;
+}
+
+void FJSONLiveLinkSource::PushSubject(FName SubjectName, uint32 SchemaHash, const FLiveLinkSkeletonStaticData& StaticData, FLiveLinkFrameDataStruct&& FrameDataStruct)
+{
+	// Pushed under the lock, workers sharing a subject would otherwise get a frame of the new schema in ahead of its static
+	// data, or the old static data in after the new
+	FScopeLock Lock(&SubjectsCriticalSection);
+	FSubjectState* Subject = EncounteredSubjects.Find(SubjectName);
+
+	// Only (re)register the skeleton when the subject is new or its bones/properties changed
+	if (Subject == nullptr || Subject->SchemaHash != SchemaHash)
+	{
+		FLiveLinkStaticDataStruct StaticDataStruct = FLiveLinkStaticDataStruct(FLiveLinkSkeletonStaticData::StaticStruct());
+		*StaticDataStruct.Cast<FLiveLinkSkeletonStaticData>() = StaticData;
+		Client->PushSubjectStaticData_AnyThread({ SourceGuid, SubjectName }, ULiveLinkAnimationRole::StaticClass(), MoveTemp(StaticDataStruct));
+	}
+	if (Subject == nullptr)
+	{
+		Subject = &EncounteredSubjects.Add(SubjectName);
+	}
+	Subject->SchemaHash = SchemaHash;
+	++Subject->NumFrames;
+
+	Client->PushSubjectFrameData_AnyThread({SourceGuid, SubjectName}, MoveTemp(FrameDataStruct));
 }
 
 #undef LOCTEXT_NAMESPACE
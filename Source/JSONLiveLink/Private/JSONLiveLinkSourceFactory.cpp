@@ -23,18 +23,23 @@ TSharedPtr<SWidget> UJSONLiveLinkSourceFactory::BuildCreationPanel(FOnLiveLinkSo
 
 TSharedPtr<ILiveLinkSource> UJSONLiveLinkSourceFactory::CreateSource(const FString& InConnectionString) const
 {
-	FIPv4Endpoint DeviceEndPoint;
-	if (!FIPv4Endpoint::Parse(InConnectionString, DeviceEndPoint))
+	TArray<FIPv4Endpoint> DeviceEndPoints;
+	FJSONLiveLinkSourceSettings Settings;
+	if (!FJSONLiveLinkSource::ParseConnectionString(InConnectionString, DeviceEndPoints, Settings))
 	{
 		return TSharedPtr<ILiveLinkSource>();
 	}
 
-	return MakeShared<FJSONLiveLinkSource>(DeviceEndPoint);
+	return MakeShared<FJSONLiveLinkSource>(DeviceEndPoints, Settings);
 }
 
-void UJSONLiveLinkSourceFactory::OnOkClicked(FIPv4Endpoint InEndpoint, FOnLiveLinkSourceCreated InOnLiveLinkSourceCreated) const
+void UJSONLiveLinkSourceFactory::OnOkClicked(const FString& InConnectionString, FOnLiveLinkSourceCreated InOnLiveLinkSourceCreated) const
 {
-	InOnLiveLinkSourceCreated.ExecuteIfBound(MakeShared<FJSONLiveLinkSource>(InEndpoint), InEndpoint.ToString());
+	TSharedPtr<ILiveLinkSource> Source = CreateSource(InConnectionString);
+	if (Source.IsValid())
+	{
+		InOnLiveLinkSourceCreated.ExecuteIfBound(Source, InConnectionString);
+	}
 }
 
 #undef LOCTEXT_NAMESPACE
\ No newline at end of file
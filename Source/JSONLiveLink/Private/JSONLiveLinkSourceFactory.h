@@ -22,5 +22,5 @@ public:
 	virtual TSharedPtr<SWidget> BuildCreationPanel(FOnLiveLinkSourceCreated OnLiveLinkSourceCreated) const override;
 	TSharedPtr<ILiveLinkSource> CreateSource(const FString& ConnectionString) const override;
 private:
-	void OnOkClicked(FIPv4Endpoint Endpoint, FOnLiveLinkSourceCreated OnLiveLinkSourceCreated) const;
+	void OnOkClicked(const FString& ConnectionString, FOnLiveLinkSourceCreated OnLiveLinkSourceCreated) const;
 };
\ No newline at end of file
@@ -0,0 +1,213 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#include "JSONLiveLinkStats.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
+
+static const float BucketsPerOctave = 4.0f;
+
+FJSONLiveLinkStats::FJSONLiveLinkStats()
+: NumPackets(0)
+, NumBytes(0)
+{
+	for (TAtomic<uint32>& Bucket : DecodeBuckets)
+	{
+		Bucket.Store(0, EMemoryOrder::Relaxed);
+	}
+}
+
+void FJSONLiveLinkStats::AddPacket(int32 InNumBytes)
+{
+	NumPackets.IncrementExchange();
+	NumBytes.AddExchange(InNumBytes);
+}
+
+void FJSONLiveLinkStats::AddDecode(uint32 Cycles)
+{
+	DecodeBuckets[GetBucket(FPlatformTime::ToMilliseconds(Cycles) * 1000.0)].IncrementExchange();
+}
+
+int32 FJSONLiveLinkStats::GetBucket(double Microseconds)
+{
+	return Microseconds > 1.0 ? FMath::Min((int32)(FMath::Log2((float)Microseconds) * BucketsPerOctave), NumDecodeBuckets - 1) : 0;
+}
+
+void FJSONLiveLinkStats::AddTo(FSnapshot& Snapshot) const
+{
+	Snapshot.NumPackets += NumPackets.Load(EMemoryOrder::Relaxed);
+	Snapshot.NumBytes += NumBytes.Load(EMemoryOrder::Relaxed);
+	for (int32 Bucket = 0; Bucket < NumDecodeBuckets; ++Bucket)
+	{
+		Snapshot.DecodeBuckets[Bucket] += DecodeBuckets[Bucket].Load(EMemoryOrder::Relaxed);
+	}
+}
+
+double FJSONLiveLinkStats::GetDecodePercentile(const FSnapshot& Newer, const FSnapshot& Older, double Percentile)
+{
+	return GetPercentile(Newer.DecodeBuckets, Older.DecodeBuckets, Percentile);
+}
+
+double FJSONLiveLinkStats::GetPercentile(const uint64* NewerBuckets, const uint64* OlderBuckets, double Percentile)
+{
+	uint64 NumSamples = 0;
+	for (int32 Bucket = 0; Bucket < NumDecodeBuckets; ++Bucket)
+	{
+		NumSamples += NewerBuckets[Bucket] - (OlderBuckets != nullptr ? OlderBuckets[Bucket] : 0);
+	}
+	if (NumSamples == 0)
+	{
+		return 0.0;
+	}
+
+	const uint64 Rank = FMath::Max<uint64>((uint64)FMath::CeilToDouble(NumSamples * Percentile), 1);
+	uint64 NumBelow = 0;
+	for (int32 Bucket = 0; Bucket < NumDecodeBuckets; ++Bucket)
+	{
+		NumBelow += NewerBuckets[Bucket] - (OlderBuckets != nullptr ? OlderBuckets[Bucket] : 0);
+		if (NumBelow >= Rank)
+		{
+			// Upper bound of the bucket
+			return FMath::Pow(2.0f, (Bucket + 1) / BucketsPerOctave);
+		}
+	}
+	return FMath::Pow(2.0f, NumDecodeBuckets / BucketsPerOctave);
+}
+
+const TCHAR* FJSONLiveLinkLatencyStats::GetStageName(EStage Stage)
+{
+	switch (Stage)
+	{
+	case Transit: return TEXT("transit");
+	case Queue: return TEXT("queue");
+	case Decode: return TEXT("decode");
+	case Push: return TEXT("push");
+	case Total: return TEXT("total");
+	default: return TEXT("");
+	}
+}
+
+void FJSONLiveLinkLatencyStats::FHistograms::Add(const FHistograms& Other)
+{
+	for (int32 Stage = 0; Stage < NumStages; ++Stage)
+	{
+		for (int32 Bucket = 0; Bucket < FJSONLiveLinkStats::NumDecodeBuckets; ++Bucket)
+		{
+			Buckets[Stage][Bucket] += Other.Buckets[Stage][Bucket];
+		}
+	}
+}
+
+uint64 FJSONLiveLinkLatencyStats::FHistograms::GetNum(EStage Stage) const
+{
+	uint64 Num = 0;
+	for (int32 Bucket = 0; Bucket < FJSONLiveLinkStats::NumDecodeBuckets; ++Bucket)
+	{
+		Num += Buckets[Stage][Bucket];
+	}
+	return Num;
+}
+
+void FJSONLiveLinkLatencyStats::AddFrame(FName SubjectName, const FJSONLiveLinkFrameLatency& Latency)
+{
+	// Worked out before locking, a step that went backwards lands in the first bucket
+	const int32 TransitBucket = FJSONLiveLinkStats::GetBucket((Latency.ArrivalTime - Latency.SenderTime) * 1e6);
+	const int32 QueueBucket = FJSONLiveLinkStats::GetBucket((Latency.DecodeStartTime - Latency.ArrivalTime) * 1e6);
+	const int32 DecodeBucket = FJSONLiveLinkStats::GetBucket((Latency.DecodeEndTime - Latency.DecodeStartTime) * 1e6);
+	const int32 PushBucket = FJSONLiveLinkStats::GetBucket((Latency.PushEndTime - Latency.DecodeEndTime) * 1e6);
+	const int32 TotalBucket = FJSONLiveLinkStats::GetBucket((Latency.PushEndTime - Latency.ArrivalTime) * 1e6);
+
+	FScopeLock Lock(&CriticalSection);
+	FHistograms& Histograms = Subjects.FindOrAdd(SubjectName);
+	if (Latency.bHasSenderTime)
+	{
+		++Histograms.Buckets[Transit][TransitBucket];
+	}
+	++Histograms.Buckets[Queue][QueueBucket];
+	++Histograms.Buckets[Decode][DecodeBucket];
+	++Histograms.Buckets[Push][PushBucket];
+	++Histograms.Buckets[Total][TotalBucket];
+}
+
+void FJSONLiveLinkLatencyStats::AddTo(TMap<FName, FHistograms>& OutSubjects) const
+{
+	FScopeLock Lock(&CriticalSection);
+	for (const TPair<FName, FHistograms>& Subject : Subjects)
+	{
+		OutSubjects.FindOrAdd(Subject.Key).Add(Subject.Value);
+	}
+}
+
+void FJSONLiveLinkLatencyStats::AddTotalTo(FHistograms& OutTotal) const
+{
+	FScopeLock Lock(&CriticalSection);
+	for (const TPair<FName, FHistograms>& Subject : Subjects)
+	{
+		OutTotal.Add(Subject.Value);
+	}
+}
+
+#define LOCTEXT_NAMESPACE "JSONLiveLinkStats"
+
+void FJSONLiveLinkStatusSummary::Update(double Now, const FText& BaseStatus, FJSONLiveLinkStatusCounters&& Counters)
+{
+	const double Elapsed = Now - LastUpdateTime;
+	const bool bHasPrevious = LastUpdateTime > 0 && Elapsed > 0;
+
+	// Frame rates of the slowest and fastest subjects
+	double MinSubjectRate = 0;
+	double MaxSubjectRate = 0;
+	bool bFirstSubject = true;
+	for (const TPair<FName, uint32>& Subject : Counters.SubjectFrames)
+	{
+		const uint32* PreviousFrames = Previous.SubjectFrames.Find(Subject.Key);
+		const double SubjectRate = bHasPrevious ? (Subject.Value - (PreviousFrames != nullptr ? *PreviousFrames : 0)) / Elapsed : 0;
+		MinSubjectRate = bFirstSubject ? SubjectRate : FMath::Min(MinSubjectRate, SubjectRate);
+		MaxSubjectRate = FMath::Max(MaxSubjectRate, SubjectRate);
+		bFirstSubject = false;
+	}
+
+	FNumberFormattingOptions RateFormat;
+	RateFormat.MaximumFractionalDigits = 0;
+
+	FFormatNamedArguments Args;
+	Args.Add(TEXT("Status"), BaseStatus);
+	Args.Add(TEXT("PacketRate"), FText::AsNumber(bHasPrevious ? (Counters.Stats.NumPackets - Previous.Stats.NumPackets) / Elapsed : 0, &RateFormat));
+	Args.Add(TEXT("ByteRate"), FText::AsMemory(bHasPrevious ? (uint64)((Counters.Stats.NumBytes - Previous.Stats.NumBytes) / Elapsed) : 0));
+	Args.Add(TEXT("P50"), FText::AsNumber(FJSONLiveLinkStats::GetDecodePercentile(Counters.Stats, Previous.Stats, 0.5), &RateFormat));
+	Args.Add(TEXT("P99"), FText::AsNumber(FJSONLiveLinkStats::GetDecodePercentile(Counters.Stats, Previous.Stats, 0.99), &RateFormat));
+	Args.Add(TEXT("LatencyP99"), FText::AsNumber(Counters.Latency.GetPercentile(FJSONLiveLinkLatencyStats::Total, Previous.Latency, 0.99), &RateFormat));
+	Args.Add(TEXT("Queue"), Counters.QueueDepth);
+	Args.Add(TEXT("Subjects"), Counters.SubjectFrames.Num());
+	Args.Add(TEXT("MinSubjectRate"), FText::AsNumber(MinSubjectRate, &RateFormat));
+	Args.Add(TEXT("MaxSubjectRate"), FText::AsNumber(MaxSubjectRate, &RateFormat));
+	Status = FText::Format(LOCTEXT("StatusSummary", "{Status}: {PacketRate} pkt/s, {ByteRate}/s, decode p50 {P50}us p99 {P99}us, latency p99 {LatencyP99}us, queue {Queue}, {Subjects} subjects at {MinSubjectRate}-{MaxSubjectRate} Hz"), Args);
+
+	if (Counters.NumDegraded > 0)
+	{
+		FFormatNamedArguments DegradedArgs;
+		DegradedArgs.Add(TEXT("Status"), Status);
+		DegradedArgs.Add(TEXT("Policy"), FText::FromString(Counters.DegradedPolicy));
+		DegradedArgs.Add(TEXT("Degraded"), Counters.NumDegraded);
+		DegradedArgs.Add(TEXT("Workers"), Counters.NumWorkers);
+		Status = FText::Format(LOCTEXT("StatusSummaryDegraded", "{Status}, falling behind: {Policy} on {Degraded} of {Workers} workers"), DegradedArgs);
+	}
+
+	if (Counters.NumDropped != 0 || Counters.NumCoalesced != 0 || Counters.NumShed != 0 || Counters.NumLost != 0 || Counters.NumReordered != 0 || Counters.NumDuplicates != 0 || Counters.NumCaptureDropped != 0)
+	{
+		FFormatNamedArguments DropArgs;
+		DropArgs.Add(TEXT("Status"), Status);
+		DropArgs.Add(TEXT("Lost"), Counters.NumLost);
+		DropArgs.Add(TEXT("Reordered"), Counters.NumReordered);
+		DropArgs.Add(TEXT("Duplicates"), Counters.NumDuplicates);
+		DropArgs.Add(TEXT("Coalesced"), Counters.NumCoalesced);
+		DropArgs.Add(TEXT("Shed"), Counters.NumShed);
+		DropArgs.Add(TEXT("Dropped"), Counters.NumDropped);
+		DropArgs.Add(TEXT("CaptureDropped"), Counters.NumCaptureDropped);
+		Status = FText::Format(LOCTEXT("StatusSummaryDrops", "{Status} ({Lost} lost, {Reordered} reordered, {Duplicates} duplicate, {Coalesced} coalesced, {Shed} shed, {Dropped} dropped, {CaptureDropped} not captured)"), DropArgs);
+	}
+
+	Previous = MoveTemp(Counters);
+	LastUpdateTime = Now;
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,191 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Runtime/Launch/Resources/Version.h"
+#include "Stats/Stats.h"
+#include "Templates/Atomic.h"
+
+// CPU profiler events of the receive, decode and push steps for Unreal Insights, which engines before 4.25 don't have
+#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 25
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#define JSONLIVELINK_TRACE_SCOPE(Name) TRACE_CPUPROFILER_EVENT_SCOPE(Name)
+#else
+#define JSONLIVELINK_TRACE_SCOPE(Name)
+#endif
+
+// "stat JSONLiveLink", the cycle stats also show up in Unreal Insights traces
+DECLARE_STATS_GROUP(TEXT("JSONLiveLink"), STATGROUP_JSONLiveLink, STATCAT_Advanced);
+
+/**
+ * Monotonic counters of a worker, written by its receive and decode threads and read from any thread.
+ * Rates and percentiles are taken from the difference between two snapshots.
+ */
+class FJSONLiveLinkStats
+{
+public:
+
+	// Decode times are bucketed on a log scale, 4 buckets per power of two microseconds
+	static const int32 NumDecodeBuckets = 80;
+
+	struct FSnapshot
+	{
+		uint64 NumPackets = 0;
+		uint64 NumBytes = 0;
+		uint64 DecodeBuckets[NumDecodeBuckets] = {};
+	};
+
+	FJSONLiveLinkStats();
+
+	void AddPacket(int32 NumBytes);
+
+	void AddDecode(uint32 Cycles);
+
+	// Accumulates the current counters into Snapshot, so several workers can be summed
+	void AddTo(FSnapshot& Snapshot) const;
+
+	// Decode time in microseconds below which Percentile of the decodes between the two snapshots fall, 0 if there were none
+	static double GetDecodePercentile(const FSnapshot& Newer, const FSnapshot& Older, double Percentile);
+
+	// Bucket of a time in microseconds, in every histogram
+	static int32 GetBucket(double Microseconds);
+
+	// Same as GetDecodePercentile for any NumDecodeBuckets histogram, OlderBuckets null counts everything in NewerBuckets
+	static double GetPercentile(const uint64* NewerBuckets, const uint64* OlderBuckets, double Percentile);
+
+private:
+
+	TAtomic<uint64> NumPackets;
+	TAtomic<uint64> NumBytes;
+	TAtomic<uint32> DecodeBuckets[NumDecodeBuckets];
+};
+
+/** When a frame went through each step from the sender to LiveLink, all FPlatformTime::Seconds() */
+struct FJSONLiveLinkFrameLatency
+{
+	// Sender timestamp mapped to the local clock, when the packet had one
+	double SenderTime = 0;
+	bool bHasSenderTime = false;
+
+	// The batch the packet was in came off the socket
+	double ArrivalTime = 0;
+
+	// The packet's decode started, once it was out of the queue
+	double DecodeStartTime = 0;
+
+	// The frame was decoded and about to be pushed
+	double DecodeEndTime = 0;
+
+	// Every source receiving the subject pushed it to LiveLink
+	double PushEndTime = 0;
+};
+
+/**
+ * Histograms of how long each subject's frames take between the steps from the sender to the LiveLink push, bucketed like
+ * decode times. Written by whichever thread decodes a worker's packets and read from any thread.
+ */
+class FJSONLiveLinkLatencyStats
+{
+public:
+
+	enum EStage
+	{
+		// Sender timestamp to arrival. Clocks are synced to the fastest packet seen lately, so this is the delay on top of it.
+		Transit,
+
+		// Arrival to the decode starting, waiting for the GameThread unless decoding on the receiver thread
+		Queue,
+
+		// Decode start to the frame being decoded, for every subject decoded before it in the same packet too
+		Decode,
+
+		// Through the demultiplexer into the LiveLink client of every source receiving the subject
+		Push,
+
+		// Arrival to pushed
+		Total,
+
+		NumStages
+	};
+
+	static const TCHAR* GetStageName(EStage Stage);
+
+	struct FHistograms
+	{
+		uint64 Buckets[NumStages][FJSONLiveLinkStats::NumDecodeBuckets] = {};
+
+		void Add(const FHistograms& Other);
+
+		uint64 GetNum(EStage Stage) const;
+
+		// Microseconds below which Percentile of the stage's frames fall, 0 if there were none
+		double GetPercentile(EStage Stage, double Percentile) const { return FJSONLiveLinkStats::GetPercentile(Buckets[Stage], nullptr, Percentile); }
+		double GetPercentile(EStage Stage, const FHistograms& Older, double Percentile) const { return FJSONLiveLinkStats::GetPercentile(Buckets[Stage], Older.Buckets[Stage], Percentile); }
+	};
+
+	void AddFrame(FName SubjectName, const FJSONLiveLinkFrameLatency& Latency);
+
+	// Accumulates each subject's histograms, so several workers can be summed
+	void AddTo(TMap<FName, FHistograms>& OutSubjects) const;
+
+	// Accumulates every subject's histograms into one
+	void AddTotalTo(FHistograms& OutTotal) const;
+
+private:
+
+	TMap<FName, FHistograms> Subjects;
+
+	// Guards Subjects
+	mutable FCriticalSection CriticalSection;
+};
+
+/** Everything the status summary is built from, summed over a source's workers */
+struct FJSONLiveLinkStatusCounters
+{
+	FJSONLiveLinkStats::FSnapshot Stats;
+
+	// Every subject's frame latencies together
+	FJSONLiveLinkLatencyStats::FHistograms Latency;
+
+	// Frames pushed so far for each subject
+	TMap<FName, uint32> SubjectFrames;
+
+	int32 QueueDepth = 0;
+	int64 NumDropped = 0;
+	int32 NumCoalesced = 0;
+	int32 NumLost = 0;
+	int32 NumReordered = 0;
+	int32 NumDuplicates = 0;
+	int32 NumShed = 0;
+
+	// Datagrams received but lost because the capture file fell behind
+	int32 NumCaptureDropped = 0;
+
+	// Workers falling behind, and the backpressure policy they degrade with
+	int32 NumDegraded = 0;
+	int32 NumWorkers = 0;
+	FString DegradedPolicy;
+};
+
+/** Turns a source's counters into the status shown in the LiveLink panel, with rates over the time between updates */
+class FJSONLiveLinkStatusSummary
+{
+public:
+
+	// Seconds between updates, so rates are averaged over enough packets to be readable
+	static constexpr double UpdateInterval = 1.0;
+
+	bool IsUpdateDue(double Now) const { return Now - LastUpdateTime >= UpdateInterval; }
+
+	void Update(double Now, const FText& BaseStatus, FJSONLiveLinkStatusCounters&& Counters);
+
+	const FText& GetStatus() const { return Status; }
+
+private:
+
+	FJSONLiveLinkStatusCounters Previous;
+	double LastUpdateTime = 0;
+	FText Status;
+};
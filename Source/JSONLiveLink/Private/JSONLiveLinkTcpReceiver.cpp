@@ -0,0 +1,441 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#include "JSONLiveLinkTcpReceiver.h"
+#include "JSONLiveLink.h"
+#include "JSONLiveLinkBinaryReader.h"
+#include "JSONLiveLinkBinaryWriter.h"
+#include "JSONLiveLinkProtocol.h"
+#include "Misc/ScopeLock.h"
+
+#if PLATFORM_LINUX
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#else
+#include "Common/TcpSocketBuilder.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+// Longest FSocket::Wait blocks before checking for a wake or a new connection
+#define MAX_STREAM_WAIT_MILLISECONDS 100
+#endif
+
+// Smallest the read buffer is, it only grows beyond this for packets that don't fit
+#define MIN_READ_BUFFER_SIZE 64 * 1024
+
+// Most senders waiting to replace the current connection
+#define LISTEN_BACKLOG 4
+
+void FJSONLiveLinkTcpReceiver::ReadAvailable()
+{
+	// Whatever was handed out before this batch is done with
+	if (ReadStart > 0)
+	{
+		FMemory::Memmove(ReadBuffer.GetData(), ReadBuffer.GetData() + ReadStart, ReadEnd - ReadStart);
+		ReadEnd -= ReadStart;
+		ReadStart = 0;
+	}
+
+	// Always room for the whole of the next packet, so it's read contiguously and handed out in place
+	int32 Needed = MIN_READ_BUFFER_SIZE;
+	FJSONLiveLinkBinaryReader Reader(ReadBuffer.GetData(), ReadEnd);
+	uint32 PacketSize;
+	if (Reader.Read(PacketSize) && PacketSize <= (uint32)JSONLiveLinkProtocol::MaxStreamPacketSize)
+	{
+		Needed = FMath::Max(Needed, JSONLiveLinkProtocol::StreamHeaderSize + (int32)PacketSize);
+	}
+	if (ReadBuffer.Num() < Needed)
+	{
+		ReadBuffer.SetNumUninitialized(Needed, false);
+	}
+
+	// Only reading what fits leaves the rest in the socket, where it holds the sender back
+	int32 BytesRead = 0;
+	if (!Recv(ReadBuffer.GetData() + ReadEnd, ReadBuffer.Num() - ReadEnd, BytesRead))
+	{
+		UE_LOG(LogJSONLiveLink, Display, TEXT("%s disconnected"), *Peer.ToString());
+		CloseConnection();
+		return;
+	}
+	ReadEnd += BytesRead;
+	LastReadTime = FPlatformTime::Seconds();
+}
+
+int32 FJSONLiveLinkTcpReceiver::SplitPackets(int32 MaxDatagrams)
+{
+	MaxDatagrams = FMath::Clamp(MaxDatagrams, 1, Datagrams.Num());
+	int32 NumReceived = 0;
+	while (NumReceived < MaxDatagrams)
+	{
+		FJSONLiveLinkBinaryReader Reader(ReadBuffer.GetData() + ReadStart, ReadEnd - ReadStart);
+		uint32 Size;
+		if (!Reader.Read(Size))
+		{
+			break;
+		}
+		if (Size > (uint32)JSONLiveLinkProtocol::MaxStreamPacketSize)
+		{
+			// Not a length, the stream can't be resynchronized
+			UE_LOG(LogJSONLiveLink, Warning, TEXT("Closing connection from %s, it sent a %u byte packet"), *Peer.ToString(), Size);
+			CloseConnection();
+			break;
+		}
+		if (Reader.ReadBytes(Size) == nullptr)
+		{
+			// Still arriving
+			break;
+		}
+
+		uint8* Data = ReadBuffer.GetData() + ReadStart + JSONLiveLinkProtocol::StreamHeaderSize;
+		ReadStart += JSONLiveLinkProtocol::StreamHeaderSize + Size;
+		if (Size == 0)
+		{
+			continue;
+		}
+
+		FJSONLiveLinkDatagram& Datagram = Datagrams[NumReceived++];
+		if (bOwnSlots)
+		{
+			Datagram.Data = Data;
+			Datagram.Size = Size;
+		}
+		else if ((int32)Size <= MaxDatagramSize)
+		{
+			FMemory::Memcpy(Datagram.Data, Data, Size);
+			Datagram.Size = Size;
+		}
+		else
+		{
+			Datagram.Size = 0;
+			NumTruncated.IncrementExchange();
+		}
+		Datagram.Sender = Peer;
+		Datagram.ArrivalTime = LastReadTime;
+	}
+	return NumReceived;
+}
+
+int32 FJSONLiveLinkTcpReceiver::ReceiveBatch(const FTimespan& WaitTime, int32 MaxDatagrams)
+{
+	// A single read often completes several packets, those left over from the last batch don't need a wait
+	const int32 NumBuffered = SplitPackets(MaxDatagrams);
+	if (NumBuffered > 0 || !Wait(WaitTime))
+	{
+		return NumBuffered;
+	}
+
+	ReadAvailable();
+	return SplitPackets(MaxDatagrams);
+}
+
+#if PLATFORM_LINUX
+
+static sockaddr_in ToSockAddr(const FIPv4Address& Address, uint16 Port)
+{
+	sockaddr_in SockAddr;
+	FMemory::Memzero(SockAddr);
+	SockAddr.sin_family = AF_INET;
+	SockAddr.sin_addr.s_addr = htonl(Address.Value);
+	SockAddr.sin_port = htons(Port);
+	return SockAddr;
+}
+
+FJSONLiveLinkTcpReceiver::FJSONLiveLinkTcpReceiver(const FIPv4Endpoint& Endpoint, int32 ReceiveBufferSize, int32 BatchSize, int32 InMaxDatagramSize, bool bInOwnSlots)
+: FJSONLiveLinkReceiver(BatchSize, InMaxDatagramSize, false)
+, bOwnSlots(bInOwnSlots)
+, ReadStart(0)
+, ReadEnd(0)
+, LastReadTime(0)
+, ListenSocket(-1)
+, ConnectionSocket(-1)
+, WakeFd(-1)
+{
+	// Lent slots can hold more than a datagram, packets are only limited by the stream framing
+	MaxDatagramSize = FMath::Clamp(InMaxDatagramSize, 1, JSONLiveLinkProtocol::MaxStreamPacketSize);
+
+	ListenSocket = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+	if (ListenSocket < 0)
+	{
+		UE_LOG(LogJSONLiveLink, Error, TEXT("Failed to create socket: %s"), UTF8_TO_TCHAR(strerror(errno)));
+		return;
+	}
+
+	// Set before listening so accepted connections inherit it and negotiate a matching window
+	const int Enable = 1;
+	setsockopt(ListenSocket, SOL_SOCKET, SO_REUSEADDR, &Enable, sizeof(Enable));
+	setsockopt(ListenSocket, SOL_SOCKET, SO_RCVBUF, &ReceiveBufferSize, sizeof(ReceiveBufferSize));
+
+	const sockaddr_in BindAddr = ToSockAddr(Endpoint.Address, Endpoint.Port);
+	if (bind(ListenSocket, (const sockaddr*)&BindAddr, sizeof(BindAddr)) != 0 || listen(ListenSocket, LISTEN_BACKLOG) != 0)
+	{
+		UE_LOG(LogJSONLiveLink, Error, TEXT("Failed to listen on %s: %s"), *Endpoint.ToString(), UTF8_TO_TCHAR(strerror(errno)));
+		close(ListenSocket);
+		ListenSocket = -1;
+		return;
+	}
+
+	WakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (WakeFd < 0)
+	{
+		UE_LOG(LogJSONLiveLink, Error, TEXT("Failed to create eventfd: %s"), UTF8_TO_TCHAR(strerror(errno)));
+		close(ListenSocket);
+		ListenSocket = -1;
+	}
+}
+
+FJSONLiveLinkTcpReceiver::~FJSONLiveLinkTcpReceiver()
+{
+	CloseConnection();
+	if (ListenSocket >= 0)
+	{
+		close(ListenSocket);
+	}
+	if (WakeFd >= 0)
+	{
+		close(WakeFd);
+	}
+}
+
+bool FJSONLiveLinkTcpReceiver::IsValid() const
+{
+	return ListenSocket >= 0;
+}
+
+bool FJSONLiveLinkTcpReceiver::Wait(const FTimespan& WaitTime)
+{
+	pollfd PollFds[3];
+	PollFds[0].fd = WakeFd;
+	PollFds[1].fd = ListenSocket;
+	PollFds[2].fd = ConnectionSocket;
+	for (pollfd& PollFd : PollFds)
+	{
+		PollFd.events = POLLIN;
+		PollFd.revents = 0;
+	}
+
+	const int Timeout = WaitTime == FTimespan::MaxValue() ? -1 : (int)WaitTime.GetTotalMilliseconds();
+	if (poll(PollFds, ConnectionSocket >= 0 ? 3 : 2, Timeout) <= 0)
+	{
+		return false;
+	}
+
+	if (PollFds[0].revents & POLLIN)
+	{
+		// Consume the wakeup so the next wait blocks again
+		uint64 Count;
+		ssize_t Result = read(WakeFd, &Count, sizeof(Count));
+		(void)Result;
+		return false;
+	}
+
+	if (PollFds[1].revents & POLLIN)
+	{
+		AcceptConnection();
+	}
+	return ConnectionSocket >= 0;
+}
+
+void FJSONLiveLinkTcpReceiver::AcceptConnection()
+{
+	sockaddr_in PeerAddr;
+	socklen_t PeerAddrLen = sizeof(PeerAddr);
+	const int Accepted = accept4(ListenSocket, (sockaddr*)&PeerAddr, &PeerAddrLen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if (Accepted < 0)
+	{
+		return;
+	}
+
+	// Keyframe requests are tiny and shouldn't wait to be coalesced
+	const int Enable = 1;
+	setsockopt(Accepted, IPPROTO_TCP, TCP_NODELAY, &Enable, sizeof(Enable));
+
+	CloseConnection();
+
+	FScopeLock Lock(&ConnectionCriticalSection);
+	ConnectionSocket = Accepted;
+	Peer = FIPv4Endpoint(FIPv4Address(ntohl(PeerAddr.sin_addr.s_addr)), ntohs(PeerAddr.sin_port));
+	UE_LOG(LogJSONLiveLink, Display, TEXT("Accepted connection from %s"), *Peer.ToString());
+}
+
+bool FJSONLiveLinkTcpReceiver::Recv(uint8* Data, int32 Size, int32& OutBytesRead)
+{
+	OutBytesRead = 0;
+	if (ConnectionSocket < 0)
+	{
+		return true;
+	}
+
+	const ssize_t Result = recv(ConnectionSocket, Data, Size, MSG_DONTWAIT);
+	if (Result > 0)
+	{
+		OutBytesRead = (int32)Result;
+		return true;
+	}
+	return Result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+}
+
+void FJSONLiveLinkTcpReceiver::CloseConnection()
+{
+	FScopeLock Lock(&ConnectionCriticalSection);
+	if (ConnectionSocket >= 0)
+	{
+		close(ConnectionSocket);
+		ConnectionSocket = -1;
+	}
+
+	// A partial packet from the old connection means nothing on the next one
+	ReadStart = 0;
+	ReadEnd = 0;
+}
+
+void FJSONLiveLinkTcpReceiver::Wake()
+{
+	if (WakeFd >= 0)
+	{
+		const uint64 Count = 1;
+		ssize_t Result = write(WakeFd, &Count, sizeof(Count));
+		(void)Result;
+	}
+}
+
+bool FJSONLiveLinkTcpReceiver::SendTo(const uint8* Data, int32 Size, const FIPv4Endpoint& Endpoint)
+{
+	TArray<uint8, TInlineAllocator<64>> Packet;
+	Packet.SetNumUninitialized(JSONLiveLinkProtocol::StreamHeaderSize + Size);
+	FJSONLiveLinkBinaryWriter Writer(Packet.GetData(), Packet.Num());
+	Writer.Write((uint32)Size);
+	Writer.WriteBytes(Data, Size);
+
+	FScopeLock Lock(&ConnectionCriticalSection);
+	return ConnectionSocket >= 0 && send(ConnectionSocket, Packet.GetData(), Packet.Num(), MSG_DONTWAIT | MSG_NOSIGNAL) == Packet.Num();
+}
+
+#else
+
+FJSONLiveLinkTcpReceiver::FJSONLiveLinkTcpReceiver(const FIPv4Endpoint& Endpoint, int32 ReceiveBufferSize, int32 BatchSize, int32 InMaxDatagramSize, bool bInOwnSlots)
+: FJSONLiveLinkReceiver(BatchSize, InMaxDatagramSize, false)
+, bOwnSlots(bInOwnSlots)
+, ReadStart(0)
+, ReadEnd(0)
+, LastReadTime(0)
+, bWakeRequested(false)
+, ListenSocket(nullptr)
+, ConnectionSocket(nullptr)
+{
+	// Lent slots can hold more than a datagram, packets are only limited by the stream framing
+	MaxDatagramSize = FMath::Clamp(InMaxDatagramSize, 1, JSONLiveLinkProtocol::MaxStreamPacketSize);
+
+	ListenSocket = FTcpSocketBuilder(TEXT("JSONTCPLISTENSOCKET"))
+		.AsNonBlocking()
+		.AsReusable()
+		.BoundToEndpoint(Endpoint)
+		.WithReceiveBufferSize(ReceiveBufferSize)
+		.Listening(LISTEN_BACKLOG);
+
+	if (ListenSocket == nullptr)
+	{
+		UE_LOG(LogJSONLiveLink, Error, TEXT("Failed to listen on %s"), *Endpoint.ToString());
+	}
+}
+
+FJSONLiveLinkTcpReceiver::~FJSONLiveLinkTcpReceiver()
+{
+	CloseConnection();
+	if (ListenSocket != nullptr)
+	{
+		ListenSocket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(ListenSocket);
+	}
+}
+
+bool FJSONLiveLinkTcpReceiver::IsValid() const
+{
+	return ListenSocket != nullptr;
+}
+
+bool FJSONLiveLinkTcpReceiver::Wait(const FTimespan& WaitTime)
+{
+	// A listening socket is readable when a connection is pending
+	FSocket* WaitSocket = ConnectionSocket != nullptr ? ConnectionSocket : ListenSocket;
+	const bool bReadable = WaitSocket->Wait(ESocketWaitConditions::WaitForRead, FMath::Min(WaitTime, FTimespan::FromMilliseconds(MAX_STREAM_WAIT_MILLISECONDS)));
+	if (bWakeRequested.Exchange(false))
+	{
+		return false;
+	}
+
+	bool bPendingConnection = false;
+	if (ListenSocket->HasPendingConnection(bPendingConnection) && bPendingConnection)
+	{
+		AcceptConnection();
+	}
+	return bReadable && ConnectionSocket != nullptr;
+}
+
+void FJSONLiveLinkTcpReceiver::AcceptConnection()
+{
+	TSharedRef<FInternetAddr> PeerAddr = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+	FSocket* Accepted = ListenSocket->Accept(*PeerAddr, TEXT("JSONTCPSOCKET"));
+	if (Accepted == nullptr)
+	{
+		return;
+	}
+
+	// Not every platform carries non-blocking over to accepted sockets. Keyframe requests shouldn't wait to be coalesced.
+	Accepted->SetNonBlocking(true);
+	Accepted->SetNoDelay(true);
+
+	CloseConnection();
+
+	FScopeLock Lock(&ConnectionCriticalSection);
+	ConnectionSocket = Accepted;
+	Peer = FIPv4Endpoint(PeerAddr);
+	UE_LOG(LogJSONLiveLink, Display, TEXT("Accepted connection from %s"), *Peer.ToString());
+}
+
+bool FJSONLiveLinkTcpReceiver::Recv(uint8* Data, int32 Size, int32& OutBytesRead)
+{
+	OutBytesRead = 0;
+
+	// Fails once the peer closes the connection, succeeds with nothing read when it would block
+	return ConnectionSocket == nullptr || ConnectionSocket->Recv(Data, Size, OutBytesRead);
+}
+
+void FJSONLiveLinkTcpReceiver::CloseConnection()
+{
+	FScopeLock Lock(&ConnectionCriticalSection);
+	if (ConnectionSocket != nullptr)
+	{
+		ConnectionSocket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(ConnectionSocket);
+		ConnectionSocket = nullptr;
+	}
+
+	// A partial packet from the old connection means nothing on the next one
+	ReadStart = 0;
+	ReadEnd = 0;
+}
+
+void FJSONLiveLinkTcpReceiver::Wake()
+{
+	bWakeRequested = true;
+}
+
+bool FJSONLiveLinkTcpReceiver::SendTo(const uint8* Data, int32 Size, const FIPv4Endpoint& Endpoint)
+{
+	TArray<uint8, TInlineAllocator<64>> Packet;
+	Packet.SetNumUninitialized(JSONLiveLinkProtocol::StreamHeaderSize + Size);
+	FJSONLiveLinkBinaryWriter Writer(Packet.GetData(), Packet.Num());
+	Writer.Write((uint32)Size);
+	Writer.WriteBytes(Data, Size);
+
+	FScopeLock Lock(&ConnectionCriticalSection);
+	int32 BytesSent = 0;
+	return ConnectionSocket != nullptr && ConnectionSocket->Send(Packet.GetData(), Packet.Num(), BytesSent) && BytesSent == Packet.Num();
+}
+
+#endif
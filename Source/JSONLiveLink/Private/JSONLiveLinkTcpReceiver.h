@@ -0,0 +1,86 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "JSONLiveLinkReceiver.h"
+
+class FSocket;
+
+/**
+ * Listens for a sender on a TCP port and splits its stream into packets, see JSONLiveLinkProtocol::MaxStreamPacketSize.
+ * Packets are never fragmented or truncated so their size isn't limited by a datagram, and a sender that outpaces the
+ * decoding is held back by TCP flow control instead of losing packets.
+ *
+ * One sender is connected at a time, a new connection replaces the current one so a restarted sender is picked up straight
+ * away. The stream is read into a buffer that grows to the largest packet seen and is then reused. With its own slots the
+ * packets handed out point straight into that buffer, otherwise they're copied into the lent slots and those larger than a
+ * slot are dropped.
+ */
+class FJSONLiveLinkTcpReceiver : public FJSONLiveLinkReceiver
+{
+public:
+
+	FJSONLiveLinkTcpReceiver(const FIPv4Endpoint& Endpoint, int32 ReceiveBufferSize, int32 BatchSize, int32 InMaxDatagramSize, bool bInOwnSlots);
+	virtual ~FJSONLiveLinkTcpReceiver();
+
+	// Begin FJSONLiveLinkReceiver Interface
+
+	virtual bool IsValid() const override;
+	virtual int32 ReceiveBatch(const FTimespan& WaitTime, int32 MaxDatagrams) override;
+	virtual void Wake() override;
+
+	// Sends a packet back to the connected sender, whatever Endpoint is
+	virtual bool SendTo(const uint8* Data, int32 Size, const FIPv4Endpoint& Endpoint) override;
+
+	// End FJSONLiveLinkReceiver Interface
+
+private:
+
+	// Waits for the listener or the connection to become readable, false if woken or timed out
+	bool Wait(const FTimespan& WaitTime);
+
+	// Accepts a pending connection, replacing the current one
+	void AcceptConnection();
+
+	// Reads what's available into ReadBuffer, closes the connection if the sender went away
+	void ReadAvailable();
+
+	// Reads what the socket has without blocking, false once the connection is closed
+	bool Recv(uint8* Data, int32 Size, int32& OutBytesRead);
+
+	// Hands out the complete packets at the start of ReadBuffer
+	int32 SplitPackets(int32 MaxDatagrams);
+
+	void CloseConnection();
+
+	bool bOwnSlots;
+
+	// Unconsumed stream bytes are ReadBuffer[ReadStart, ReadEnd), packets handed out are only discarded on the next batch
+	TArray<uint8> ReadBuffer;
+	int32 ReadStart;
+	int32 ReadEnd;
+
+	// FPlatformTime::Seconds() of the last read, the arrival time of the packets it completed
+	double LastReadTime;
+
+	FIPv4Endpoint Peer;
+
+	// Guards the connection against SendTo from the GameThread while the receiver thread replaces it
+	FCriticalSection ConnectionCriticalSection;
+
+#if PLATFORM_LINUX
+	int ListenSocket;
+	int ConnectionSocket;
+
+	// eventfd polled along with the sockets, written to by Wake
+	int WakeFd;
+#else
+	// Wake can't end an FSocket wait, so waits are capped and this is checked after each one
+	TAtomic<bool> bWakeRequested;
+
+	FSocket* ListenSocket;
+	FSocket* ConnectionSocket;
+#endif
+};
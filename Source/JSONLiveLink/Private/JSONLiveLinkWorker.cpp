@@ -0,0 +1,618 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#include "JSONLiveLinkWorker.h"
+#include "JSONLiveLinkCapture.h"
+#include "JSONLiveLinkDecoder.h"
+#include "JSONLiveLinkDecompressor.h"
+#include "JSONLiveLinkDemultiplexer.h"
+#include "JSONLiveLinkJsonReader.h"
+#include "JSONLiveLinkPacketRing.h"
+#include "JSONLiveLinkProtocol.h"
+#include "JSONLiveLinkReceiver.h"
+#include "JSONLiveLinkTcpReceiver.h"
+
+#include "LiveLinkTypes.h"
+#include "Roles/LiveLinkAnimationTypes.h"
+
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/MemStack.h"
+#include "Misc/Paths.h"
+#include "Misc/QualifiedFrameTime.h"
+#include "Misc/ScopeLock.h"
+
+// Most decoders a packet's subjects are spread across
+#define MAX_DECODE_LANES 8
+
+// Most frames kept for reuse, about what a dropped packet of a crowded sender holds
+#define MAX_POOLED_FRAMES 32
+
+DECLARE_CYCLE_STAT(TEXT("Receive Batch"), STAT_JSONLiveLink_ReceiveBatch, STATGROUP_JSONLiveLink);
+DECLARE_CYCLE_STAT(TEXT("Decode Packet"), STAT_JSONLiveLink_DecodePacket, STATGROUP_JSONLiveLink);
+DECLARE_CYCLE_STAT(TEXT("Queue Packet"), STAT_JSONLiveLink_QueuePacket, STATGROUP_JSONLiveLink);
+DECLARE_CYCLE_STAT(TEXT("Decode Subject Spans"), STAT_JSONLiveLink_DecodeSubjectSpans, STATGROUP_JSONLiveLink);
+DECLARE_CYCLE_STAT(TEXT("Push Subject"), STAT_JSONLiveLink_PushSubject, STATGROUP_JSONLiveLink);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Packets Received"), STAT_JSONLiveLink_PacketsReceived, STATGROUP_JSONLiveLink);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Bytes Received"), STAT_JSONLiveLink_BytesReceived, STATGROUP_JSONLiveLink);
+
+// Packets backpressure never sheds, compressed ones can't be told apart without inflating them
+static bool IsDependedOn(const uint8* Data, int32 Size)
+{
+	return FJSONLiveLinkDecompressor::IsCompressedPacket(Data, Size) || FJSONLiveLinkDecoder::IsDependedOnPacket(Data, Size);
+}
+
+FJSONLiveLinkWorker::FJSONLiveLinkWorker(FJSONLiveLinkDemultiplexer& InDemultiplexer, const FIPv4Endpoint& InEndpoint, bool bReusePort, const FJSONLiveLinkSourceSettings& InSettings)
+: Demultiplexer(InDemultiplexer)
+, Endpoint(InEndpoint)
+, Settings(InSettings)
+, Decoder(MakeUnique<FJSONLiveLinkDecoder>())
+, SubjectFilterVersion(InDemultiplexer.GetSubjectFilterVersion())
+, FramePool(MAX_POOLED_FRAMES)
+, Decompressor(MakeUnique<FJSONLiveLinkDecompressor>())
+, Stopping(false)
+, Thread(nullptr)
+, WaitTime(FTimespan::MaxValue())
+, bDrainAllowed(MakeShared<FThreadSafeBool, ESPMode::ThreadSafe>(true))
+, Backpressure(InSettings)
+, DecodeStartTime(0)
+{
+	if (Settings.ParallelDecodeThreshold > 0)
+	{
+		// As many lanes as there are threads to run them, counting this one
+		const int32 NumLanes = FMath::Clamp(FTaskGraphInterface::Get().GetNumWorkerThreads() + 1, 1, MAX_DECODE_LANES);
+		for (int32 Lane = 0; Lane < NumLanes; ++Lane)
+		{
+			LaneDecoders.Add(MakeUnique<FJSONLiveLinkDecoder>());
+		}
+	}
+
+	Decoder->SetFilter(Settings.AllowedSubjects, Settings.AllowedBones, Settings.AllowedParameters);
+	for (TUniquePtr<FJSONLiveLinkDecoder>& LaneDecoder : LaneDecoders)
+	{
+		LaneDecoder->SetFilter(Settings.AllowedSubjects, Settings.AllowedBones, Settings.AllowedParameters);
+	}
+
+	if (!Settings.CompressionDictionaryFilename.IsEmpty())
+	{
+		Decompressor->LoadDictionary(Settings.CompressionDictionaryFilename);
+	}
+
+	// Queued datagrams are received straight into the ring's slots, so the receiver only needs slots of its own without one
+	const bool bOwnSlots = Settings.bDecodeOnReceiverThread;
+	if (!Settings.ReplayFilename.IsEmpty())
+	{
+		Receiver = MakeUnique<FJSONLiveLinkReplayReceiver>(Settings.ReplayFilename, Settings.ReceiveBatchSize, Settings.MaxDatagramSize, bOwnSlots, Settings.bReplayAsFastAsPossible);
+	}
+	else if (Settings.Transport == EJSONLiveLinkTransport::Tcp)
+	{
+		Receiver = MakeUnique<FJSONLiveLinkTcpReceiver>(Endpoint, Settings.SocketReceiveBufferSize, Settings.ReceiveBatchSize, Settings.MaxDatagramSize, bOwnSlots);
+	}
+	else
+	{
+		Receiver = MakeUnique<FJSONLiveLinkUdpReceiver>(Endpoint, Settings.SocketReceiveBufferSize, Settings.ReceiveBatchSize, Settings.MaxDatagramSize, bOwnSlots, bReusePort);
+	}
+
+	if (!Settings.bDecodeOnReceiverThread)
+	{
+		PacketRing = MakeUnique<FJSONLiveLinkPacketRing>(Settings.PacketRingCapacity, Receiver->GetSlotSize());
+		RingSlots.SetNumZeroed(Receiver->GetBatchSize());
+		OverrunSlot.SetNumUninitialized(Receiver->GetSlotSize());
+	}
+}
+
+FJSONLiveLinkWorker::~FJSONLiveLinkWorker()
+{
+	Join();
+}
+
+void FJSONLiveLinkWorker::Join()
+{
+	Stop();
+	if (Thread != nullptr)
+	{
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+	*bDrainAllowed = false;
+
+	// Closes the socket now rather than with the worker, a successor may be about to bind the same port
+	Receiver.Reset();
+}
+
+void FJSONLiveLinkWorker::TakeCaches(FJSONLiveLinkWorker& Predecessor)
+{
+	check(Thread == nullptr && Predecessor.Thread == nullptr);
+
+	// Swapped rather than moved so the predecessor is never left without a decoder
+	Swap(Decoder, Predecessor.Decoder);
+	for (int32 Lane = 0; Lane < FMath::Min(LaneDecoders.Num(), Predecessor.LaneDecoders.Num()); ++Lane)
+	{
+		Swap(LaneDecoders[Lane], Predecessor.LaneDecoders[Lane]);
+	}
+	ClockSyncs = MoveTemp(Predecessor.ClockSyncs);
+
+	// The filter may have changed with the settings
+	UpdateSubjectFilter();
+}
+
+bool FJSONLiveLinkWorker::IsValid() const
+{
+	return !Stopping && Thread != nullptr && Receiver.IsValid() && Receiver->IsValid();
+}
+
+void FJSONLiveLinkWorker::Start(int32 WorkerIndex)
+{
+	if (!Receiver->IsValid())
+	{
+		return;
+	}
+
+	if (!Settings.ReplayFilename.IsEmpty())
+	{
+		ThreadName = FString::Printf(TEXT("JSON Replay %d (%s)"), WorkerIndex, *FPaths::GetCleanFilename(Settings.ReplayFilename));
+	}
+	else
+	{
+		const TCHAR* TransportName = Settings.Transport == EJSONLiveLinkTransport::Tcp ? TEXT("TCP") : TEXT("UDP");
+		ThreadName = FString::Printf(TEXT("JSON %s Receiver %d (%s)"), TransportName, WorkerIndex, *Endpoint.ToString());
+	}
+
+	const uint64 AffinityMask = Settings.ThreadAffinityMask != 0 ? Settings.ThreadAffinityMask : FPlatformAffinity::GetPoolThreadMask();
+	Thread = FRunnableThread::Create(this, *ThreadName, Settings.ThreadStackSize, Settings.ThreadPriority, AffinityMask);
+}
+
+void FJSONLiveLinkWorker::Stop()
+{
+	Stopping = true;
+
+	// Don't wait for the next datagram to notice
+	if (Receiver.IsValid())
+	{
+		Receiver->Wake();
+	}
+}
+
+uint32 FJSONLiveLinkWorker::Run()
+{
+	FJSONLiveLinkCaptureWriter* CaptureWriter = Demultiplexer.GetCaptureWriter();
+
+	while (!Stopping)
+	{
+		const int32 NumSlots = PacketRing.IsValid() ? AcquireRingSlots() : Receiver->GetBatchSize();
+		const bool bOverrun = NumSlots == 0;
+
+		const int32 NumReceived = Receiver->ReceiveBatch(WaitTime, FMath::Max(NumSlots, 1));
+
+		SCOPE_CYCLE_COUNTER(STAT_JSONLiveLink_ReceiveBatch);
+		JSONLIVELINK_TRACE_SCOPE(JSONLiveLink_ReceiveBatch);
+		BatchCoalesceKeys.Reset();
+		for (int32 DatagramIdx = 0; DatagramIdx < NumReceived; ++DatagramIdx)
+		{
+			const FJSONLiveLinkDatagram& Datagram = Receiver->GetDatagram(DatagramIdx);
+			if (PacketRing.IsValid())
+			{
+				// Received into the overrun slot while the ring was full, room is only made now that it's in hand. Without any
+				// it's dropped, still counted and captured below as it was received.
+				uint8* Slot = bOverrun ? PacketRing->AcquireOverrunSlot() : nullptr;
+				if (Slot != nullptr)
+				{
+					FMemory::Memcpy(Slot, Datagram.Data, Datagram.Size);
+				}
+
+				// Committed even when dropped for being too large, the next datagram was received into the next slot
+				if (!bOverrun || Slot != nullptr)
+				{
+					QueuePacket(Datagram);
+				}
+			}
+			if (Datagram.Size == 0)
+			{
+				continue;
+			}
+
+			Stats.AddPacket(Datagram.Size);
+			INC_DWORD_STAT(STAT_JSONLiveLink_PacketsReceived);
+			INC_DWORD_STAT_BY(STAT_JSONLiveLink_BytesReceived, Datagram.Size);
+
+			if (CaptureWriter != nullptr)
+			{
+				CaptureWriter->Append(Datagram);
+			}
+
+			if (Settings.bDecodeOnReceiverThread && !ShedBatchDatagram(DatagramIdx, NumReceived))
+			{
+				// Pushing to LiveLink is thread safe, decode straight out of the receive slot
+				HandleReceivedData(Datagram.Data, Datagram.Size, &Datagram.Sender, Datagram.ArrivalTime);
+			}
+		}
+	}
+	return 0;
+}
+
+bool FJSONLiveLinkWorker::ShedBatchDatagram(int32 DatagramIdx, int32 NumReceived)
+{
+	// The rest of the batch is what's waiting, a full batch usually means more is left in the socket buffer
+	const int32 QueueDepth = NumReceived - DatagramIdx - 1;
+	Backpressure.Update(FPlatformTime::Seconds(), QueueDepth);
+	if (!Backpressure.IsDegraded())
+	{
+		return false;
+	}
+
+	uint32 CoalesceKey = 0;
+	if (Backpressure.NeedsCoalesceKeys())
+	{
+		if (BatchCoalesceKeys.Num() == 0)
+		{
+			for (int32 Idx = 0; Idx < NumReceived; ++Idx)
+			{
+				const FJSONLiveLinkDatagram& Datagram = Receiver->GetDatagram(Idx);
+				BatchCoalesceKeys.Add(Datagram.Size > 0 ? FJSONLiveLinkDecoder::GetCoalesceKey(Datagram.Data, Datagram.Size, Datagram.Sender) : 0);
+			}
+		}
+		CoalesceKey = BatchCoalesceKeys[DatagramIdx];
+	}
+
+	if (Backpressure.IsCoalescing() && CoalesceKey != 0)
+	{
+		for (int32 Idx = DatagramIdx + 1; Idx < NumReceived; ++Idx)
+		{
+			if (BatchCoalesceKeys[Idx] == CoalesceKey)
+			{
+				NumCoalescedFrames.Increment();
+				return true;
+			}
+		}
+	}
+
+	const FJSONLiveLinkDatagram& Datagram = Receiver->GetDatagram(DatagramIdx);
+	return Backpressure.ShouldShed(QueueDepth, CoalesceKey, Datagram.ArrivalTime, IsDependedOn(Datagram.Data, Datagram.Size));
+}
+
+int32 FJSONLiveLinkWorker::AcquireRingSlots()
+{
+	const int32 NumSlots = PacketRing->AcquireSlots(RingSlots.GetData(), RingSlots.Num());
+	for (int32 SlotIdx = 0; SlotIdx < NumSlots; ++SlotIdx)
+	{
+		Receiver->SetSlot(SlotIdx, RingSlots[SlotIdx]);
+	}
+	if (NumSlots == 0)
+	{
+		Receiver->SetSlot(0, OverrunSlot.GetData());
+	}
+	return NumSlots;
+}
+
+uint32 FJSONLiveLinkWorker::GetNumOverruns() const
+{
+	return (PacketRing.IsValid() ? PacketRing->GetNumOverruns() : 0) + (Receiver.IsValid() ? Receiver->GetNumTruncated() : 0);
+}
+
+int32 FJSONLiveLinkWorker::GetNumDecompressFailures() const
+{
+	return Decompressor->GetNumFailed();
+}
+
+int32 FJSONLiveLinkWorker::GetQueueDepth() const
+{
+	return PacketRing.IsValid() ? FMath::Max(PacketRing->GetNum(), 0) : 0;
+}
+
+void FJSONLiveLinkWorker::QueuePacket(const FJSONLiveLinkDatagram& Datagram)
+{
+	SCOPE_CYCLE_COUNTER(STAT_JSONLiveLink_QueuePacket);
+
+	// Only looked for while the policy needs them, every packet would pay for the scan and the lock otherwise. Packets queued
+	// just before degrading go without and are decoded.
+	uint32 CoalesceKey = 0;
+	if ((Settings.bCoalesceFrames || (Backpressure.NeedsCoalesceKeys() && Backpressure.IsDegraded())) && Datagram.Size > 0)
+	{
+		CoalesceKey = FJSONLiveLinkDecoder::GetCoalesceKey(Datagram.Data, Datagram.Size, Datagram.Sender);
+		if (CoalesceKey != 0)
+		{
+			// Recorded before the packet becomes visible to the GameThread
+			FScopeLock Lock(&CoalesceCriticalSection);
+			NewestPackets.Add(CoalesceKey, PacketRing->GetNextPosition());
+		}
+	}
+
+	PacketRing->Commit(Datagram.Size, Datagram.Sender, Datagram.ArrivalTime, CoalesceKey);
+	if (!bDrainScheduled.AtomicSet(true))
+	{
+		// One task drains everything queued by the time it runs
+		AsyncTask(ENamedThreads::GameThread, [this, bAllowed = bDrainAllowed]()
+		{
+			if (*bAllowed)
+			{
+				DrainPacketRing();
+			}
+		});
+	}
+}
+
+bool FJSONLiveLinkWorker::IsSuperseded(const FJSONLiveLinkPacket& Packet)
+{
+	if (Packet.CoalesceKey == 0)
+	{
+		return false;
+	}
+	FScopeLock Lock(&CoalesceCriticalSection);
+	const uint32* NewestPosition = NewestPackets.Find(Packet.CoalesceKey);
+	return NewestPosition != nullptr && *NewestPosition != Packet.Position;
+}
+
+void FJSONLiveLinkWorker::DrainPacketRing()
+{
+	// Cleared first so packets enqueued while draining schedule another task
+	bDrainScheduled = false;
+
+	while (const FJSONLiveLinkPacket* Packet = PacketRing->Peek())
+	{
+		const int32 QueueDepth = FMath::Max(PacketRing->GetNum() - 1, 0);
+		Backpressure.Update(FPlatformTime::Seconds(), QueueDepth);
+
+		// Only the newest queued frame of each subject matters, older ones are discarded before parsing
+		if (Packet->Size == 0)
+		{
+			// Dropped for being too large, already counted by the receiver
+		}
+		else if ((Settings.bCoalesceFrames || Backpressure.IsCoalescing()) && IsSuperseded(*Packet))
+		{
+			NumCoalescedFrames.Increment();
+		}
+		else if (Backpressure.ShouldShed(QueueDepth, Packet->CoalesceKey, Packet->ArrivalTime, IsDependedOn(Packet->Data, Packet->Size)))
+		{
+			// Counted by the backpressure
+		}
+		else
+		{
+			HandleReceivedData(Packet->Data, Packet->Size, &Packet->Sender, Packet->ArrivalTime);
+		}
+		PacketRing->Release();
+	}
+}
+
+void FJSONLiveLinkWorker::UpdateSubjectFilter()
+{
+	// Read before the filter so a change racing with this one is picked up by the next datagram
+	SubjectFilterVersion = Demultiplexer.GetSubjectFilterVersion();
+
+	TArray<FName> AllowedSubjects;
+	Demultiplexer.GetSubjectFilter(AllowedSubjects);
+	Decoder->SetFilter(AllowedSubjects, Settings.AllowedBones, Settings.AllowedParameters);
+	for (TUniquePtr<FJSONLiveLinkDecoder>& LaneDecoder : LaneDecoders)
+	{
+		LaneDecoder->SetFilter(AllowedSubjects, Settings.AllowedBones, Settings.AllowedParameters);
+	}
+}
+
+void FJSONLiveLinkWorker::ApplyTiming(FLiveLinkAnimationFrameData& FrameData, const FJSONLiveLinkFrameTiming& Timing, const FIPv4Endpoint* Sender, double ArrivalTime, FJSONLiveLinkFrameLatency& OutLatency)
+{
+	if (Timing.bHasTimestamp)
+	{
+		FJSONLiveLinkClockSync& ClockSync = ClockSyncs.FindOrAdd(Sender != nullptr ? Sender->Address.Value : 0);
+		ClockSync.AddSample(Timing.Timestamp, ArrivalTime);
+		OutLatency.SenderTime = Timing.Timestamp + ClockSync.GetOffset();
+		OutLatency.bHasSenderTime = true;
+
+		// Delaying every frame by the same amount leaves LiveLink a buffered frame on either side to interpolate between
+		FrameData.WorldTime = FLiveLinkWorldTime(Timing.Timestamp, ClockSync.GetOffset() + Settings.InterpolationDelay);
+		FrameData.MetaData.SceneTime = FQualifiedFrameTime(Settings.FrameRate.AsFrameTime(Timing.Timestamp), Settings.FrameRate);
+	}
+	if (Timing.bHasFrame)
+	{
+		// Clamped to what a frame number holds rather than wrapped
+		const FFrameNumber FrameNumber((int32)FMath::Clamp<int64>(Timing.Frame, 0, MAX_int32));
+		FrameData.MetaData.SceneTime = FQualifiedFrameTime(FFrameTime(FrameNumber), Settings.FrameRate);
+	}
+}
+
+void FJSONLiveLinkWorker::PushFrame(FName SubjectName, uint32 SchemaHash, const FLiveLinkSkeletonStaticData& StaticData, FLiveLinkFrameDataStruct&& FrameDataStruct, const FJSONLiveLinkFrameTiming& Timing, const FIPv4Endpoint* Sender, double ArrivalTime)
+{
+	FJSONLiveLinkFrameLatency Latency;
+	Latency.ArrivalTime = ArrivalTime;
+	Latency.DecodeStartTime = DecodeStartTime;
+	ApplyTiming(*FrameDataStruct.Cast<FLiveLinkAnimationFrameData>(), Timing, Sender, ArrivalTime, Latency);
+	Latency.DecodeEndTime = FPlatformTime::Seconds();
+	{
+		SCOPE_CYCLE_COUNTER(STAT_JSONLiveLink_PushSubject);
+		JSONLIVELINK_TRACE_SCOPE(JSONLiveLink_PushSubject);
+		Demultiplexer.PushSubject(SubjectName, SchemaHash, StaticData, MoveTemp(FrameDataStruct));
+	}
+	Latency.PushEndTime = FPlatformTime::Seconds();
+	LatencyStats.AddFrame(SubjectName, Latency);
+}
+
+void FJSONLiveLinkWorker::HandleReceivedData(const uint8* Data, int32 Size, const FIPv4Endpoint* Sender, double ArrivalTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_JSONLiveLink_DecodePacket);
+	JSONLIVELINK_TRACE_SCOPE(JSONLiveLink_DecodePacket);
+
+	DecodeStartTime = FPlatformTime::Seconds();
+	const uint32 StartCycles = FPlatformTime::Cycles();
+	if (FJSONLiveLinkDecompressor::IsCompressedPacket(Data, Size) && !Decompressor->Decompress(Data, Size, Data, Size))
+	{
+		return;
+	}
+	DecodeDatagram(Data, Size, Sender, ArrivalTime);
+	const uint32 DecodeCycles = FPlatformTime::Cycles() - StartCycles;
+	Stats.AddDecode(DecodeCycles);
+	Backpressure.AddDecodeTime(FPlatformTime::ToSeconds(DecodeCycles));
+}
+
+void FJSONLiveLinkWorker::DecodeDatagram(const uint8* Data, int32 Size, const FIPv4Endpoint* Sender, double ArrivalTime)
+{
+	// The receiver thread may start before LiveLink hands the sources a client
+	if (!Demultiplexer.HasClient())
+	{
+		return;
+	}
+
+	if (Demultiplexer.GetSubjectFilterVersion() != SubjectFilterVersion)
+	{
+		UpdateSubjectFilter();
+	}
+
+	if (FJSONLiveLinkDecoder::IsBinaryPacket(Data, Size))
+	{
+		FName SubjectName;
+		uint32 SchemaHash;
+		FLiveLinkFrameDataStruct FrameDataStruct = FramePool.Acquire();
+		FLiveLinkAnimationFrameData& FrameData = *FrameDataStruct.Cast<FLiveLinkAnimationFrameData>();
+		const EJSONLiveLinkBinaryResult Result = Decoder->DecodeBinary(Data, Size, Sender != nullptr ? *Sender : FIPv4Endpoint::Any, SubjectName, FrameData, SchemaHash);
+		const FJSONLiveLinkFrameTiming& Timing = Decoder->GetTiming();
+		if (Result == EJSONLiveLinkBinaryResult::Frame && (!Timing.bHasSequence || SequenceTracker.Accept(SubjectName, Timing.Sequence)))
+		{
+			PushFrame(SubjectName, SchemaHash, Decoder->GetStaticData(), MoveTemp(FrameDataStruct), Timing, Sender, ArrivalTime);
+			return;
+		}
+
+		if (Result == EJSONLiveLinkBinaryResult::RequestKeyframe && Sender != nullptr)
+		{
+			Receiver->SendTo(Decoder->GetKeyframeRequest(), JSONLiveLinkProtocol::KeyframeRequestSize, *Sender);
+		}
+		else if (Result == EJSONLiveLinkBinaryResult::OutOfOrder)
+		{
+			// Only counted, the decoder already dropped it
+			SequenceTracker.Accept(SubjectName, Timing.Sequence);
+		}
+		FramePool.Release(MoveTemp(FrameDataStruct));
+		return;
+	}
+
+	FJSONLiveLinkJsonReader Reader(Data, Size);
+	if (!Reader.ReadObjectStart())
+	{
+		return;
+	}
+
+	if (LaneDecoders.Num() > 0)
+	{
+		DecodeSubjectSpans(Reader, Sender, ArrivalTime);
+		return;
+	}
+
+	FJSONLiveLinkStringView SubjectKey;
+	while (Reader.NextMember(SubjectKey))
+	{
+		FName SubjectName = Decoder->FindSubjectName(SubjectKey);
+		if (!Decoder->IsSubjectAllowed(SubjectName))
+		{
+			// Skipped without tokenizing its numbers
+			if (!Reader.SkipValue())
+			{
+				return;
+			}
+			continue;
+		}
+
+		FLiveLinkFrameDataStruct FrameDataStruct = FramePool.Acquire();
+		FLiveLinkAnimationFrameData& FrameData = *FrameDataStruct.Cast<FLiveLinkAnimationFrameData>();
+
+		uint32 SchemaHash;
+		if (!Decoder->DecodeSubject(Reader, SubjectName, FrameData, SchemaHash))
+		{
+			// Invalid Json Format
+			FramePool.Release(MoveTemp(FrameDataStruct));
+			return;
+		}
+
+		const FJSONLiveLinkFrameTiming& Timing = Decoder->GetTiming();
+		if (Timing.bHasSequence && !SequenceTracker.Accept(SubjectName, Timing.Sequence))
+		{
+			FramePool.Release(MoveTemp(FrameDataStruct));
+			continue;
+		}
+
+		PushFrame(SubjectName, SchemaHash, Decoder->GetStaticData(), MoveTemp(FrameDataStruct), Timing, Sender, ArrivalTime);
+	}
+}
+
+/** One subject of a packet split up for parallel decoding, and what it decoded to */
+struct FJSONLiveLinkSubjectSpan
+{
+	FJSONLiveLinkSubjectSpan(const FJSONLiveLinkJsonReader& InReader, FName InSubjectName, int32 InLane, FLiveLinkFrameDataStruct&& InFrameDataStruct)
+	: Reader(InReader)
+	, SubjectName(InSubjectName)
+	, Lane(InLane)
+	, FrameDataStruct(MoveTemp(InFrameDataStruct))
+	{
+	}
+
+	// Positioned on the subject object
+	FJSONLiveLinkJsonReader Reader;
+	FName SubjectName;
+	int32 Lane;
+
+	FLiveLinkFrameDataStruct FrameDataStruct;
+	uint32 SchemaHash = 0;
+	FJSONLiveLinkFrameTiming Timing;
+	bool bDecoded = false;
+};
+
+void FJSONLiveLinkWorker::DecodeSubjectSpans(FJSONLiveLinkJsonReader& Reader, const FIPv4Endpoint* Sender, double ArrivalTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_JSONLiveLink_DecodeSubjectSpans);
+
+	// The spans come off this thread's stack, popped once the packet is decoded
+	FMemMark SpansMark(FMemStack::Get());
+
+	// A subject always goes to the same lane, so it keeps being decoded against the layout its lane already learned
+	TArray<FJSONLiveLinkSubjectSpan, TMemStackAllocator<>> Spans;
+	FJSONLiveLinkStringView SubjectKey;
+	while (Reader.NextMember(SubjectKey))
+	{
+		const FName SubjectName = Decoder->FindSubjectName(SubjectKey);
+		if (!Decoder->IsSubjectAllowed(SubjectName))
+		{
+			if (!Reader.SkipValue())
+			{
+				break;
+			}
+			continue;
+		}
+
+		Spans.Emplace(Reader, SubjectName, GetTypeHash(SubjectName) % LaneDecoders.Num(), FramePool.Acquire());
+		if (!Reader.SkipValue())
+		{
+			FramePool.Release(MoveTemp(Spans.Last().FrameDataStruct));
+			Spans.Pop(false);
+			break;
+		}
+	}
+
+	// Handing a few subjects to the task graph costs more than it saves
+	const bool bSingleThreaded = Spans.Num() < Settings.ParallelDecodeThreshold;
+	ParallelFor(LaneDecoders.Num(), [this, &Spans](int32 Lane)
+	{
+		JSONLIVELINK_TRACE_SCOPE(JSONLiveLink_DecodeLane);
+		FJSONLiveLinkDecoder& LaneDecoder = *LaneDecoders[Lane];
+		for (FJSONLiveLinkSubjectSpan& Span : Spans)
+		{
+			if (Span.Lane == Lane)
+			{
+				FLiveLinkAnimationFrameData& FrameData = *Span.FrameDataStruct.Cast<FLiveLinkAnimationFrameData>();
+				Span.bDecoded = LaneDecoder.DecodeSubject(Span.Reader, Span.SubjectName, FrameData, Span.SchemaHash);
+				Span.Timing = LaneDecoder.GetTiming();
+			}
+		}
+	}, bSingleThreaded);
+
+	// Pushed in packet order from this thread, as if decoded serially
+	bool bInvalid = false;
+	for (FJSONLiveLinkSubjectSpan& Span : Spans)
+	{
+		// Invalid Json Format, nothing after it is pushed
+		bInvalid |= !Span.bDecoded;
+
+		if (bInvalid || (Span.Timing.bHasSequence && !SequenceTracker.Accept(Span.SubjectName, Span.Timing.Sequence)))
+		{
+			FramePool.Release(MoveTemp(Span.FrameDataStruct));
+			continue;
+		}
+
+		PushFrame(Span.SubjectName, Span.SchemaHash, LaneDecoders[Span.Lane]->GetStaticData(Span.SubjectName), MoveTemp(Span.FrameDataStruct), Span.Timing, Sender, ArrivalTime);
+	}
+}
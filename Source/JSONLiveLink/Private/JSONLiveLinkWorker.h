@@ -0,0 +1,193 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "JSONLiveLinkBackpressure.h"
+#include "JSONLiveLinkClockSync.h"
+#include "JSONLiveLinkFramePool.h"
+#include "JSONLiveLinkSequenceTracker.h"
+#include "JSONLiveLinkStats.h"
+#include "JSONLiveLinkSourceSettings.h"
+
+class FJSONLiveLinkDecoder;
+class FJSONLiveLinkDemultiplexer;
+class FJSONLiveLinkDecompressor;
+class FJSONLiveLinkJsonReader;
+class FJSONLiveLinkPacketRing;
+class FJSONLiveLinkReceiver;
+class FRunnableThread;
+struct FJSONLiveLinkDatagram;
+struct FJSONLiveLinkFrameTiming;
+struct FJSONLiveLinkPacket;
+struct FLiveLinkAnimationFrameData;
+struct FLiveLinkFrameDataStruct;
+struct FLiveLinkSkeletonStaticData;
+
+/**
+ * Receives and decodes one socket's datagrams on its own thread, pushing the subjects through its FJSONLiveLinkDemultiplexer.
+ * Every worker has its own decoder so workers never contend while decoding. A subject's frames stay ordered as long as
+ * it is always sent from the same address, since each sender's datagrams all reach the same worker.
+ */
+class FJSONLiveLinkWorker : public FRunnable
+{
+public:
+
+	// With bReusePort several workers can bind the same endpoint and the kernel spreads senders across them.
+	// When Settings has a ReplayFilename the endpoint is ignored and the file is played back instead.
+	FJSONLiveLinkWorker(FJSONLiveLinkDemultiplexer& InDemultiplexer, const FIPv4Endpoint& InEndpoint, bool bReusePort, const FJSONLiveLinkSourceSettings& InSettings);
+
+	virtual ~FJSONLiveLinkWorker();
+
+	bool IsValid() const;
+
+	// Starts the thread, unless the socket couldn't be bound
+	void Start(int32 WorkerIndex);
+
+	// Stops the thread, waits for it to exit and closes the socket, nothing is received or decoded afterwards
+	void Join();
+
+	// Takes what a joined worker's decoders learned, and its senders' clock offsets, before this one is started. Subjects
+	// and schemas it knew keep decoding against their cached names and layouts without being learned again.
+	void TakeCaches(FJSONLiveLinkWorker& Predecessor);
+
+	// Begin FRunnable Interface
+
+	virtual bool Init() override { return true; }
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	virtual void Exit() override { }
+
+	// End FRunnable Interface
+
+	// Decodes one datagram, JSON, binary or compressed, and pushes its subjects to LiveLink. Only called from one thread at a time.
+	// Sender is where keyframe requests for binary delta streams are sent back to, and whose clock timestamps are synced to.
+	void HandleReceivedData(const uint8* Data, int32 Size, const FIPv4Endpoint* Sender, double ArrivalTime);
+
+	// Datagrams dropped because the queue overran or they didn't fit a slot
+	uint32 GetNumOverruns() const;
+	int32 GetQueueDepth() const;
+
+	// Compressed datagrams dropped because they couldn't be decompressed
+	int32 GetNumDecompressFailures() const;
+	const FJSONLiveLinkStats& GetStats() const { return Stats; }
+	const FJSONLiveLinkLatencyStats& GetLatencyStats() const { return LatencyStats; }
+	int32 GetNumCoalescedFrames() const { return NumCoalescedFrames.GetValue(); }
+	const FJSONLiveLinkBackpressure& GetBackpressure() const { return Backpressure; }
+	const FJSONLiveLinkSequenceTracker& GetSequenceTracker() const { return SequenceTracker; }
+
+private:
+
+	// Lends the receiver the free PacketRing slots for the next batch, or OverrunSlot when there's none. Returns how many.
+	int32 AcquireRingSlots();
+
+	// When decoding on the receiver thread, whether backpressure skips a datagram of the batch just received
+	bool ShedBatchDatagram(int32 DatagramIdx, int32 NumReceived);
+
+	// Publishes a datagram received into PacketRing and makes sure a GameThread task is scheduled to drain it
+	void QueuePacket(const FJSONLiveLinkDatagram& Datagram);
+
+	void DecodeDatagram(const uint8* Data, int32 Size, const FIPv4Endpoint* Sender, double ArrivalTime);
+
+	// Splits a JSON packet into its subjects and decodes them on LaneDecoders, in parallel once there are enough of them
+	void DecodeSubjectSpans(FJSONLiveLinkJsonReader& Reader, const FIPv4Endpoint* Sender, double ArrivalTime);
+
+	// Stamps the frame with the decoded sender timing, mapped to the local clock
+	void ApplyTiming(FLiveLinkAnimationFrameData& FrameData, const FJSONLiveLinkFrameTiming& Timing, const FIPv4Endpoint* Sender, double ArrivalTime, FJSONLiveLinkFrameLatency& OutLatency);
+
+	// Applies the timing to a decoded frame and pushes it through the demultiplexer, recording how long each step took
+	void PushFrame(FName SubjectName, uint32 SchemaHash, const FLiveLinkSkeletonStaticData& StaticData, FLiveLinkFrameDataStruct&& FrameDataStruct, const FJSONLiveLinkFrameTiming& Timing, const FIPv4Endpoint* Sender, double ArrivalTime);
+
+	// Whether a newer packet for the same subjects was queued after this one
+	bool IsSuperseded(const FJSONLiveLinkPacket& Packet);
+
+	// Decodes every packet queued in PacketRing, runs on the GameThread
+	void DrainPacketRing();
+
+	// Applies the demultiplexer's subject filter to the decoders once it changed
+	void UpdateSubjectFilter();
+
+	FJSONLiveLinkDemultiplexer& Demultiplexer;
+
+	FIPv4Endpoint Endpoint;
+
+	FJSONLiveLinkSourceSettings Settings;
+
+	// Socket to receive data on, or the capture file being replayed
+	TUniquePtr<FJSONLiveLinkReceiver> Receiver;
+
+	// Decodes packets in place, only one thread decodes at a time
+	TUniquePtr<FJSONLiveLinkDecoder> Decoder;
+
+	// Decode JSON subjects when splitting packets up is enabled, each subject is always decoded by the same one
+	TArray<TUniquePtr<FJSONLiveLinkDecoder>> LaneDecoders;
+
+	// Version of the demultiplexer's subject filter the decoders have
+	int32 SubjectFilterVersion;
+
+	// Frames decoded but not pushed come back here, used by whichever thread decodes
+	FJSONLiveLinkFramePool FramePool;
+
+	// Unwraps compressed packets before they're decoded, on the same thread as the decoder
+	TUniquePtr<FJSONLiveLinkDecompressor> Decompressor;
+
+	// Threadsafe Bool for terminating the main thread loop
+	FThreadSafeBool Stopping;
+
+	// Thread to run socket operations on
+	FRunnableThread* Thread;
+
+	// Name of the sockets thread
+	FString ThreadName;
+
+	// Longest a receive waits for data, Stop wakes it up early anyway
+	FTimespan WaitTime;
+
+	// Datagrams waiting for the GameThread when not decoding on the receiver thread
+	TUniquePtr<FJSONLiveLinkPacketRing> PacketRing;
+
+	// Slots acquired for the current batch
+	TArray<uint8*> RingSlots;
+
+	// Receives while the ring is full, copied into the ring once a slot is made for it
+	TArray<uint8> OverrunSlot;
+
+	// Set while a GameThread task to drain PacketRing is pending
+	FThreadSafeBool bDrainScheduled;
+
+	// Cleared once joined, a drain task still pending checks it on the GameThread before touching the worker
+	TSharedRef<FThreadSafeBool, ESPMode::ThreadSafe> bDrainAllowed;
+
+	// Ring position of the newest queued packet for each coalesce key
+	TMap<uint32, uint32> NewestPackets;
+
+	// Guards NewestPackets, written by the receiver thread and read by the GameThread
+	FCriticalSection CoalesceCriticalSection;
+
+	// Queued packets skipped because a newer one for the same subjects was behind them
+	FThreadSafeCounter NumCoalescedFrames;
+
+	// What's skipped while decoding falls behind, updated by whichever thread decodes
+	FJSONLiveLinkBackpressure Backpressure;
+
+	// Coalesce keys of the batch being decoded on the receiver thread, only worked out once degrading needs them
+	TArray<uint32> BatchCoalesceKeys;
+
+	FJSONLiveLinkStats Stats;
+
+	FJSONLiveLinkLatencyStats LatencyStats;
+
+	// When the packet being decoded started decoding
+	double DecodeStartTime;
+
+	// Drops out of order frames of sequenced subjects
+	FJSONLiveLinkSequenceTracker SequenceTracker;
+
+	// Clock offset of each sender address that timestamps its packets
+	TMap<uint32, FJSONLiveLinkClockSync> ClockSyncs;
+};
@@ -1,10 +1,16 @@
 // Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
 
 #include "SJSONLiveLinkSourceFactory.h"
+#include "JSONLiveLink.h"
+#include "JSONLiveLinkSource.h"
+#include "Framework/Application/SlateApplication.h"
 #include "Interfaces/IPv4/IPv4Endpoint.h"
 #include "Widgets/SBoxPanel.h"
 #include "Widgets/Input/SButton.h"
+#include "Widgets/Input/SCheckBox.h"
+#include "Widgets/Input/SComboBox.h"
 #include "Widgets/Input/SEditableTextBox.h"
+#include "Widgets/Input/SSpinBox.h"
 #include "Widgets/Layout/SBox.h"
 #include "Widgets/Text/STextBlock.h"
 
@@ -14,6 +20,21 @@ void SJSONLiveLinkSourceFactory::Construct(const FArguments& Args)
 {
 	OkClicked = Args._OnOkClicked;
 
+	for (EThreadPriority Priority : { TPri_Lowest, TPri_BelowNormal, TPri_Normal, TPri_AboveNormal, TPri_Highest, TPri_TimeCritical })
+	{
+		PriorityOptions.Add(MakeShared<FString>(FJSONLiveLinkSource::GetThreadPriorityName(Priority)));
+	}
+	LoadSettings(FJSONLiveLinkSourceSettings());
+
+	SourceOptions.Add(MakeShared<FString>(LOCTEXT("JSONNewSource", "New Source").ToString()));
+	SelectedSource = SourceOptions[0];
+	TArray<FJSONLiveLinkSource*> LiveSources;
+	FJSONLiveLinkSource::GetLiveSources(LiveSources);
+	for (FJSONLiveLinkSource* Source : LiveSources)
+	{
+		SourceOptions.Add(MakeShared<FString>(Source->GetConnectionString()));
+	}
+
 	FIPv4Endpoint Endpoint;
 	Endpoint.Address = FIPv4Address::Any;
 	Endpoint.Port = 54321;
@@ -26,6 +47,33 @@ void SJSONLiveLinkSourceFactory::Construct(const FArguments& Args)
 			SNew(SVerticalBox)
 			+ SVerticalBox::Slot()
 			.AutoHeight()
+			[
+				SNew(SHorizontalBox)
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Left)
+				.FillWidth(0.5f)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("JSONSource", "Source"))
+					.ToolTipText(LOCTEXT("JSONSourceTooltip", "Creates a source, or switches a running one to these settings without removing its subjects"))
+				]
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Fill)
+				.FillWidth(0.5f)
+				[
+					SNew(SComboBox<TSharedPtr<FString>>)
+					.OptionsSource(&SourceOptions)
+					.InitiallySelectedItem(SelectedSource)
+					.OnGenerateWidget(this, &SJSONLiveLinkSourceFactory::MakeSourceWidget)
+					.OnSelectionChanged(this, &SJSONLiveLinkSourceFactory::OnSourceChanged)
+					[
+						SNew(STextBlock)
+						.Text(this, &SJSONLiveLinkSourceFactory::GetSelectedSource)
+					]
+				]
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
 			[
 				SNew(SHorizontalBox)
 				+ SHorizontalBox::Slot()
@@ -34,6 +82,7 @@ void SJSONLiveLinkSourceFactory::Construct(const FArguments& Args)
 				[
 					SNew(STextBlock)
 					.Text(LOCTEXT("JSONPortNumber", "Port Number"))
+					.ToolTipText(LOCTEXT("JSONPortNumberTooltip", "Comma separated list of endpoints to receive on"))
 				]
 				+ SHorizontalBox::Slot()
 				.HAlign(HAlign_Fill)
@@ -45,6 +94,268 @@ void SJSONLiveLinkSourceFactory::Construct(const FArguments& Args)
 				]
 			]
 			+ SVerticalBox::Slot()
+			.AutoHeight()
+			[
+				SNew(SHorizontalBox)
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Left)
+				.FillWidth(0.5f)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("JSONUseTcp", "TCP Stream"))
+					.ToolTipText(LOCTEXT("JSONUseTcpTooltip", "Listens for a sender streaming length prefixed packets instead of receiving datagrams, for skeletons too large for a datagram"))
+				]
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Fill)
+				.FillWidth(0.5f)
+				[
+					SNew(SCheckBox)
+					.IsChecked(this, &SJSONLiveLinkSourceFactory::GetUseTcp)
+					.OnCheckStateChanged(this, &SJSONLiveLinkSourceFactory::OnUseTcpChanged)
+				]
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			[
+				SNew(SHorizontalBox)
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Left)
+				.FillWidth(0.5f)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("JSONDecodeOnReceiverThread", "Decode on Receiver"))
+					.ToolTipText(LOCTEXT("JSONDecodeOnReceiverThreadTooltip", "Decodes on the receive threads, otherwise datagrams are queued and decoded on the GameThread"))
+				]
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Fill)
+				.FillWidth(0.5f)
+				[
+					SNew(SCheckBox)
+					.IsChecked(this, &SJSONLiveLinkSourceFactory::GetDecodeOnReceiverThread)
+					.OnCheckStateChanged(this, &SJSONLiveLinkSourceFactory::OnDecodeOnReceiverThreadChanged)
+				]
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			[
+				SNew(SHorizontalBox)
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Left)
+				.FillWidth(0.5f)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("JSONWorkersPerEndpoint", "Workers per Port"))
+					.ToolTipText(LOCTEXT("JSONWorkersPerEndpointTooltip", "Receive threads sharing each port, senders are spread across them (Linux only)"))
+				]
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Fill)
+				.FillWidth(0.5f)
+				[
+					SNew(SSpinBox<int32>)
+					.MinValue(1)
+					.MaxValue(64)
+					.Value(this, &SJSONLiveLinkSourceFactory::GetWorkersPerEndpoint)
+					.OnValueChanged(this, &SJSONLiveLinkSourceFactory::OnWorkersPerEndpointChanged)
+				]
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			[
+				SNew(SHorizontalBox)
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Left)
+				.FillWidth(0.5f)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("JSONThreadPriority", "Thread Priority"))
+					.ToolTipText(LOCTEXT("JSONThreadPriorityTooltip", "Priority of the receive and decode threads"))
+				]
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Fill)
+				.FillWidth(0.5f)
+				[
+					SNew(SComboBox<TSharedPtr<FString>>)
+					.OptionsSource(&PriorityOptions)
+					.InitiallySelectedItem(SelectedPriority)
+					.OnGenerateWidget(this, &SJSONLiveLinkSourceFactory::MakePriorityWidget)
+					.OnSelectionChanged(this, &SJSONLiveLinkSourceFactory::OnPriorityChanged)
+					[
+						SNew(STextBlock)
+						.Text(this, &SJSONLiveLinkSourceFactory::GetSelectedPriority)
+					]
+				]
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			[
+				SNew(SHorizontalBox)
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Left)
+				.FillWidth(0.5f)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("JSONThreadAffinity", "Thread Affinity"))
+					.ToolTipText(LOCTEXT("JSONThreadAffinityTooltip", "Mask of the cores the receive and decode threads may run on, e.g. 0x4 for the third core. Empty for the default."))
+				]
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Fill)
+				.FillWidth(0.5f)
+				[
+					SNew(SEditableTextBox)
+					.Text(this, &SJSONLiveLinkSourceFactory::GetAffinityMask)
+					.OnTextChanged(this, &SJSONLiveLinkSourceFactory::OnAffinityMaskChanged)
+				]
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			[
+				SNew(SHorizontalBox)
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Left)
+				.FillWidth(0.5f)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("JSONSocketReceiveBuffer", "Socket Buffer (KB)"))
+					.ToolTipText(LOCTEXT("JSONSocketReceiveBufferTooltip", "Kernel receive buffer of each socket, large enough to hold a burst of datagrams"))
+				]
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Fill)
+				.FillWidth(0.5f)
+				[
+					SNew(SSpinBox<int32>)
+					.MinValue(64)
+					.MaxValue(256 * 1024)
+					.Value(this, &SJSONLiveLinkSourceFactory::GetSocketReceiveBufferKB)
+					.OnValueChanged(this, &SJSONLiveLinkSourceFactory::OnSocketReceiveBufferKBChanged)
+				]
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			[
+				SNew(SHorizontalBox)
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Left)
+				.FillWidth(0.5f)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("JSONAllowedSubjects", "Subjects"))
+					.ToolTipText(LOCTEXT("JSONAllowedSubjectsTooltip", "Comma separated subjects to decode, the others are skipped without being parsed. Leave empty for all"))
+				]
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Fill)
+				.FillWidth(0.5f)
+				[
+					SNew(SEditableTextBox)
+					.Text(this, &SJSONLiveLinkSourceFactory::GetAllowedSubjects)
+					.OnTextChanged(this, &SJSONLiveLinkSourceFactory::OnAllowedSubjectsChanged)
+				]
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			[
+				SNew(SHorizontalBox)
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Left)
+				.FillWidth(0.5f)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("JSONAllowedBones", "Bones"))
+					.ToolTipText(LOCTEXT("JSONAllowedBonesTooltip", "Comma separated bones to push, leave empty for all"))
+				]
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Fill)
+				.FillWidth(0.5f)
+				[
+					SNew(SEditableTextBox)
+					.Text(this, &SJSONLiveLinkSourceFactory::GetAllowedBones)
+					.OnTextChanged(this, &SJSONLiveLinkSourceFactory::OnAllowedBonesChanged)
+				]
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			[
+				SNew(SHorizontalBox)
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Left)
+				.FillWidth(0.5f)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("JSONAllowedParameters", "Parameters"))
+					.ToolTipText(LOCTEXT("JSONAllowedParametersTooltip", "Comma separated parameters to push, leave empty for all"))
+				]
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Fill)
+				.FillWidth(0.5f)
+				[
+					SNew(SEditableTextBox)
+					.Text(this, &SJSONLiveLinkSourceFactory::GetAllowedParameters)
+					.OnTextChanged(this, &SJSONLiveLinkSourceFactory::OnAllowedParametersChanged)
+				]
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			[
+				SNew(SHorizontalBox)
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Left)
+				.FillWidth(0.5f)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("JSONCaptureFile", "Capture File"))
+					.ToolTipText(LOCTEXT("JSONCaptureFileTooltip", "Records every received datagram to this file, leave empty to not record"))
+				]
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Fill)
+				.FillWidth(0.5f)
+				[
+					SNew(SEditableTextBox)
+					.Text(this, &SJSONLiveLinkSourceFactory::GetCaptureFilename)
+					.OnTextChanged(this, &SJSONLiveLinkSourceFactory::OnCaptureFilenameChanged)
+				]
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			[
+				SNew(SHorizontalBox)
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Left)
+				.FillWidth(0.5f)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("JSONReplayFile", "Replay File"))
+					.ToolTipText(LOCTEXT("JSONReplayFileTooltip", "Plays back a capture file instead of receiving on the endpoints"))
+				]
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Fill)
+				.FillWidth(0.5f)
+				[
+					SNew(SEditableTextBox)
+					.Text(this, &SJSONLiveLinkSourceFactory::GetReplayFilename)
+					.OnTextChanged(this, &SJSONLiveLinkSourceFactory::OnReplayFilenameChanged)
+				]
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			[
+				SNew(SHorizontalBox)
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Left)
+				.FillWidth(0.5f)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("JSONReplayAsFastAsPossible", "Replay As Fast As Possible"))
+					.ToolTipText(LOCTEXT("JSONReplayAsFastAsPossibleTooltip", "Ignores the captured timing and replays as fast as the datagrams decode"))
+				]
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Fill)
+				.FillWidth(0.5f)
+				[
+					SNew(SCheckBox)
+					.IsChecked(this, &SJSONLiveLinkSourceFactory::GetReplayAsFastAsPossible)
+					.OnCheckStateChanged(this, &SJSONLiveLinkSourceFactory::OnReplayAsFastAsPossibleChanged)
+				]
+			]
+			+ SVerticalBox::Slot()
 			.HAlign(HAlign_Right)
 			.AutoHeight()
 			[
@@ -64,9 +375,11 @@ void SJSONLiveLinkSourceFactory::OnEndpointChanged(const FText& NewValue, ETextC
 	TSharedPtr<SEditableTextBox> EditabledTextPin = EditabledText.Pin();
 	if (EditabledTextPin.IsValid())
 	{
-		FIPv4Endpoint Endpoint;
-		if (!FIPv4Endpoint::Parse(NewValue.ToString(), Endpoint))
+		TArray<FIPv4Endpoint> Endpoints;
+		FJSONLiveLinkSourceSettings Settings;
+		if (!FJSONLiveLinkSource::ParseConnectionString(NewValue.ToString(), Endpoints, Settings))
 		{
+			FIPv4Endpoint Endpoint;
 			Endpoint.Address = FIPv4Address::Any;
 			Endpoint.Port = 54321;
 			EditabledTextPin->SetText(FText::FromString(Endpoint.ToString()));
@@ -74,15 +387,105 @@ void SJSONLiveLinkSourceFactory::OnEndpointChanged(const FText& NewValue, ETextC
 	}
 }
 
+TSharedRef<SWidget> SJSONLiveLinkSourceFactory::MakeSourceWidget(TSharedPtr<FString> Source) const
+{
+	return SNew(STextBlock).Text(FText::FromString(*Source));
+}
+
+void SJSONLiveLinkSourceFactory::OnSourceChanged(TSharedPtr<FString> NewValue, ESelectInfo::Type)
+{
+	SelectedSource = NewValue;
+
+	// Start from what the source receives with, so only what's edited changes
+	FJSONLiveLinkSource* Source = FindSelectedSource();
+	TSharedPtr<SEditableTextBox> EditabledTextPin = EditabledText.Pin();
+	if (Source != nullptr && EditabledTextPin.IsValid())
+	{
+		EditabledTextPin->SetText(FText::FromString(*SelectedSource));
+		LoadSettings(Source->GetSettings());
+	}
+}
+
+FJSONLiveLinkSource* SJSONLiveLinkSourceFactory::FindSelectedSource() const
+{
+	if (!SelectedSource.IsValid() || SelectedSource == SourceOptions[0])
+	{
+		return nullptr;
+	}
+
+	TArray<FJSONLiveLinkSource*> LiveSources;
+	FJSONLiveLinkSource::GetLiveSources(LiveSources);
+	FJSONLiveLinkSource** Source = LiveSources.FindByPredicate([this](FJSONLiveLinkSource* LiveSource) { return LiveSource->GetConnectionString() == *SelectedSource; });
+	return Source != nullptr ? *Source : nullptr;
+}
+
+void SJSONLiveLinkSourceFactory::LoadSettings(const FJSONLiveLinkSourceSettings& Settings)
+{
+	bUseTcp = Settings.Transport == EJSONLiveLinkTransport::Tcp;
+	bDecodeOnReceiverThread = Settings.bDecodeOnReceiverThread;
+	WorkersPerEndpoint = Settings.WorkersPerEndpoint;
+	CaptureFilename = Settings.CaptureFilename;
+	ReplayFilename = Settings.ReplayFilename;
+	bReplayAsFastAsPossible = Settings.bReplayAsFastAsPossible;
+	AllowedSubjects = FJSONLiveLinkSource::JoinNameList(Settings.AllowedSubjects);
+	AllowedBones = FJSONLiveLinkSource::JoinNameList(Settings.AllowedBones);
+	AllowedParameters = FJSONLiveLinkSource::JoinNameList(Settings.AllowedParameters);
+	AffinityMask = Settings.ThreadAffinityMask != 0 ? FString::Printf(TEXT("0x%llx"), Settings.ThreadAffinityMask) : FString();
+	SocketReceiveBufferKB = Settings.SocketReceiveBufferSize / 1024;
+
+	const FString PriorityName = FJSONLiveLinkSource::GetThreadPriorityName(Settings.ThreadPriority);
+	const TSharedPtr<FString>* Priority = PriorityOptions.FindByPredicate([&PriorityName](const TSharedPtr<FString>& Option) { return *Option == PriorityName; });
+	SelectedPriority = Priority != nullptr ? *Priority : PriorityOptions[0];
+}
+
+TSharedRef<SWidget> SJSONLiveLinkSourceFactory::MakePriorityWidget(TSharedPtr<FString> Priority) const
+{
+	return SNew(STextBlock).Text(FText::FromString(*Priority));
+}
+
 FReply SJSONLiveLinkSourceFactory::OnOkClicked()
 {
 	TSharedPtr<SEditableTextBox> EditabledTextPin = EditabledText.Pin();
 	if (EditabledTextPin.IsValid())
 	{
-		FIPv4Endpoint Endpoint;
-		if (FIPv4Endpoint::Parse(EditabledTextPin->GetText().ToString(), Endpoint))
+		// A reconfigured source keeps what the panel doesn't show
+		FJSONLiveLinkSource* Source = FindSelectedSource();
+		if (Source == nullptr && SelectedSource != SourceOptions[0])
 		{
-			OkClicked.ExecuteIfBound(Endpoint);
+			UE_LOG(LogJSONLiveLink, Warning, TEXT("%s is no longer running, not reconfiguring it"), **SelectedSource);
+			return FReply::Handled();
+		}
+
+		TArray<FIPv4Endpoint> Endpoints;
+		FJSONLiveLinkSourceSettings Settings = Source != nullptr ? Source->GetSettings() : FJSONLiveLinkSourceSettings();
+		// A replay doesn't need any endpoint
+		if (FJSONLiveLinkSource::ParseConnectionString(EditabledTextPin->GetText().ToString(), Endpoints, Settings) || !ReplayFilename.IsEmpty())
+		{
+			Settings.Transport = bUseTcp ? EJSONLiveLinkTransport::Tcp : EJSONLiveLinkTransport::Udp;
+			Settings.bDecodeOnReceiverThread = bDecodeOnReceiverThread;
+			Settings.WorkersPerEndpoint = WorkersPerEndpoint;
+			Settings.CaptureFilename = CaptureFilename;
+			Settings.ReplayFilename = ReplayFilename;
+			Settings.bReplayAsFastAsPossible = bReplayAsFastAsPossible;
+			FJSONLiveLinkSource::ParseNameList(AllowedSubjects, Settings.AllowedSubjects);
+			FJSONLiveLinkSource::ParseNameList(AllowedBones, Settings.AllowedBones);
+			FJSONLiveLinkSource::ParseNameList(AllowedParameters, Settings.AllowedParameters);
+			FJSONLiveLinkSource::ParseThreadPriority(*SelectedPriority, Settings.ThreadPriority);
+			Settings.ThreadAffinityMask = FCString::Strtoui64(*AffinityMask, nullptr, 0);
+			Settings.SocketReceiveBufferSize = SocketReceiveBufferKB * 1024;
+
+			if (Source != nullptr)
+			{
+				// Nothing is created for LiveLink to close the panel after, so it's closed here
+				if (Source->Reconfigure(Endpoints, Settings))
+				{
+					FSlateApplication::Get().DismissAllMenus();
+				}
+			}
+			else
+			{
+				OkClicked.ExecuteIfBound(FJSONLiveLinkSource::MakeConnectionString(Endpoints, Settings));
+			}
 		}
 	}
 	return FReply::Handled();
@@ -4,15 +4,18 @@
 
 #include "Widgets/SCompoundWidget.h"
 #include "Input/Reply.h"
+#include "Styling/SlateTypes.h"
 #include "Types/SlateEnums.h"
 #include "Widgets/DeclarativeSyntaxSupport.h"
 
+class FJSONLiveLinkSource;
 class SEditableTextBox;
 
 class SJSONLiveLinkSourceFactory : public SCompoundWidget
 {
 public:
-	DECLARE_DELEGATE_OneParam(FOnOkClicked, FIPv4Endpoint);
+	// Passes the connection string, see FJSONLiveLinkSource::ParseConnectionString
+	DECLARE_DELEGATE_OneParam(FOnOkClicked, const FString&);
 
 	SLATE_BEGIN_ARGS(SJSONLiveLinkSourceFactory){}
 		SLATE_EVENT(FOnOkClicked, OnOkClicked)
@@ -24,8 +27,68 @@ private:
 
 	void OnEndpointChanged(const FText& NewValue, ETextCommit::Type);
 
+	// The first option creates a source, the others reconfigure the running source of that connection string
+	TSharedRef<SWidget> MakeSourceWidget(TSharedPtr<FString> Source) const;
+	void OnSourceChanged(TSharedPtr<FString> NewValue, ESelectInfo::Type);
+	FText GetSelectedSource() const { return FText::FromString(*SelectedSource); }
+
+	// Running source of the selected option, null for a new source or once it's gone or been reconfigured elsewhere
+	FJSONLiveLinkSource* FindSelectedSource() const;
+
+	// Fills the fields below the endpoints in from the settings
+	void LoadSettings(const FJSONLiveLinkSourceSettings& Settings);
+
+	ECheckBoxState GetUseTcp() const { return bUseTcp ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; }
+	void OnUseTcpChanged(ECheckBoxState NewState) { bUseTcp = NewState == ECheckBoxState::Checked; }
+
+	int32 GetWorkersPerEndpoint() const { return WorkersPerEndpoint; }
+	void OnWorkersPerEndpointChanged(int32 NewValue) { WorkersPerEndpoint = NewValue; }
+
+	ECheckBoxState GetDecodeOnReceiverThread() const { return bDecodeOnReceiverThread ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; }
+	void OnDecodeOnReceiverThreadChanged(ECheckBoxState NewState) { bDecodeOnReceiverThread = NewState == ECheckBoxState::Checked; }
+
+	FText GetCaptureFilename() const { return FText::FromString(CaptureFilename); }
+	void OnCaptureFilenameChanged(const FText& NewValue) { CaptureFilename = NewValue.ToString().TrimStartAndEnd(); }
+	FText GetReplayFilename() const { return FText::FromString(ReplayFilename); }
+	void OnReplayFilenameChanged(const FText& NewValue) { ReplayFilename = NewValue.ToString().TrimStartAndEnd(); }
+
+	ECheckBoxState GetReplayAsFastAsPossible() const { return bReplayAsFastAsPossible ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; }
+	void OnReplayAsFastAsPossibleChanged(ECheckBoxState NewState) { bReplayAsFastAsPossible = NewState == ECheckBoxState::Checked; }
+
+	TSharedRef<SWidget> MakePriorityWidget(TSharedPtr<FString> Priority) const;
+	void OnPriorityChanged(TSharedPtr<FString> NewValue, ESelectInfo::Type) { SelectedPriority = NewValue; }
+	FText GetSelectedPriority() const { return FText::FromString(*SelectedPriority); }
+
+	FText GetAllowedSubjects() const { return FText::FromString(AllowedSubjects); }
+	void OnAllowedSubjectsChanged(const FText& NewValue) { AllowedSubjects = NewValue.ToString(); }
+	FText GetAllowedBones() const { return FText::FromString(AllowedBones); }
+	void OnAllowedBonesChanged(const FText& NewValue) { AllowedBones = NewValue.ToString(); }
+	FText GetAllowedParameters() const { return FText::FromString(AllowedParameters); }
+	void OnAllowedParametersChanged(const FText& NewValue) { AllowedParameters = NewValue.ToString(); }
+
+	FText GetAffinityMask() const { return FText::FromString(AffinityMask); }
+	void OnAffinityMaskChanged(const FText& NewValue) { AffinityMask = NewValue.ToString().TrimStartAndEnd(); }
+
+	int32 GetSocketReceiveBufferKB() const { return SocketReceiveBufferKB; }
+	void OnSocketReceiveBufferKBChanged(int32 NewValue) { SocketReceiveBufferKB = NewValue; }
+
 	FReply OnOkClicked();
 
 	TWeakPtr<SEditableTextBox> EditabledText;
+	TArray<TSharedPtr<FString>> SourceOptions;
+	TSharedPtr<FString> SelectedSource;
+	bool bUseTcp;
+	bool bDecodeOnReceiverThread;
+	int32 WorkersPerEndpoint;
+	FString CaptureFilename;
+	FString ReplayFilename;
+	bool bReplayAsFastAsPossible;
+	FString AllowedSubjects;
+	FString AllowedBones;
+	FString AllowedParameters;
+	TArray<TSharedPtr<FString>> PriorityOptions;
+	TSharedPtr<FString> SelectedPriority;
+	FString AffinityMask;
+	int32 SocketReceiveBufferKB;
 	FOnOkClicked OkClicked;
 };
\ No newline at end of file
@@ -0,0 +1,274 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#include "JSONLiveLinkDecoder.h"
+#include "JSONLiveLinkEncoder.h"
+#include "JSONLiveLinkJsonReader.h"
+
+#include "LiveLinkTypes.h"
+#include "Roles/LiveLinkAnimationTypes.h"
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace JSONLiveLinkDecoderTest
+{
+	static FJSONLiveLinkEncoder MakeEncoder(const TCHAR* SubjectName = TEXT("Subject"))
+	{
+		return FJSONLiveLinkEncoder(SubjectName, 1, { TEXT("root"), TEXT("head") }, { -1, 0 }, {});
+	}
+
+	// Decodes the first subject of a JSON packet
+	static bool DecodeJson(FJSONLiveLinkDecoder& Decoder, const TArray<uint8>& Packet, FLiveLinkAnimationFrameData& OutFrameData, uint32& OutSchemaHash)
+	{
+		FJSONLiveLinkJsonReader Reader(Packet.GetData(), Packet.Num());
+		FJSONLiveLinkStringView SubjectKey;
+		return Reader.ReadObjectStart() && Reader.NextMember(SubjectKey) && Decoder.DecodeSubject(Reader, Decoder.FindSubjectName(SubjectKey), OutFrameData, OutSchemaHash);
+	}
+
+	static void MakeJsonPacket(FJSONLiveLinkEncoder& Encoder, const TArray<FTransform>& Transforms, const TArray<float>& ParameterValues, TArray<uint8>& OutPacket)
+	{
+		FJSONLiveLinkEncoder::BeginJsonPacket(OutPacket);
+		Encoder.AppendJsonSubject(OutPacket, Transforms, ParameterValues, FJSONLiveLinkEncoderTiming());
+		FJSONLiveLinkEncoder::EndJsonPacket(OutPacket);
+	}
+
+	static TArray<uint8> ToPacket(const ANSICHAR* Json)
+	{
+		return TArray<uint8>((const uint8*)Json, FCStringAnsi::Strlen(Json));
+	}
+
+	static EJSONLiveLinkBinaryResult Decode(FJSONLiveLinkDecoder& Decoder, const TArray<uint8>& Packet, const FIPv4Endpoint& Sender = FIPv4Endpoint::Any)
+	{
+		FName SubjectName;
+		return Decode(Decoder, Packet, Sender, SubjectName);
+	}
+
+	static EJSONLiveLinkBinaryResult Decode(FJSONLiveLinkDecoder& Decoder, const TArray<uint8>& Packet, const FIPv4Endpoint& Sender, FName& OutSubjectName)
+	{
+		uint32 SchemaHash;
+		FLiveLinkAnimationFrameData FrameData;
+		return Decoder.DecodeBinary(Packet.GetData(), Packet.Num(), Sender, OutSubjectName, FrameData, SchemaHash);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJSONLiveLinkDecoderRestartTest, "JSONLiveLink.Decoder.SenderRestart", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FJSONLiveLinkDecoderRestartTest::RunTest(const FString& Parameters)
+{
+	using namespace JSONLiveLinkDecoderTest;
+
+	FJSONLiveLinkDecoder Decoder;
+	TArray<uint8> Packet;
+	TArray<FTransform> Transforms = { FTransform::Identity, FTransform::Identity };
+	const TArray<float> ParameterValues;
+	const FJSONLiveLinkEncoderTiming Timing;
+
+	// Far enough into the stream that starting over can't be mistaken for late packets
+	FJSONLiveLinkEncoder Sender = MakeEncoder();
+	Sender.WriteSchema(Packet);
+	TestEqual(TEXT("Schema"), Decode(Decoder, Packet), EJSONLiveLinkBinaryResult::NoFrame);
+	for (int32 FrameIdx = 0; FrameIdx < 2000; ++FrameIdx)
+	{
+		Transforms[1].SetTranslation(FVector(FrameIdx, 0.0f, 0.0f));
+		Sender.WriteDelta(Packet, Transforms, ParameterValues, Timing);
+		if (!TestEqual(TEXT("Stream before the restart"), Decode(Decoder, Packet), EJSONLiveLinkBinaryResult::Frame))
+		{
+			return false;
+		}
+	}
+
+	// A late delta of the same stream is still rejected
+	TArray<uint8> LateDelta = Packet;
+	Sender.WriteDelta(Packet, Transforms, ParameterValues, Timing);
+	Decode(Decoder, Packet);
+	TestEqual(TEXT("Late delta"), Decode(Decoder, LateDelta), EJSONLiveLinkBinaryResult::OutOfOrder);
+
+	// The restarted sender sends the same schema bytes and counts from the start again
+	FJSONLiveLinkEncoder RestartedSender = MakeEncoder();
+	RestartedSender.WriteSchema(Packet);
+	TestEqual(TEXT("Repeated schema"), Decode(Decoder, Packet), EJSONLiveLinkBinaryResult::NoFrame);
+	RestartedSender.WriteDelta(Packet, Transforms, ParameterValues, Timing);
+	TestEqual(TEXT("Keyframe after the restart"), Decode(Decoder, Packet), EJSONLiveLinkBinaryResult::Frame);
+	for (int32 FrameIdx = 0; FrameIdx < 10; ++FrameIdx)
+	{
+		Transforms[1].SetTranslation(FVector(0.0f, FrameIdx, 0.0f));
+		RestartedSender.WriteDelta(Packet, Transforms, ParameterValues, Timing);
+		TestEqual(TEXT("Delta after the restart"), Decode(Decoder, Packet), EJSONLiveLinkBinaryResult::Frame);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJSONLiveLinkDecoderSendersTest, "JSONLiveLink.Decoder.SubjectIdPerSender", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FJSONLiveLinkDecoderSendersTest::RunTest(const FString& Parameters)
+{
+	using namespace JSONLiveLinkDecoderTest;
+
+	FJSONLiveLinkDecoder Decoder;
+	TArray<uint8> Packet;
+	const TArray<FTransform> Transforms = { FTransform::Identity, FTransform::Identity };
+	const TArray<float> ParameterValues;
+	const FJSONLiveLinkEncoderTiming Timing;
+
+	// Both senders number their only subject 1
+	const FIPv4Endpoint SenderA(FIPv4Address(10, 0, 0, 1), 54321);
+	const FIPv4Endpoint SenderB(FIPv4Address(10, 0, 0, 2), 54321);
+	FJSONLiveLinkEncoder EncoderA = MakeEncoder(TEXT("A"));
+	FJSONLiveLinkEncoder EncoderB = MakeEncoder(TEXT("B"));
+	EncoderA.WriteSchema(Packet);
+	TestEqual(TEXT("Schema of A"), Decode(Decoder, Packet, SenderA), EJSONLiveLinkBinaryResult::NoFrame);
+	EncoderB.WriteSchema(Packet);
+	TestEqual(TEXT("Schema of B"), Decode(Decoder, Packet, SenderB), EJSONLiveLinkBinaryResult::NoFrame);
+
+	FName SubjectName;
+	EncoderA.WriteFrame(Packet, Transforms, ParameterValues, Timing);
+	TestEqual(TEXT("Frame of A"), Decode(Decoder, Packet, SenderA, SubjectName), EJSONLiveLinkBinaryResult::Frame);
+	TestTrue(TEXT("Frame of A's subject"), SubjectName == FName(TEXT("A")));
+	TestNotEqual(TEXT("Coalesce keys of A and B"), FJSONLiveLinkDecoder::GetCoalesceKey(Packet.GetData(), Packet.Num(), SenderA), FJSONLiveLinkDecoder::GetCoalesceKey(Packet.GetData(), Packet.Num(), SenderB));
+
+	EncoderB.WriteFrame(Packet, Transforms, ParameterValues, Timing);
+	TestEqual(TEXT("Frame of B"), Decode(Decoder, Packet, SenderB, SubjectName), EJSONLiveLinkBinaryResult::Frame);
+	TestTrue(TEXT("Frame of B's subject"), SubjectName == FName(TEXT("B")));
+
+	// A third sender's frames have no schema to be decoded against
+	const FIPv4Endpoint SenderC(FIPv4Address(10, 0, 0, 3), 54321);
+	TestEqual(TEXT("Frame without a schema"), Decode(Decoder, Packet, SenderC), EJSONLiveLinkBinaryResult::Invalid);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJSONLiveLinkDecoderLayoutTest, "JSONLiveLink.Decoder.CompiledLayoutFallback", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FJSONLiveLinkDecoderLayoutTest::RunTest(const FString& Parameters)
+{
+	using namespace JSONLiveLinkDecoderTest;
+
+	FJSONLiveLinkDecoder Decoder;
+	TArray<uint8> Packet;
+	FLiveLinkAnimationFrameData FrameData;
+	const TArray<float> ParameterValues;
+
+	// The second packet of the same layout is decoded positionally
+	FJSONLiveLinkEncoder TwoBones = MakeEncoder();
+	TArray<FTransform> Transforms = { FTransform::Identity, FTransform::Identity };
+	uint32 TwoBonesHash = 0;
+	for (int32 FrameIdx = 1; FrameIdx <= 2; ++FrameIdx)
+	{
+		Transforms[1].SetTranslation(FVector(FrameIdx, 0.0f, 0.0f));
+		MakeJsonPacket(TwoBones, Transforms, ParameterValues, Packet);
+		if (!TestTrue(TEXT("Two bones decoded"), DecodeJson(Decoder, Packet, FrameData, TwoBonesHash)))
+		{
+			return false;
+		}
+		TestEqual(TEXT("Two bones pushed"), FrameData.Transforms.Num(), 2);
+		TestEqual(TEXT("Two bones value"), FrameData.Transforms[1].GetTranslation().X, (float)FrameIdx);
+	}
+
+	// The subject's schema changes under the compiled layout, the packet is decoded again the slow way and relearned
+	FJSONLiveLinkEncoder ThreeBones(TEXT("Subject"), 1, { TEXT("root"), TEXT("head"), TEXT("jaw") }, { -1, 0, 1 }, {});
+	Transforms.Add(FTransform(FVector(0.0f, 0.0f, 3.0f)));
+	uint32 ThreeBonesHash = 0;
+	for (int32 FrameIdx = 0; FrameIdx < 2; ++FrameIdx)
+	{
+		MakeJsonPacket(ThreeBones, Transforms, ParameterValues, Packet);
+		if (!TestTrue(TEXT("Three bones decoded"), DecodeJson(Decoder, Packet, FrameData, ThreeBonesHash)))
+		{
+			return false;
+		}
+		TestNotEqual(TEXT("Schema hash changed"), ThreeBonesHash, TwoBonesHash);
+		TestEqual(TEXT("Three bones static data"), Decoder.GetStaticData().BoneNames.Num(), 3);
+		TestEqual(TEXT("Three bones pushed"), FrameData.Transforms.Num(), 3);
+		TestEqual(TEXT("Three bones value"), FrameData.Transforms[2].GetTranslation().Z, 3.0f);
+	}
+
+	// Back to the first schema
+	Transforms.SetNum(2);
+	MakeJsonPacket(TwoBones, Transforms, ParameterValues, Packet);
+	uint32 SchemaHash = 0;
+	TestTrue(TEXT("Two bones again decoded"), DecodeJson(Decoder, Packet, FrameData, SchemaHash));
+	TestEqual(TEXT("Two bones again hash"), SchemaHash, TwoBonesHash);
+	TestEqual(TEXT("Two bones again pushed"), FrameData.Transforms.Num(), 2);
+
+	// Same schema with its members in another order
+	Packet = ToPacket("{\"Subject\":{\"Bone\":[{\"Location\":[5,0,0],\"Name\":\"root\",\"Parent\":-1,\"Rotation\":[0,0,0,1],\"Scale\":[1,1,1]},"
+		"{\"Scale\":[1,1,1],\"Rotation\":[0,0,0,1],\"Location\":[6,0,0],\"Parent\":0,\"Name\":\"head\"}]}}");
+	TestTrue(TEXT("Reordered decoded"), DecodeJson(Decoder, Packet, FrameData, SchemaHash));
+	TestEqual(TEXT("Reordered hash"), SchemaHash, TwoBonesHash);
+	TestEqual(TEXT("Reordered root"), FrameData.Transforms[0].GetTranslation().X, 5.0f);
+	TestEqual(TEXT("Reordered head"), FrameData.Transforms[1].GetTranslation().X, 6.0f);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJSONLiveLinkDecoderMaskTest, "JSONLiveLink.Decoder.Masks", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FJSONLiveLinkDecoderMaskTest::RunTest(const FString& Parameters)
+{
+	using namespace JSONLiveLinkDecoderTest;
+
+	FJSONLiveLinkEncoder Encoder(TEXT("Subject"), 1, { TEXT("root"), TEXT("head"), TEXT("jaw") }, { -1, 0, 1 }, { TEXT("p0"), TEXT("p1") });
+	const TArray<FTransform> Transforms = { FTransform(FVector(1.0f, 0.0f, 0.0f)), FTransform(FVector(2.0f, 0.0f, 0.0f)), FTransform(FVector(3.0f, 0.0f, 0.0f)) };
+	const TArray<float> ParameterValues = { 0.25f, 0.5f };
+
+	// The head bone is masked, the jaw is reparented to the root
+	auto TestMasked = [this](const TCHAR* What, const FLiveLinkSkeletonStaticData& StaticData, const FLiveLinkAnimationFrameData& FrameData)
+	{
+		if (!TestEqual(FString::Printf(TEXT("%s bones"), What), StaticData.BoneNames.Num(), 2)
+			|| !TestEqual(FString::Printf(TEXT("%s transforms"), What), FrameData.Transforms.Num(), 2))
+		{
+			return;
+		}
+		TestTrue(FString::Printf(TEXT("%s kept bone"), What), StaticData.BoneNames[1] == FName(TEXT("jaw")));
+		TestEqual(FString::Printf(TEXT("%s reparented"), What), StaticData.BoneParents[1], 0);
+		TestEqual(FString::Printf(TEXT("%s kept bone value"), What), FrameData.Transforms[1].GetTranslation().X, 3.0f);
+
+		// p1 followed by the derived head rotation
+		TestEqual(FString::Printf(TEXT("%s values"), What), FrameData.PropertyValues.Num(), StaticData.PropertyNames.Num());
+		if (TestTrue(FString::Printf(TEXT("%s parameters"), What), StaticData.PropertyNames.Num() > 0 && FrameData.PropertyValues.Num() > 0))
+		{
+			TestTrue(FString::Printf(TEXT("%s kept parameter"), What), StaticData.PropertyNames[0] == FName(TEXT("p1")));
+			TestEqual(FString::Printf(TEXT("%s kept parameter value"), What), FrameData.PropertyValues[0], 0.5f);
+		}
+		TestFalse(FString::Printf(TEXT("%s masked parameter"), What), StaticData.PropertyNames.Contains(FName(TEXT("p0"))));
+	};
+
+	FJSONLiveLinkDecoder Decoder;
+	TArray<uint8> Packet;
+	FLiveLinkAnimationFrameData FrameData;
+	uint32 UnmaskedHash = 0;
+	MakeJsonPacket(Encoder, Transforms, ParameterValues, Packet);
+	TestTrue(TEXT("Unmasked decoded"), DecodeJson(Decoder, Packet, FrameData, UnmaskedHash));
+	TestEqual(TEXT("Unmasked transforms"), FrameData.Transforms.Num(), 3);
+
+	// Changing the filter rebuilds the masks, both for the compiled layout and from the first packet of a subject
+	Decoder.SetFilter({}, { TEXT("root"), TEXT("jaw") }, { TEXT("p1") });
+	for (int32 FrameIdx = 0; FrameIdx < 2; ++FrameIdx)
+	{
+		uint32 MaskedHash = 0;
+		MakeJsonPacket(Encoder, Transforms, ParameterValues, Packet);
+		if (TestTrue(TEXT("JSON masked decoded"), DecodeJson(Decoder, Packet, FrameData, MaskedHash)))
+		{
+			TestNotEqual(TEXT("JSON masked hash"), MaskedHash, UnmaskedHash);
+			TestMasked(TEXT("JSON"), Decoder.GetStaticData(), FrameData);
+		}
+	}
+
+	FName SubjectName;
+	uint32 SchemaHash;
+	Encoder.WriteSchema(Packet);
+	TestEqual(TEXT("Binary schema"), Decoder.DecodeBinary(Packet.GetData(), Packet.Num(), FIPv4Endpoint::Any, SubjectName, FrameData, SchemaHash), EJSONLiveLinkBinaryResult::NoFrame);
+	Encoder.WriteFrame(Packet, Transforms, ParameterValues, FJSONLiveLinkEncoderTiming());
+	if (TestEqual(TEXT("Binary masked decoded"), Decoder.DecodeBinary(Packet.GetData(), Packet.Num(), FIPv4Endpoint::Any, SubjectName, FrameData, SchemaHash), EJSONLiveLinkBinaryResult::Frame))
+	{
+		TestMasked(TEXT("Binary"), Decoder.GetStaticData(), FrameData);
+	}
+
+	// Clearing the filter pushes everything again
+	Decoder.SetFilter({}, {}, {});
+	MakeJsonPacket(Encoder, Transforms, ParameterValues, Packet);
+	TestTrue(TEXT("Unmasked again decoded"), DecodeJson(Decoder, Packet, FrameData, SchemaHash));
+	TestEqual(TEXT("Unmasked again hash"), SchemaHash, UnmaskedHash);
+	TestEqual(TEXT("Unmasked again transforms"), FrameData.Transforms.Num(), 3);
+	return true;
+}
+
+#endif
@@ -0,0 +1,62 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#include "JSONLiveLinkJsonReader.h"
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJSONLiveLinkJsonReaderNumberTest, "JSONLiveLink.JsonReader.NumberParity", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FJSONLiveLinkJsonReaderNumberTest::RunTest(const FString& Parameters)
+{
+	// Both the exact fast path and what falls back to Atod have to return the same bits Atod does
+	static const ANSICHAR* Numbers[] =
+	{
+		// Signs and zeros, negative zero keeps its sign
+		"0", "-0", "-0.0", "0e0", "-0e-5", "1", "-1",
+
+		// Short decimals and exponents
+		"0.1", "0.3", "-2.75", "1.5e3", "1E-3", "2.5e+10", "123e20", "-7e-22",
+
+		// Mantissas around 2^53 and longer than 19 digits
+		"9007199254740992", "9007199254740993", "123456789012345678", "12345678901234567890123",
+		"0.1234567890123456789012345", "3.14159265358979323846264338327950288",
+
+		// Powers of ten just inside and just outside the exact ones
+		"1e22", "1e23", "1e-22", "1e-23", "9.5e22", "1.1e-23",
+
+		// Extremes, over- and underflow
+		"4.9e-324", "2.2250738585072014e-308", "1.7976931348623157e308", "1e400", "-1e400", "1e-400",
+	};
+
+	for (const ANSICHAR* Number : Numbers)
+	{
+		const int32 Len = FCStringAnsi::Strlen(Number);
+		FJSONLiveLinkJsonReader Reader((const uint8*)Number, Len);
+		double Parsed = 0;
+		if (!TestTrue(FString::Printf(TEXT("Read %s"), ANSI_TO_TCHAR(Number)), Reader.ReadNumber(Parsed)))
+		{
+			continue;
+		}
+		TestEqual(FString::Printf(TEXT("Consumed %s"), ANSI_TO_TCHAR(Number)), Reader.GetPosition(), Len);
+
+		const double Expected = FCStringAnsi::Atod(Number);
+		if (FMemory::Memcmp(&Parsed, &Expected, sizeof(double)) != 0)
+		{
+			AddError(FString::Printf(TEXT("%s read as %.17g, Atod returns %.17g"), ANSI_TO_TCHAR(Number), Parsed, Expected));
+		}
+	}
+
+	// Not numbers in JSON
+	static const ANSICHAR* Malformed[] = { "-", ".5", "1.", "1e", "1e+", "+1" };
+	for (const ANSICHAR* Number : Malformed)
+	{
+		FJSONLiveLinkJsonReader Reader((const uint8*)Number, FCStringAnsi::Strlen(Number));
+		double Parsed = 0;
+		TestFalse(FString::Printf(TEXT("Rejected %s"), ANSI_TO_TCHAR(Number)), Reader.ReadNumber(Parsed));
+	}
+	return true;
+}
+
+#endif
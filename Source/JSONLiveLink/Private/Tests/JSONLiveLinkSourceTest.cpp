@@ -0,0 +1,58 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#include "JSONLiveLinkSource.h"
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJSONLiveLinkConnectionStringTest, "JSONLiveLink.Source.ConnectionString", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FJSONLiveLinkConnectionStringTest::RunTest(const FString& Parameters)
+{
+	const TArray<FIPv4Endpoint> Endpoints = { FIPv4Endpoint(FIPv4Address::Any, 54321) };
+
+	// Every option away from its default, so each one has to survive the round trip
+	FJSONLiveLinkSourceSettings Settings;
+	Settings.bDecodeOnReceiverThread = false;
+	Settings.ReceiveBatchSize = 32;
+	Settings.PacketRingCapacity = 256;
+	Settings.bCoalesceFrames = true;
+	Settings.BackpressurePolicy = EJSONLiveLinkBackpressurePolicy::Decimate;
+	Settings.BackpressureQueueDepth = 4;
+	Settings.BackpressureBusyThreshold = 0.75f;
+	Settings.DecimateRate = 24.0f;
+	Settings.InterpolationDelay = 0.05;
+	Settings.FrameRate = FFrameRate(30000, 1001);
+	Settings.MaxDatagramSize = 1472;
+
+	const FString ConnectionString = FJSONLiveLinkSource::MakeConnectionString(Endpoints, Settings);
+	TArray<FIPv4Endpoint> ParsedEndpoints;
+	FJSONLiveLinkSourceSettings Parsed;
+	if (!TestTrue(TEXT("Parsed"), FJSONLiveLinkSource::ParseConnectionString(ConnectionString, ParsedEndpoints, Parsed)))
+	{
+		return false;
+	}
+
+	TestEqual(TEXT("Endpoints"), ParsedEndpoints.Num(), 1);
+	TestEqual(TEXT("DecodeOn"), Parsed.bDecodeOnReceiverThread, Settings.bDecodeOnReceiverThread);
+	TestEqual(TEXT("Batch"), Parsed.ReceiveBatchSize, Settings.ReceiveBatchSize);
+	TestEqual(TEXT("Ring"), Parsed.PacketRingCapacity, Settings.PacketRingCapacity);
+	TestEqual(TEXT("Coalesce"), Parsed.bCoalesceFrames, Settings.bCoalesceFrames);
+	TestTrue(TEXT("Backpressure"), Parsed.BackpressurePolicy == Settings.BackpressurePolicy);
+	TestEqual(TEXT("QueueDepth"), Parsed.BackpressureQueueDepth, Settings.BackpressureQueueDepth);
+	TestEqual(TEXT("BusyThreshold"), Parsed.BackpressureBusyThreshold, Settings.BackpressureBusyThreshold);
+	TestEqual(TEXT("DecimateRate"), Parsed.DecimateRate, Settings.DecimateRate);
+	TestEqual(TEXT("Delay"), Parsed.InterpolationDelay, Settings.InterpolationDelay);
+	TestTrue(TEXT("FrameRate"), Parsed.FrameRate == Settings.FrameRate);
+	TestEqual(TEXT("MaxDatagram"), Parsed.MaxDatagramSize, Settings.MaxDatagramSize);
+
+	// Defaults aren't written, and what a string leaves out keeps the value it's parsed over
+	TestEqual(TEXT("Default settings"), FJSONLiveLinkSource::MakeConnectionString(Endpoints, FJSONLiveLinkSourceSettings()), Endpoints[0].ToString());
+	TestTrue(TEXT("Parsed over"), FJSONLiveLinkSource::ParseConnectionString(TEXT("0.0.0.0:54321;Batch=8"), ParsedEndpoints, Parsed));
+	TestEqual(TEXT("Option given"), Parsed.ReceiveBatchSize, 8);
+	TestEqual(TEXT("Option left out"), Parsed.PacketRingCapacity, Settings.PacketRingCapacity);
+	return true;
+}
+
+#endif
@@ -0,0 +1,107 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "JSONLiveLinkProtocol.h"
+
+class FJSONLiveLinkBinaryWriter;
+
+/** Sender timing a frame is encoded with, see JSONLiveLinkProtocol.h */
+struct FJSONLiveLinkEncoderTiming
+{
+	// Seconds on the sender's clock when the frame was captured
+	double Timestamp = 0;
+
+	// Frame number at the receiving source's frame rate
+	uint32 Frame = 0;
+
+	bool bHasTimestamp = false;
+	bool bHasFrame = false;
+};
+
+/**
+ * Reference sender side encoder of one subject, producing the JSON and binary packets FJSONLiveLinkSource decodes.
+ * Binary frame packets and JSON subjects always carry a sequence number, and the delta mode carries its own.
+ * Everything's encoded into caller owned arrays which are reused without allocating once they've grown to the largest packet.
+ */
+class JSONLIVELINK_API FJSONLiveLinkEncoder
+{
+public:
+
+	// SubjectId and SchemaId name the subject in binary packets. With parameters, the receiver derives headRoll, headPitch and
+	// headYaw from the last bone like it does for JSON subjects with a Parameter array.
+	FJSONLiveLinkEncoder(const FString& InSubjectName, uint32 InSubjectId, const TArray<FString>& InBoneNames, const TArray<int32>& InBoneParents, const TArray<FString>& InParameterNames, uint32 InSchemaId = 1);
+
+	// JSON packets are an object of subjects, appended between BeginJsonPacket and EndJsonPacket
+	static void BeginJsonPacket(TArray<uint8>& OutPacket);
+	void AppendJsonSubject(TArray<uint8>& OutPacket, const TArray<FTransform>& Transforms, const TArray<float>& ParameterValues, const FJSONLiveLinkEncoderTiming& Timing);
+	static void EndJsonPacket(TArray<uint8>& OutPacket);
+
+	// Binary schema packet, sent before the first frame and every so often so receivers that start late can decode
+	void WriteSchema(TArray<uint8>& OutPacket) const;
+
+	// Binary frame packet holding every value
+	void WriteFrame(TArray<uint8>& OutPacket, const TArray<FTransform>& Transforms, const TArray<float>& ParameterValues, const FJSONLiveLinkEncoderTiming& Timing);
+
+	// Delta mode: a keyframe for the first frame, every KeyframeInterval frames and once requested, otherwise a delta of the
+	// bones and parameters that changed since the previous frame
+	void WriteDelta(TArray<uint8>& OutPacket, const TArray<FTransform>& Transforms, const TArray<float>& ParameterValues, const FJSONLiveLinkEncoderTiming& Timing);
+
+	// Frames between keyframes in delta mode, 0 only sends them when requested
+	void SetKeyframeInterval(int32 InKeyframeInterval) { KeyframeInterval = InKeyframeInterval; }
+
+	// Makes the next delta mode frame a keyframe when the packet is a keyframe request for this subject
+	bool HandleKeyframeRequest(const uint8* Data, int32 Size);
+
+	const FString& GetSubjectName() const { return SubjectName; }
+	int32 GetNumBones() const { return BoneNames.Num(); }
+	int32 GetNumParameters() const { return ParameterNames.Num(); }
+
+private:
+
+	void WriteHeader(FJSONLiveLinkBinaryWriter& Writer, EJSONLiveLinkPacketType PacketType, EJSONLiveLinkPacketFlags Flags) const;
+	static void WriteTiming(FJSONLiveLinkBinaryWriter& Writer, const FJSONLiveLinkEncoderTiming& Timing);
+	static EJSONLiveLinkPacketFlags GetTimingFlags(const FJSONLiveLinkEncoderTiming& Timing);
+
+	// Bone and parameter counts followed by every value, shared by frames and keyframes
+	static void WriteFrameBody(FJSONLiveLinkBinaryWriter& Writer, const TArray<FTransform>& Transforms, const TArray<float>& ParameterValues);
+
+	// What the largest packet of the subject could take
+	int32 GetMaxBinaryPacketSize() const;
+
+	// Append JSON text to a packet
+	static void AppendText(TArray<uint8>& OutPacket, const ANSICHAR* Text, int32 Length);
+	static void AppendText(TArray<uint8>& OutPacket, const TArray<ANSICHAR>& Text) { AppendText(OutPacket, Text.GetData(), Text.Num()); }
+	static void AppendNumber(TArray<uint8>& OutPacket, double Value, int32 SignificantDigits = 9);
+	static void AppendNumberArray(TArray<uint8>& OutPacket, const float* Values, int32 NumValues);
+
+	FString SubjectName;
+	uint32 SubjectId;
+	uint32 SchemaId;
+
+	TArray<FString> BoneNames;
+	TArray<int32> BoneParents;
+	TArray<FString> ParameterNames;
+
+	// "Subject":{, and each bone's {"Name":...,"Parent":...,"Location": and parameter's {"Name":...,"Value": encoded once
+	TArray<ANSICHAR> JsonSubjectKey;
+	TArray<TArray<ANSICHAR>> JsonBonePrefixes;
+	TArray<TArray<ANSICHAR>> JsonParameterPrefixes;
+
+	// Sequence of the frame packets and JSON subjects, and of the keyframes and deltas
+	uint32 FrameSequence;
+	uint32 DeltaSequence;
+
+	// Values of the previous keyframe or delta, what the next delta is against
+	TArray<FTransform> LastTransforms;
+	TArray<float> LastParameterValues;
+
+	int32 KeyframeInterval;
+	int32 FramesSinceKeyframe;
+	bool bKeyframeRequested;
+
+	// Scratch for the indices of what changed
+	TArray<uint16> ChangedBones;
+	TArray<uint16> ChangedParameters;
+};
@@ -0,0 +1,121 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Wire format definitions shared by FJSONLiveLinkSource and senders.
+ *
+ * Besides JSON text, a datagram may carry a compact binary packet, recognized by its leading magic.
+ * All binary values are little-endian and packed without padding. Every packet starts with a header:
+ *
+ *   uint32 Magic       BinaryMagic
+ *   uint8  Version     BinaryVersion
+ *   uint8  PacketType  EJSONLiveLinkPacketType
+ *   uint16 Flags       EJSONLiveLinkPacketFlags
+ *   uint32 SubjectId   Sender chosen id of the subject, names are only sent in the schema packet
+ *   uint32 SchemaId    Sender chosen id of the subject's current schema, bumped whenever it changes
+ *
+ * Strings are a uint16 byte count followed by UTF-8 bytes.
+ *
+ * Frame, keyframe and delta packets may carry the sender's timing right after the header, in this order:
+ *   double Timestamp   with the Timestamp flag, seconds on the sender's clock when the frame was captured
+ *   uint32 Frame       with the Frame flag, frame number at the source's frame rate
+ *   uint32 Sequence    frame packets with the Sequence flag, increases by one per packet of the subject. Keyframes and
+ *                      deltas always have their own sequence. Frames older than the newest one received are dropped.
+ *
+ * Schema packet:
+ *   uint16 BoneCount, uint16 ParameterCount, string SubjectName,
+ *   BoneCount x { string BoneName, int32 BoneParent }, ParameterCount x { string ParameterName }
+ *
+ * Frame packet:
+ *   uint16 BoneCount, uint16 ParameterCount,
+ *   float Locations[3 * BoneCount], float Rotations[4 * BoneCount], float Scales[3 * BoneCount],
+ *   float ParameterValues[ParameterCount]
+ *
+ * Delta mode: the sender starts with a keyframe and then only sends what changed since the previous frame.
+ * Sequence numbers increase by one per keyframe or delta. When a delta is missing the receiver drops deltas until the
+ * next keyframe and sends a keyframe request back to the sender, at most every KeyframeRequestInterval seconds.
+ *
+ * Keyframe packet:
+ *   uint32 Sequence, followed by the frame packet body
+ *
+ * Delta packet:
+ *   uint32 Sequence, uint16 ChangedBoneCount, uint16 ChangedParameterCount,
+ *   uint16 ChangedBoneIndices[ChangedBoneCount], ChangedBoneCount x { float Location[3], float Rotation[4], float Scale[3] },
+ *   uint16 ChangedParameterIndices[ChangedParameterCount], float ChangedParameterValues[ChangedParameterCount]
+ *
+ * Keyframe request packet, receiver to sender:
+ *   uint32 LastSequence, the sequence of the last frame the receiver reconstructed
+ *
+ * Compressed packet, wraps a binary packet or JSON text that's decoded once decompressed:
+ *   uint32 Magic            CompressedMagic
+ *   uint8  Method           EJSONLiveLinkCompression
+ *   uint32 UncompressedSize at most MaxStreamPacketSize
+ *   uint8  Data[]           Zlib: a zlib stream, optionally deflated with a preset dictionary the source is configured with
+ *                           LZ4: a raw LZ4 block
+ *
+ * Stream transport: over TCP, where packets aren't limited to a datagram, every JSON or binary packet and keyframe request
+ * is preceded by its size:
+ *   uint32 Size        bytes of the packet that follows, at most MaxStreamPacketSize
+ */
+namespace JSONLiveLinkProtocol
+{
+	// "JLLB" in memory
+	static const uint32 BinaryMagic = 0x424C4C4A;
+
+	static const uint8 BinaryVersion = 1;
+
+	static const int32 HeaderSize = 16;
+
+	static const int32 KeyframeRequestSize = HeaderSize + 4;
+
+	static const double KeyframeRequestInterval = 0.1;
+
+	// Largest payload carried by one UDP datagram
+	static const int32 MaxDatagramSize = 65507;
+
+	// "JLLZ" in memory
+	static const uint32 CompressedMagic = 0x5A4C4C4A;
+
+	static const int32 CompressedHeaderSize = 9;
+
+	static const int32 StreamHeaderSize = 4;
+
+	// Largest packet in a stream, anything larger means the stream is corrupt
+	static const int32 MaxStreamPacketSize = 16 * 1024 * 1024;
+}
+
+enum class EJSONLiveLinkPacketType : uint8
+{
+	Schema = 1,
+	Frame = 2,
+	Keyframe = 3,
+	Delta = 4,
+	KeyframeRequest = 5,
+};
+
+enum class EJSONLiveLinkCompression : uint8
+{
+	Zlib = 1,
+	LZ4 = 2,
+};
+
+enum class EJSONLiveLinkPacketFlags : uint16
+{
+	None = 0,
+
+	// Schema: like a JSON subject with a Parameter array, append headRoll, headPitch and headYaw derived from the last bone
+	HeadRotation = 1 << 0,
+
+	// Frame, keyframe and delta: the packet carries a sender timestamp
+	Timestamp = 1 << 1,
+
+	// Frame, keyframe and delta: the packet carries a frame number
+	Frame = 1 << 2,
+
+	// Frame: the packet carries a sequence number
+	Sequence = 1 << 3,
+};
+ENUM_CLASS_FLAGS(EJSONLiveLinkPacketFlags);
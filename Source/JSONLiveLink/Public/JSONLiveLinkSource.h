@@ -3,21 +3,27 @@
 #pragma once
 
 #include "ILiveLinkSource.h"
-#include "HAL/Runnable.h"
-#include "HAL/ThreadSafeBool.h"
+#include "HAL/CriticalSection.h"
 #include "IMessageContext.h"
 #include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "JSONLiveLinkSourceSettings.h"
 
-class FRunnableThread;
-class FSocket;
+class FJSONLiveLinkCaptureWriter;
+class FJSONLiveLinkDemultiplexer;
+class FJSONLiveLinkStatusSummary;
 class ILiveLinkClient;
-class ISocketSubsystem;
+struct FLiveLinkFrameDataStruct;
+struct FLiveLinkSkeletonStaticData;
 
-class JSONLIVELINK_API FJSONLiveLinkSource : public ILiveLinkSource, public FRunnable
+class JSONLIVELINK_API FJSONLiveLinkSource : public ILiveLinkSource
 {
 public:
 
-	FJSONLiveLinkSource(FIPv4Endpoint Endpoint);
+	FJSONLiveLinkSource(FIPv4Endpoint Endpoint, const FJSONLiveLinkSourceSettings& InSettings = FJSONLiveLinkSourceSettings());
+
+	// Receives on every endpoint, each with Settings.WorkersPerEndpoint workers. Endpoints other sources already receive on
+	// with the same settings, apart from AllowedSubjects, are shared with them unless capturing.
+	FJSONLiveLinkSource(const TArray<FIPv4Endpoint>& InEndpoints, const FJSONLiveLinkSourceSettings& InSettings = FJSONLiveLinkSourceSettings());
 
 	virtual ~FJSONLiveLinkSource();
 
@@ -31,23 +37,74 @@ public:
 
 	virtual FText GetSourceType() const override { return SourceType; };
 	virtual FText GetSourceMachineName() const override { return SourceMachineName; }
-	virtual FText GetSourceStatus() const override { return SourceStatus; }
+	virtual FText GetSourceStatus() const override;
 
 	// End ILiveLinkSource Interface
 
-	// Begin FRunnable Interface
+	/**
+	 * Connection strings are a comma separated list of endpoints, optionally followed by ";Workers=N",
+	 * e.g. "0.0.0.0:54321,0.0.0.0:54322;Workers=4". Capture="File" records what's received to a file, while
+	 * Replay="File" plays one back instead of receiving, at its captured pace or with ReplayFast=true as fast as possible.
+	 * Threads are tuned with Priority=TimeCritical, Affinity=0x4 and StackSize=Bytes, sockets with RecvBuffer=Bytes and
+	 * MaxDatagram=Bytes. Transport=Tcp listens for senders streaming length prefixed packets instead of datagrams.
+	 * Dictionary="File" is the preset dictionary of zlib compressed packets. ParallelDecode=N decodes the subjects of JSON
+	 * packets with at least N of them in parallel. Subjects="A,B" only decodes those subjects, Bones="..." and
+	 * Parameters="..." only push those bones and parameters of each subject. Backpressure=None|DropOldest|Coalesce|Decimate
+	 * is what's skipped when falling behind, QueueDepth=N and BusyThreshold=Fraction when it's falling behind, and
+	 * DecimateRate=Hz the rate the decimate policy keeps. DecodeOn=GameThread decodes on the GameThread from a queue of
+	 * Ring=N datagrams, Coalesce=true only decoding the newest queued frame of each subject. Batch=N is the most datagrams
+	 * received per wakeup, Delay=Seconds holds timestamped frames back for interpolation and FrameRate=30000/1001 is the
+	 * rate of their frame numbers. Options left out keep their value in InOutSettings.
+	 * Returns false if there's neither an endpoint nor a file to replay.
+	 */
+	static bool ParseConnectionString(const FString& ConnectionString, TArray<FIPv4Endpoint>& OutEndpoints, FJSONLiveLinkSourceSettings& InOutSettings);
+	static FString MakeConnectionString(const TArray<FIPv4Endpoint>& Endpoints, const FJSONLiveLinkSourceSettings& Settings);
+
+	// Names of the thread priorities in connection strings, e.g. "AboveNormal"
+	static const TCHAR* GetThreadPriorityName(EThreadPriority Priority);
+	static bool ParseThreadPriority(const FString& Name, EThreadPriority& OutPriority);
+
+	// Names of the backpressure policies in connection strings, e.g. "DropOldest"
+	static const TCHAR* GetBackpressurePolicyName(EJSONLiveLinkBackpressurePolicy Policy);
+	static bool ParseBackpressurePolicy(const FString& Name, EJSONLiveLinkBackpressurePolicy& OutPolicy);
+
+	// Comma separated name lists, e.g. the subject and bone filters
+	static void ParseNameList(const FString& NameList, TArray<FName>& OutNames);
+	static FString JoinNameList(const TArray<FName>& Names);
+
+	/**
+	 * Switches a live source to other endpoints and settings without removing it from LiveLink: its subjects stay
+	 * registered and their static data is only pushed again where the new settings change it. Sockets and threads are
+	 * replaced, the decoders of the old workers are handed to the new ones, so learned layouts, schemas and names stay
+	 * cached across the switch. Returns false, receiving as before, if there's neither an endpoint nor a file to replay.
+	 * GameThread only.
+	 */
+	bool Reconfigure(const TArray<FIPv4Endpoint>& InEndpoints, const FJSONLiveLinkSourceSettings& InSettings);
+	bool Reconfigure(const FString& ConnectionString);
+
+	// Connection string of what the source currently receives
+	FString GetConnectionString() const;
+
+	// Everything the source currently receives with, including what connection strings don't carry
+	const FJSONLiveLinkSourceSettings& GetSettings() const { return Settings; }
+
+	// Every source that hasn't been shut down, to pick one to reconfigure. GameThread only, like their destruction.
+	static void GetLiveSources(TArray<FJSONLiveLinkSource*>& OutSources);
+
+	bool HasClient() const { return Client != nullptr; }
+
+	// Pushes a decoded frame, preceded by StaticData when the subject's schema changed. Safe to call from any worker.
+	void PushSubject(FName SubjectName, uint32 SchemaHash, const FLiveLinkSkeletonStaticData& StaticData, FLiveLinkFrameDataStruct&& FrameDataStruct);
 
-	virtual bool Init() override { return true; }
-	virtual uint32 Run() override;
-	void Start();
-	virtual void Stop() override;
-	virtual void Exit() override { }
+private:
 
-	// End FRunnable Interface
+	// Starts receiving on DeviceEndpoints with Settings, taking the caches of the joined demultiplexers being replaced
+	void StartReceiving(const TArray<TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>>& Predecessors);
 
-	void HandleReceivedData(TSharedPtr<TArray<uint8>, ESPMode::ThreadSafe> ReceivedData);
+	static TArray<FJSONLiveLinkSource*> LiveSources;
 
-private:
+	// Guards LiveSources
+	static FCriticalSection LiveSourcesCriticalSection;
 
 	ILiveLinkClient* Client;
 
@@ -60,29 +117,30 @@ private:
 	FText SourceMachineName;
 	FText SourceStatus;
 
-	FIPv4Endpoint DeviceEndpoint;
+	TArray<FIPv4Endpoint> DeviceEndpoints;
 
-	// Socket to receive data on
-	FSocket* Socket;
+	FJSONLiveLinkSourceSettings Settings;
 
-	// Subsystem associated to Socket
-	ISocketSubsystem* SocketSubsystem;
+	// Shared by every worker, outlives them
+	TUniquePtr<FJSONLiveLinkCaptureWriter> CaptureWriter;
 
-	// Threadsafe Bool for terminating the main thread loop
-	FThreadSafeBool Stopping;
+	// One for every endpoint or a single one when replaying, shared with the other sources on the endpoint when possible
+	TArray<TSharedPtr<FJSONLiveLinkDemultiplexer, ESPMode::ThreadSafe>> Demultiplexers;
 
-	// Thread to run socket operations on
-	FRunnableThread* Thread;
+	struct FSubjectState
+	{
+		// Schema hash of the static data last pushed
+		uint32 SchemaHash = 0;
 
-	// Name of the sockets thread
-	FString ThreadName;
+		uint32 NumFrames = 0;
+	};
 
-	// Time to wait between attempted receives
-	FTimespan WaitTime;
+	// Every subject we've encountered
+	TMap<FName, FSubjectState> EncounteredSubjects;
 
-	// List of subjects we've already encountered
-	TSet<FName> EncounteredSubjects;
+	// Guards EncounteredSubjects, which is touched from every worker, and orders their pushes to the client
+	mutable FCriticalSection SubjectsCriticalSection;
 
-	// Buffer to receive socket data into
-	TArray<uint8> RecvBuffer;
+	// Status with live stats, rebuilt by GetSourceStatus about once a second
+	TUniquePtr<FJSONLiveLinkStatusSummary> StatusSummary;
 };
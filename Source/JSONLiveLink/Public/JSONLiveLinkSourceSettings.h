@@ -0,0 +1,115 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformAffinity.h"
+#include "JSONLiveLinkProtocol.h"
+#include "Misc/FrameRate.h"
+
+/** How a source's endpoints are received on */
+enum class EJSONLiveLinkTransport : uint8
+{
+	// Every packet is a datagram
+	Udp,
+
+	// Each endpoint listens for a sender streaming length prefixed packets, for packets too large for a datagram
+	Tcp,
+};
+
+/** What a worker gives up once it falls behind, see FJSONLiveLinkSourceSettings::BackpressurePolicy */
+enum class EJSONLiveLinkBackpressurePolicy : uint8
+{
+	// Never degrades, packets are only dropped once the queue or socket buffer overruns
+	None,
+
+	// Skips the oldest waiting packets until half the queue threshold are left
+	DropOldest,
+
+	// Skips waiting packets when a newer one for the same subjects is behind them, like bCoalesceFrames
+	Coalesce,
+
+	// Decodes the packets of each set of subjects at no more than DecimateRate
+	Decimate,
+};
+
+/** Per-source options controlling how a FJSONLiveLinkSource receives and decodes data */
+struct JSONLIVELINK_API FJSONLiveLinkSourceSettings
+{
+	// Decode and push subjects directly from the receiver thread instead of marshalling every datagram to the GameThread
+	bool bDecodeOnReceiverThread = true;
+
+	// Most datagrams pulled from the socket per wakeup, each one has its own preallocated slot
+	int32 ReceiveBatchSize = 16;
+
+	// Datagrams buffered for the GameThread when not decoding on the receiver thread, the oldest are dropped on overrun
+	int32 PacketRingCapacity = 64;
+
+	// When the GameThread falls behind, only decode the newest queued frame of each subject and skip the older ones.
+	// JSON packets only supersede older ones carrying the same set of subjects, see FJSONLiveLinkDecoder::GetCoalesceKey.
+	bool bCoalesceFrames = false;
+
+	// What's skipped while a worker can't keep up: more than BackpressureQueueDepth packets waiting behind the one being
+	// decoded, in the queue or in the batch received off the socket, or more than BackpressureBusyThreshold of the decoding
+	// thread's time spent decoding. Schemas, keyframes and deltas are never skipped by any policy.
+	EJSONLiveLinkBackpressurePolicy BackpressurePolicy = EJSONLiveLinkBackpressurePolicy::Coalesce;
+	int32 BackpressureQueueDepth = 8;
+	float BackpressureBusyThreshold = 0.9f;
+
+	// Frames per second each set of subjects is decoded at by the decimate policy
+	float DecimateRate = 30.0f;
+
+	EJSONLiveLinkTransport Transport = EJSONLiveLinkTransport::Udp;
+
+	// JSON packets with at least this many subjects have them decoded in parallel on the task graph, pushed in packet order.
+	// Costs an extra scan over every packet to find the subjects, 0 decodes serially without one.
+	int32 ParallelDecodeThreshold = 0;
+
+	// Receive and decode threads bound to each endpoint with SO_REUSEPORT, Linux and UDP only, otherwise always one
+	int32 WorkersPerEndpoint = 1;
+
+	// Priority of the receive and decode threads
+	EThreadPriority ThreadPriority = TPri_AboveNormal;
+
+	// Cores the receive and decode threads may run on, 0 leaves them on the task graph's pool thread cores
+	uint64 ThreadAffinityMask = 0;
+
+	// Stack size of the receive and decode threads, in bytes
+	uint32 ThreadStackSize = 128 * 1024;
+
+	// Largest datagram accepted in bytes, every receive and queue slot is this big. Lowering it to what fits the network's
+	// MTU, e.g. 1472 for 1500, saves memory when running many sources. Larger datagrams are dropped.
+	// Over TCP it only limits the packets queued for the GameThread and may be raised up to MaxStreamPacketSize.
+	int32 MaxDatagramSize = JSONLiveLinkProtocol::MaxDatagramSize;
+
+	// Kernel receive buffer of each socket in bytes, holds the bursts that arrive while a thread is busy decoding
+	int32 SocketReceiveBufferSize = 1024 * 1024;
+
+	// Only these subjects are decoded and pushed, the others are skipped over without being parsed. Empty allows every subject.
+	TArray<FName> AllowedSubjects;
+
+	// Only these bones and parameters of each subject are pushed, masked ones aren't parsed where the format allows it.
+	// A kept bone's parent becomes its nearest kept ancestor. Empty keeps them all.
+	TArray<FName> AllowedBones;
+	TArray<FName> AllowedParameters;
+
+	// Preset dictionary zlib compressed packets may be deflated with, e.g. a typical packet of the sender's schema, which
+	// recovers most of the ratio small packets lose to having nothing to back reference
+	FString CompressionDictionaryFilename;
+
+	// Seconds timestamped frames are held back by, so LiveLink has frames on either side of the evaluated time to
+	// interpolate between. Should cover the delivery jitter, 0 keeps the lowest latency.
+	double InterpolationDelay = 0.0;
+
+	// Rate of the Frame numbers packets carry, the scene time of timestamped frames is expressed at this rate too
+	FFrameRate FrameRate = FFrameRate(60, 1);
+
+	// When set, every received datagram is appended to this capture file along with its arrival time
+	FString CaptureFilename;
+
+	// When set, datagrams are played back from this capture file instead of received from the endpoints
+	FString ReplayFilename;
+
+	// Replay as fast as the datagrams decode instead of at their captured pace, for throughput testing
+	bool bReplayAsFastAsPossible = false;
+};